@@ -0,0 +1,146 @@
+#include <furi.h>
+#include <stdlib.h>
+
+#include "pinball0.h"
+#include "arena.h"
+#include "load_profile.h"
+
+namespace {
+Arena* current = nullptr; // where operator new allocates, if anywhere
+
+// The ARENA_HEADER tag of an operator new allocation
+const uint32_t tag_heap = 0x50414548; // "HEAP"
+const uint32_t tag_arena = 0x4e455241; // "AREN"
+
+size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+}
+
+Arena::Arena()
+    : head(nullptr) {
+}
+
+Arena::~Arena() {
+    release();
+}
+
+void Arena::reserve(size_t capacity) {
+    furi_check(head == nullptr);
+    add_block(capacity);
+}
+
+bool Arena::add_block(size_t size) {
+    size = align_up(size);
+    ArenaBlock* block = (ArenaBlock*)malloc(align_up(sizeof(ArenaBlock)) + size);
+    if(!block) {
+        return false;
+    }
+    block->size = size;
+    block->used = 0;
+    block->next = head;
+    head = block;
+    return true;
+}
+
+void* Arena::alloc(size_t size) {
+    size = align_up(size ? size : 1);
+    if(!head || head->used + size > head->size) {
+        size_t block_size = size > ARENA_MIN_BLOCK ? size : ARENA_MIN_BLOCK;
+        if(head) {
+            FURI_LOG_W(
+                TAG,
+                "Arena full (%u of %u bytes), adding %u more",
+                (unsigned)used(),
+                (unsigned)capacity(),
+                (unsigned)block_size);
+        }
+        if(!add_block(block_size)) {
+            return nullptr;
+        }
+    }
+    void* p = (uint8_t*)head + align_up(sizeof(ArenaBlock)) + head->used;
+    head->used += size;
+    return p;
+}
+
+void Arena::release() {
+    furi_check(current != this);
+    while(head) {
+        ArenaBlock* next = head->next;
+        free(head);
+        head = next;
+    }
+}
+
+size_t Arena::used() const {
+    size_t n = 0;
+    for(const ArenaBlock* b = head; b; b = b->next) {
+        n += b->used;
+    }
+    return n;
+}
+
+size_t Arena::capacity() const {
+    size_t n = 0;
+    for(const ArenaBlock* b = head; b; b = b->next) {
+        n += b->size;
+    }
+    return n;
+}
+
+size_t Arena::blocks() const {
+    size_t n = 0;
+    for(const ArenaBlock* b = head; b; b = b->next) {
+        n++;
+    }
+    return n;
+}
+
+ArenaScope::ArenaScope(Arena& arena)
+    : prev(current) {
+    current = &arena;
+}
+
+ArenaScope::~ArenaScope() {
+    current = prev;
+}
+
+// All of the app's allocations come through here: from the current arena if
+// there is one, otherwise from the heap.
+void* operator new(size_t size) {
+    uint8_t* p = (uint8_t*)(current ? current->alloc(ARENA_HEADER + size) :
+                                      malloc(ARENA_HEADER + size));
+    furi_check(p);
+    *(uint32_t*)p = current ? tag_arena : tag_heap;
+    load_profile_count_alloc();
+    return p + ARENA_HEADER;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    if(!p) {
+        return;
+    }
+    uint8_t* block = (uint8_t*)p - ARENA_HEADER;
+    uint32_t tag = *(uint32_t*)block;
+    furi_assert(tag == tag_heap || tag == tag_arena);
+    if(tag == tag_heap) {
+        free(block);
+    }
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Bump allocator for everything a Table owns. The arena is sized once, when a
+// table is loaded, and all of the table's objects and vectors are carved from
+// it; freeing the table then returns the lot to the heap in one go, instead of
+// leaving dozens of small holes behind for the next table to fill.
+//
+// While an ArenaScope is active, operator new allocates from its arena. Deleting
+// memory that belongs to an arena does nothing: it's reclaimed by release().
+// Every allocation from operator new carries an ARENA_HEADER tag saying where
+// it came from, so delete doesn't have to search the arenas.
+// If the arena runs out, further blocks are chained on (and logged), so an
+// undersized estimate costs fragmentation, not a crash.
+
+#define ARENA_ALIGN     8
+#define ARENA_MIN_BLOCK 512 // smallest overflow block
+#define ARENA_HEADER    ARENA_ALIGN // tag before each operator new allocation
+
+class Arena {
+public:
+    Arena();
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Allocates the first block. Only valid while the arena is empty.
+    void reserve(size_t capacity);
+    void* alloc(size_t size);
+    // Frees every block; all memory from this arena becomes invalid
+    void release();
+
+    size_t used() const; // bytes handed out, including alignment padding
+    size_t capacity() const;
+    size_t blocks() const;
+
+private:
+    typedef struct ArenaBlock {
+        struct ArenaBlock* next;
+        size_t size; // usable bytes after the header
+        size_t used;
+    } ArenaBlock;
+
+    bool add_block(size_t size);
+
+    ArenaBlock* head; // the block being allocated from; older ones follow
+};
+
+// Routes operator new to 'arena' until it goes out of scope
+class ArenaScope {
+public:
+    ArenaScope(Arena& arena);
+    ~ArenaScope();
+
+private:
+    Arena* prev;
+};
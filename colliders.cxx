@@ -0,0 +1,263 @@
+#include "pinball0.h"
+#include "objects.h"
+#include "colliders.h"
+
+void Colliders::clear() {
+    segments.clear();
+    rails.clear();
+    arcs.clear();
+    portals.clear();
+    triggers.clear();
+    live.clear();
+}
+
+void Colliders::build(const std::vector<FixedObject*>& objects) {
+    clear();
+    for(size_t i = 0; i < objects.size(); i++) {
+        objects[i]->bake(*this, i);
+    }
+    sync(objects);
+    FURI_LOG_I(
+        TAG,
+        "Colliders: %d rails (%d segments), %d arcs, %d portals, %d triggers",
+        (int)rails.size(),
+        (int)segments.size(),
+        (int)arcs.size(),
+        (int)portals.size(),
+        (int)triggers.size());
+}
+
+void Colliders::sync(const std::vector<FixedObject*>& objects) {
+    live.resize(objects.size());
+    for(size_t i = 0; i < objects.size(); i++) {
+        live[i] = objects[i]->collidable();
+    }
+}
+
+void Colliders::bounds(size_t id, Vec2& lo, Vec2& hi) const {
+    if(id < arcs_begin()) {
+        const RailCollider& rail = rails[id];
+        lo = hi = segments[rail.first].a;
+        for(size_t i = rail.first; i < (size_t)rail.first + rail.count; i++) {
+            const Segment& s = segments[i];
+            lo.x = fminf(lo.x, fminf(s.a.x, s.b.x));
+            lo.y = fminf(lo.y, fminf(s.a.y, s.b.y));
+            hi.x = fmaxf(hi.x, fmaxf(s.a.x, s.b.x));
+            hi.y = fmaxf(hi.y, fmaxf(s.a.y, s.b.y));
+        }
+    } else if(id < portals_begin()) {
+        const ArcCollider& arc = arcs[id - arcs_begin()];
+        lo = arc.p - arc.r;
+        hi = arc.p + arc.r;
+    } else if(id < triggers_begin()) {
+        // Both ends of the portal share one box, so the ball is tested against
+        // portals spanning the table regardless of which end it is near
+        const PortalCollider& pc = portals[id - portals_begin()];
+        lo.x = fminf(fminf(pc.a1.x, pc.a2.x), fminf(pc.b1.x, pc.b2.x));
+        lo.y = fminf(fminf(pc.a1.y, pc.a2.y), fminf(pc.b1.y, pc.b2.y));
+        hi.x = fmaxf(fmaxf(pc.a1.x, pc.a2.x), fmaxf(pc.b1.x, pc.b2.x));
+        hi.y = fmaxf(fmaxf(pc.a1.y, pc.a2.y), fmaxf(pc.b1.y, pc.b2.y));
+    } else {
+        const TriggerCollider& t = triggers[id - triggers_begin()];
+        lo = t.p - t.r;
+        hi = t.p + t.r;
+    }
+}
+
+// Attempt to handle double_sided rails better
+bool collide_rail(const Colliders& c, const RailCollider& rail, Ball& ball) {
+    const Segment* segs = &c.segments[rail.first];
+    Vec2 ball_v = ball.p - ball.prev_p;
+    Vec2 dir;
+    Vec2 closest = segs[0].a;
+    Vec2 normal = segs[0].n;
+    Scalar min_dist2 = infinityf();
+
+    // squared distances order the same, and saturate harmlessly in fixed-point
+    // for segments that are out of reach anyway
+    for(size_t i = 0; i < rail.count; i++) {
+        Vec2 cl = Vec2_closest(segs[i].a, segs[i].b, ball.p);
+        dir = ball.p - cl;
+        Scalar dist2 = dir.mag2();
+        if(dist2 < min_dist2) {
+            min_dist2 = dist2;
+            closest = cl;
+            normal = segs[i].n;
+        }
+    }
+    dir = ball.p - closest;
+    Scalar dist = dir.mag();
+    Vec2 contact = ball.p;
+    if(dist > ball.r) {
+        // A fast ball may have passed clean through a rail during the last step.
+        // Find the earliest segment it swept into and respond at that point.
+        if(!ball.needs_sweep()) {
+            return false;
+        }
+        Scalar t_min = 2;
+        for(size_t i = 0; i < rail.count; i++) {
+            Scalar t;
+            if(Vec2_sweep_capsule(segs[i].a, segs[i].b, ball.r, ball.prev_p, ball.p, t) &&
+               t < t_min) {
+                t_min = t;
+                normal = segs[i].n;
+                contact = ball.prev_p + ball_v * t;
+                closest = Vec2_closest(segs[i].a, segs[i].b, contact);
+            }
+        }
+        if(t_min > 1.0f) {
+            return false;
+        }
+        dir = contact - closest;
+        dist = dir.mag();
+    }
+
+    if(dist <= VEC2_EPSILON) {
+        dir = normal;
+        dist = normal.mag();
+    }
+    dir = dir / dist;
+    if(ball_v.dot(normal) < 0) {
+        // moving towards
+        ball.p = contact + dir * (ball.r - dist);
+    } else {
+        // moving away - don't alter our v / prev_p!
+        return false;
+    }
+
+    Scalar v = ball_v.dot(dir);
+    Scalar v_new = fabs(v) * rail.bounce;
+    ball_v += dir * (v_new - v);
+    ball.prev_p = ball.p - ball_v;
+    return true;
+}
+
+// Is direction v (y up) within the arc's sector?
+static bool arc_contains(const ArcCollider& arc, const Vec2& v) {
+    switch(arc.sector) {
+    case ArcSectorFull:
+        return true;
+    case ArcSectorMinor:
+        return arc.start.cross(v) >= 0 && v.cross(arc.end) >= 0;
+    case ArcSectorMajor:
+        // outside only if strictly within the (minor) gap from end to start
+        return !(arc.end.cross(v) > 0 && v.cross(arc.start) > 0);
+    default:
+        return false;
+    }
+}
+
+// Matthias research - 10 minute physics
+bool collide_arc(const ArcCollider& arc, Ball& ball) {
+    Vec2 dir = ball.p - arc.p;
+    Scalar dist = dir.mag();
+
+    if(arc.surface == Arc::OUTSIDE) {
+        if(dist > arc.r + ball.r) {
+            return false;
+        }
+        if(arc_contains(arc, Vec2(dir.x, -dir.y))) {
+            dir.normalize();
+
+            Vec2 ball_v = ball.p - ball.prev_p;
+            Scalar corr = ball.r + arc.r - dist;
+            ball.p += dir * corr;
+            Scalar v = ball_v.dot(dir);
+            ball_v += dir * (3.0f - v); // TODO: pushVel, this should be a prop
+            ball.prev_p = ball.p - ball_v;
+            return true;
+        }
+    }
+    if(arc.surface == Arc::INSIDE) {
+        Vec2 prev_dir = ball.prev_p - arc.p;
+        Scalar prev_dist = prev_dir.mag();
+        if(prev_dist < arc.r && dist + ball.r > arc.r &&
+           arc_contains(arc, Vec2(dir.x, -dir.y))) {
+            dir.normalize();
+            Vec2 ball_v = ball.p - ball.prev_p;
+
+            // correct our position to be "on" the arc
+            Scalar corr = dist + ball.r - arc.r;
+            ball.p -= dir * corr;
+
+            // Adjust restitution on tangent and normals independently
+            Vec2 tangent = {-dir.y, dir.x};
+            Scalar T = (ball_v.x * tangent.x + ball_v.y * tangent.y) * ARC_TANGENT_RESTITUTION;
+            Scalar N = (ball_v.x * tangent.y - ball_v.y * tangent.x) * ARC_NORMAL_RESTITUTION;
+
+            ball_v.x = tangent.x * T - tangent.y * N;
+            ball_v.y = tangent.y * T + tangent.x * N;
+
+            ball.prev_p = ball.p - ball_v;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Moves a ball entering one end of a portal (e1 -> e2, normal en, unit eu) out of
+// the other end (x1 -> x2, normal xn, unit xu)
+static void portal_transfer(
+    Ball& ball,
+    const Vec2& e1,
+    const Vec2& en,
+    const Vec2& eu,
+    Scalar emag,
+    const Vec2& entry,
+    const Vec2& x2,
+    const Vec2& xn,
+    const Vec2& xu,
+    Scalar xmag) {
+    Vec2 ball_v = ball.p - ball.prev_p;
+
+    // how far "along" the portal are we?
+    Scalar offset = (entry - e1).mag() / emag;
+    ball.p = x2 - xu * (xmag * offset);
+    // ensure we're "outside" the next portal to prevent rapid re-entry
+    ball.p += xn * ball.r;
+
+    // get projections on entry portal
+    Scalar m = -ball_v.dot(eu); // tangent magnitude
+    Scalar n = ball_v.dot(en); // normal magnitude
+
+    // transform to exit portal
+    ball_v.x = xu.x * m - xn.x * n;
+    ball_v.y = xu.y * m - xn.y * n;
+    FURI_LOG_I(TAG, "new v: %.3f,%.3f", (double)ball_v.x, (double)ball_v.y);
+
+    ball.prev_p = ball.p - ball_v;
+}
+
+bool collide_portal(const PortalCollider& pc, Ball& ball, Vec2& contact) {
+    Vec2 ball_v = ball.p - ball.prev_p;
+
+    Vec2 a_cl = Vec2_closest(pc.a1, pc.a2, ball.p);
+    if((ball.p - a_cl).mag() <= ball.r && ball_v.dot(pc.na) < 0) {
+        // entering portal a! move it to portal b
+        contact = a_cl;
+        portal_transfer(ball, pc.a1, pc.na, pc.au, pc.amag, a_cl, pc.b2, pc.nb, pc.bu, pc.bmag);
+        return true;
+    }
+
+    Vec2 b_cl = Vec2_closest(pc.b1, pc.b2, ball.p);
+    if((ball.p - b_cl).mag() <= ball.r && ball_v.dot(pc.nb) < 0) {
+        // entering portal b! move it to portal a
+        contact = b_cl;
+        portal_transfer(ball, pc.b1, pc.nb, pc.bu, pc.bmag, b_cl, pc.a2, pc.na, pc.au, pc.amag);
+        return true;
+    }
+    return false;
+}
+
+bool collide_trigger(const TriggerCollider& trigger, Ball& ball) {
+    if((ball.p - trigger.p).mag2() >= trigger.r * trigger.r) {
+        return false;
+    }
+    if(trigger.turbo) {
+        // apply the turbo in its direction, without counting as a hit
+        ball.prev_p = ball.p - trigger.boost;
+        ball.swept = false;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "vec2.h"
+
+class FixedObject;
+class Ball;
+
+// The collision side of a table, baked from its FixedObjects at load time into
+// contiguous per-type arrays. The solver runs one tight loop per type with no
+// virtual calls. The owning objects keep drawing, signals and animation, and are
+// only touched when a collider is actually hit.
+
+// One straight piece of a rail, with its precomputed unit normal
+typedef struct {
+    Vec2 a;
+    Vec2 b;
+    Vec2 n;
+} Segment;
+
+// A Polygon: segments [first, first + count) of Colliders::segments
+typedef struct {
+    uint16_t first;
+    uint16_t count;
+    uint16_t owner; // index into Table::objects
+    Scalar bounce;
+} RailCollider;
+
+// Which directions from its center an arc covers, tested with cross products
+// against its start and end directions rather than with atan2
+typedef enum {
+    ArcSectorNone, // empty arc
+    ArcSectorMinor, // spans at most half a turn
+    ArcSectorMajor, // spans more than half a turn
+    ArcSectorFull, // full circle, every direction is in
+} ArcSector;
+
+// Arcs and Bumpers
+typedef struct {
+    Vec2 p;
+    Scalar r;
+    // unit vectors (y up) at the start and end angles; the arc runs
+    // counter-clockwise from start to end
+    Vec2 start;
+    Vec2 end;
+    uint8_t sector; // ArcSector
+    uint8_t surface; // Arc::Surface
+    uint16_t owner;
+} ArcCollider;
+
+typedef struct {
+    Vec2 a1, a2; // portal 'a'
+    Vec2 b1, b2; // portal 'b'
+    Vec2 na, nb; // normals
+    Vec2 au, bu; // unit vectors
+    Scalar amag, bmag; // length of portals
+    uint16_t owner;
+} PortalCollider;
+
+// Circular zones that don't deflect the ball: Rollovers, and Turbos which
+// override its velocity with 'boost'
+typedef struct {
+    Vec2 p;
+    Scalar r;
+    Vec2 boost;
+    bool turbo;
+    uint16_t owner;
+} TriggerCollider;
+
+class Colliders {
+public:
+    std::vector<Segment> segments;
+    std::vector<RailCollider> rails;
+    std::vector<ArcCollider> arcs;
+    std::vector<PortalCollider> portals;
+    std::vector<TriggerCollider> triggers;
+
+    // Per owner object: can it currently be hit? Mirrors FixedObject::collidable()
+    // and must be re-synced whenever signals or state resets may have changed it.
+    std::vector<uint8_t> live;
+
+    void build(const std::vector<FixedObject*>& objects);
+    void sync(const std::vector<FixedObject*>& objects);
+    void clear();
+
+    // Colliders also have global ids, for the broadphase grid: rails first,
+    // then arcs, portals and triggers
+    size_t size() const {
+        return rails.size() + arcs.size() + portals.size() + triggers.size();
+    }
+    size_t arcs_begin() const {
+        return rails.size();
+    }
+    size_t portals_begin() const {
+        return arcs_begin() + arcs.size();
+    }
+    size_t triggers_begin() const {
+        return portals_begin() + portals.size();
+    }
+    // Axis-aligned box the ball must touch for collider 'id' to matter
+    void bounds(size_t id, Vec2& lo, Vec2& hi) const;
+};
+
+// Narrow-phase tests. Each returns true on a hit, having already moved the ball
+// and adjusted its velocity.
+bool collide_rail(const Colliders& c, const RailCollider& rail, Ball& ball);
+bool collide_arc(const ArcCollider& arc, Ball& ball);
+// 'contact' is where on the entry portal the ball went in
+bool collide_portal(const PortalCollider& portal, Ball& ball, Vec2& contact);
+bool collide_trigger(const TriggerCollider& trigger, Ball& ball);
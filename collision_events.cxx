@@ -0,0 +1,49 @@
+#include "collision_events.h"
+
+bool CollisionEvents::push(CollisionEventType type, uint16_t index) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    // only the producer writes slots, so the queued ones can be read here
+    for(uint32_t i = t; i != h; i++) {
+        const CollisionEvent& e = events[i % COLLISION_EVENTS_SIZE];
+        if(e.type == type && e.index == index) {
+            return true;
+        }
+    }
+    if(h - t == COLLISION_EVENTS_SIZE) {
+        dropped++;
+        return false;
+    }
+    CollisionEvent& e = events[h % COLLISION_EVENTS_SIZE];
+    e.type = type;
+    e.index = index;
+    // publish the event only once it's written
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t CollisionEvents::pending() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+}
+
+const CollisionEvent& CollisionEvents::at(uint32_t i) const {
+    return events[(tail.load(std::memory_order_relaxed) + i) % COLLISION_EVENTS_SIZE];
+}
+
+void CollisionEvents::release(uint32_t n) {
+    // the slots can be reused only once they're read
+    tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+void CollisionEvents::lose_life() {
+    lost_life.store(true, std::memory_order_release);
+}
+
+bool CollisionEvents::take_lost_life() {
+    return lost_life.exchange(false, std::memory_order_acq_rel);
+}
+
+void CollisionEvents::clear() {
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    lost_life.store(false, std::memory_order_release);
+}
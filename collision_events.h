@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Collisions that should be heard, felt or scored, queued by solve() and
+// handled once per frame by dispatch_collision_events(). The physics loop can
+// hit the same object on every substep of a frame; the queue keeps the
+// notification services and the score out of that loop.
+//
+// An object already queued isn't queued again until it's been handled, so
+// the ring holds at most one event per object or flipper hit, however many
+// balls hit it on however many substeps.
+#define COLLISION_EVENTS_SIZE 128 // a power of two
+
+typedef enum : uint8_t {
+    CollisionEventObject, // index into Table::objects
+    CollisionEventFlipper, // index into Table::flippers
+} CollisionEventType;
+
+typedef struct {
+    CollisionEventType type;
+    uint16_t index;
+} CollisionEvent;
+
+// Lock-free ring for one producer and one consumer. When it's full, new
+// events are dropped and counted.
+class CollisionEvents {
+public:
+    CollisionEvents()
+        : dropped(0)
+        , lost_life(false)
+        , head(0)
+        , tail(0) {
+    }
+
+    // Producer side. Returns false if the event was dropped; one already
+    // queued counts as pushed.
+    bool push(CollisionEventType type, uint16_t index);
+    // Producer side: a ball fell off the table. Kept apart from the ring, so
+    // it's never dropped.
+    void lose_life();
+    // Consumer side: the events queued so far, oldest first. They stay put,
+    // and their slots reserved, until release() hands the first n back.
+    uint32_t pending() const;
+    const CollisionEvent& at(uint32_t i) const;
+    void release(uint32_t n);
+    // Consumer side: has a ball fallen off since last asked?
+    bool take_lost_life();
+    // Forgets every queued event; only while nothing is pushing
+    void clear();
+
+    uint32_t dropped;
+
+private:
+    std::atomic<bool> lost_life;
+    CollisionEvent events[COLLISION_EVENTS_SIZE];
+    std::atomic<uint32_t> head; // next slot to write, producer owned
+    std::atomic<uint32_t> tail; // next slot to read, consumer owned
+};
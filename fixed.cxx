@@ -0,0 +1,77 @@
+#include "fixed.h"
+
+namespace {
+
+// pi/2 and friends, in Q16.16
+const int32_t FIXED_PI_2 = 102944;
+const int32_t FIXED_PI_4 = FIXED_PI_2 / 2;
+const int32_t FIXED_2PI = FIXED_PI_2 * 4;
+
+// Integer square root of a 64 bit value, rounded down
+uint32_t isqrt64(uint64_t v) {
+    if(v == 0) {
+        return 0;
+    }
+    // start at the highest even power of two <= v
+    uint64_t res = 0;
+    uint64_t bit = (uint64_t)1 << ((63 - __builtin_clzll(v)) & ~1);
+    while(bit) {
+        if(v >= res + bit) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+// Taylor series, accurate to a few LSB over [-pi/4, pi/4]
+Fixed sin_poly(Fixed x) {
+    Fixed x2 = x * x;
+    return x * (Fixed(1) - x2 * (Fixed(1.0 / 6) - x2 * (Fixed(1.0 / 120) - x2 * Fixed(1.0 / 5040))));
+}
+Fixed cos_poly(Fixed x) {
+    Fixed x2 = x * x;
+    return Fixed(1) - x2 * (Fixed(0.5) - x2 * (Fixed(1.0 / 24) - x2 * Fixed(1.0 / 720)));
+}
+
+}
+
+Fixed sqrtf(Fixed v) {
+    if(v.raw <= 0) {
+        return Fixed();
+    }
+    return Fixed::from_raw(isqrt64((uint64_t)v.raw << FIXED_SHIFT));
+}
+
+Fixed vec2_hypot(Fixed x, Fixed y) {
+    uint64_t sum = (uint64_t)((int64_t)x.raw * x.raw) + (uint64_t)((int64_t)y.raw * y.raw);
+    uint32_t r = isqrt64(sum);
+    return Fixed::from_raw(r > INT32_MAX ? INT32_MAX : (int32_t)r);
+}
+
+Fixed sinf(Fixed v) {
+    // reduce to [0, 2pi), then to an octant around a multiple of pi/2
+    int32_t r = v.raw % FIXED_2PI;
+    if(r < 0) {
+        r += FIXED_2PI;
+    }
+    int32_t q = (r + FIXED_PI_4) / FIXED_PI_2;
+    Fixed f = Fixed::from_raw(r - q * FIXED_PI_2);
+    switch(q & 3) {
+    case 0:
+        return sin_poly(f);
+    case 1:
+        return cos_poly(f);
+    case 2:
+        return -sin_poly(f);
+    default:
+        return -cos_poly(f);
+    }
+}
+
+Fixed cosf(Fixed v) {
+    return sinf(Fixed::from_raw(v.raw % FIXED_2PI + FIXED_PI_2));
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <stdint.h>
+#include <type_traits>
+
+// Q16.16 fixed-point scalar, used for all physics state when the app is built
+// with PINBALL_FIXED_POINT. Integer math only, so results are bit-exact across
+// compilers and targets.
+//
+// Products and quotients go through 64 bits and saturate instead of wrapping.
+// A squared distance across the table (up to ~2M) doesn't fit in 16 integer
+// bits, but saturating keeps comparisons such as dist2 < r * r correct. Code
+// that needs the actual value of a long distance uses mag() / vec2_hypot(),
+// which never forms the square in 32 bits.
+#define FIXED_SHIFT 16
+#define FIXED_ONE   (1 << FIXED_SHIFT)
+
+class Fixed {
+public:
+    int32_t raw;
+
+    constexpr Fixed()
+        : raw(0) {
+    }
+    template <typename I, typename std::enable_if<std::is_integral<I>::value, int>::type = 0>
+    constexpr Fixed(I v)
+        : raw(sat((int64_t)v * FIXED_ONE)) {
+    }
+    constexpr Fixed(float v)
+        : raw(from_float((double)v)) {
+    }
+    constexpr Fixed(double v)
+        : raw(from_float(v)) {
+    }
+
+    static constexpr Fixed from_raw(int32_t r) {
+        Fixed f;
+        f.raw = r;
+        return f;
+    }
+
+    explicit constexpr operator float() const {
+        return raw / (float)FIXED_ONE;
+    }
+    explicit constexpr operator double() const {
+        return raw / (double)FIXED_ONE;
+    }
+    // truncates toward zero, like a float -> int cast
+    explicit constexpr operator int() const {
+        return raw / FIXED_ONE;
+    }
+
+    constexpr Fixed operator-() const {
+        return from_raw(raw == INT32_MIN ? INT32_MAX : -raw);
+    }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) {
+        return from_raw(sat((int64_t)a.raw + b.raw));
+    }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) {
+        return from_raw(sat((int64_t)a.raw - b.raw));
+    }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) {
+        return from_raw(sat(((int64_t)a.raw * b.raw + (FIXED_ONE / 2)) >> FIXED_SHIFT));
+    }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) {
+        return b.raw == 0 ? from_raw(a.raw >= 0 ? INT32_MAX : INT32_MIN) :
+                            from_raw(sat(((int64_t)a.raw * FIXED_ONE) / b.raw));
+    }
+    Fixed& operator+=(Fixed b) {
+        return *this = *this + b;
+    }
+    Fixed& operator-=(Fixed b) {
+        return *this = *this - b;
+    }
+    Fixed& operator*=(Fixed b) {
+        return *this = *this * b;
+    }
+    Fixed& operator/=(Fixed b) {
+        return *this = *this / b;
+    }
+
+    friend constexpr bool operator==(Fixed a, Fixed b) {
+        return a.raw == b.raw;
+    }
+    friend constexpr bool operator!=(Fixed a, Fixed b) {
+        return a.raw != b.raw;
+    }
+    friend constexpr bool operator<(Fixed a, Fixed b) {
+        return a.raw < b.raw;
+    }
+    friend constexpr bool operator<=(Fixed a, Fixed b) {
+        return a.raw <= b.raw;
+    }
+    friend constexpr bool operator>(Fixed a, Fixed b) {
+        return a.raw > b.raw;
+    }
+    friend constexpr bool operator>=(Fixed a, Fixed b) {
+        return a.raw >= b.raw;
+    }
+
+private:
+    static constexpr int32_t sat(int64_t v) {
+        return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v;
+    }
+    // rounds to nearest, saturating (including infinities)
+    static constexpr int32_t from_float(double v) {
+        return v * FIXED_ONE >= (double)INT32_MAX ? INT32_MAX :
+               v * FIXED_ONE <= (double)INT32_MIN ? INT32_MIN :
+               v >= 0                             ? (int32_t)(v * FIXED_ONE + 0.5) :
+                                                    (int32_t)(v * FIXED_ONE - 0.5);
+    }
+};
+
+// The math.h functions the physics uses, for Fixed. Overloads rather than new
+// names, so the same code compiles against float or Fixed.
+Fixed sqrtf(Fixed v);
+Fixed sinf(Fixed v);
+Fixed cosf(Fixed v);
+// sqrt(x * x + y * y), without overflowing on the squares
+Fixed vec2_hypot(Fixed x, Fixed y);
+
+inline Fixed fabsf(Fixed v) {
+    return v.raw < 0 ? -v : v;
+}
+inline Fixed fabs(Fixed v) {
+    return fabsf(v);
+}
+inline Fixed fminf(Fixed a, Fixed b) {
+    return a < b ? a : b;
+}
+inline Fixed fmaxf(Fixed a, Fixed b) {
+    return a > b ? a : b;
+}
+inline Fixed fmin(Fixed a, Fixed b) {
+    return fminf(a, b);
+}
+inline Fixed fmax(Fixed a, Fixed b) {
+    return fmaxf(a, b);
+}
@@ -0,0 +1,129 @@
+#include <furi.h>
+#include <furi_hal.h>
+
+#include "pinball0.h"
+#include "frame_profile.h"
+
+namespace {
+FrameProfile* active = nullptr;
+
+const char* const section_names[FrameSectionCount] =
+    {"input", "step", "balls", "rails", "arcs", "portals", "triggers", "flippers", "anim", "draw"};
+const char* const section_labels[FrameSectionCount] =
+    {"in", "step", "ball", "rail", "arc", "port", "trig", "flip", "anim", "draw"};
+
+// sections sampled every time they run, rather than once per frame
+bool per_call(FrameSection section) {
+    return section == FrameSectionStep || section == FrameSectionDraw;
+}
+
+void add_sample(FrameSection section, uint32_t cycles) {
+    if(active->samples[section] == 0 || cycles < active->min[section]) {
+        active->min[section] = cycles;
+    }
+    if(cycles > active->max[section]) {
+        active->max[section] = cycles;
+    }
+    active->total[section] += cycles;
+    active->samples[section]++;
+}
+
+void clear_window() {
+    memset(active->pending, 0, sizeof(active->pending));
+    memset(active->min, 0, sizeof(active->min));
+    memset(active->max, 0, sizeof(active->max));
+    memset(active->total, 0, sizeof(active->total));
+    memset(active->samples, 0, sizeof(active->samples));
+    active->frames = 0;
+}
+}
+
+void frame_profile_begin(FrameProfile* profile) {
+    memset(profile, 0, sizeof(FrameProfile));
+    profile->cycles_per_us = furi_hal_cortex_instructions_per_microsecond();
+    if(!profile->cycles_per_us) {
+        profile->cycles_per_us = 1;
+    }
+    active = profile;
+}
+
+void frame_profile_end() {
+    active = nullptr;
+}
+
+bool frame_profile_active() {
+    return active != nullptr;
+}
+
+void frame_profile_end_frame() {
+    if(!active) {
+        return;
+    }
+    for(int i = 0; i < FrameSectionCount; i++) {
+        FrameSection section = (FrameSection)i;
+        if(!per_call(section)) {
+            add_sample(section, active->pending[i]);
+        }
+    }
+    memset(active->pending, 0, sizeof(active->pending));
+    if(++active->frames < FRAME_PROFILE_WINDOW) {
+        return;
+    }
+
+    for(int i = 0; i < FrameSectionCount; i++) {
+        uint32_t n = active->samples[i] ? active->samples[i] : 1;
+        active->last[i].min = active->min[i];
+        active->last[i].avg = active->total[i] / n;
+        active->last[i].max = active->max[i];
+    }
+    active->valid = true;
+    clear_window();
+}
+
+uint32_t frame_profile_us(const FrameProfile* profile, uint32_t cycles) {
+    return cycles / profile->cycles_per_us;
+}
+
+const char* frame_profile_section_name(FrameSection section) {
+    return section < FrameSectionCount ? section_names[section] : "?";
+}
+
+const char* frame_profile_section_label(FrameSection section) {
+    return section < FrameSectionCount ? section_labels[section] : "?";
+}
+
+void frame_profile_log(const FrameProfile* profile) {
+    if(!profile->valid) {
+        return;
+    }
+    FURI_LOG_I(TAG, "Frame profile, last %d frames (us min/avg/max):", FRAME_PROFILE_WINDOW);
+    for(int i = 0; i < FrameSectionCount; i++) {
+        FURI_LOG_I(
+            TAG,
+            "  %-8s %6lu %6lu %6lu%s",
+            section_names[i],
+            (unsigned long)frame_profile_us(profile, profile->last[i].min),
+            (unsigned long)frame_profile_us(profile, profile->last[i].avg),
+            (unsigned long)frame_profile_us(profile, profile->last[i].max),
+            per_call((FrameSection)i) ? " per call" : "");
+    }
+}
+
+FrameSectionScope::FrameSectionScope(FrameSection section)
+    : section(section)
+    , timing(active != nullptr)
+    , start(timing ? DWT->CYCCNT : 0) {
+}
+
+FrameSectionScope::~FrameSectionScope() {
+    // profiling may have started or stopped in the meantime
+    if(!active || !timing) {
+        return;
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    if(per_call(section)) {
+        add_sample(section, cycles);
+    } else {
+        active->pending[section] += cycles;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+
+// Frame profiling for Debug mode. While a FrameProfile is active, the time
+// spent in each hot-path section is read from the DWT cycle counter (a steady
+// clock in the host build) and summarized as min, avg and max over windows of
+// FRAME_PROFILE_WINDOW frames. Inactive, a FrameSectionScope costs one test.
+#define FRAME_PROFILE_WINDOW 30
+
+typedef enum {
+    FrameSectionInput, // input event handling
+    FrameSectionStep, // one solve() substep
+    FrameSectionBalls, // ball-ball collisions
+    FrameSectionRails, // collision tests, by type of object
+    FrameSectionArcs,
+    FrameSectionPortals,
+    FrameSectionTriggers,
+    FrameSectionFlippers,
+    FrameSectionAnimation, // Table::step_animation()
+    FrameSectionDraw, // the draw callback, Table::draw() included
+    FrameSectionCount,
+} FrameSection;
+
+typedef struct {
+    uint32_t min; // cycles
+    uint32_t avg;
+    uint32_t max;
+} FrameStat;
+
+typedef struct {
+    uint32_t pending[FrameSectionCount]; // cycles in the current frame
+    // the window being filled, in cycles per sample
+    uint32_t min[FrameSectionCount];
+    uint32_t max[FrameSectionCount];
+    uint64_t total[FrameSectionCount];
+    uint32_t samples[FrameSectionCount];
+    uint32_t frames;
+
+    FrameStat last[FrameSectionCount]; // the last complete window
+    uint32_t cycles_per_us;
+    bool valid; // last holds a complete window
+} FrameProfile;
+
+// Starts profiling into 'profile', from an empty window
+void frame_profile_begin(FrameProfile* profile);
+// Stops profiling. Safe to call when nothing is active.
+void frame_profile_end();
+bool frame_profile_active();
+
+// Closes the current frame; every FRAME_PROFILE_WINDOW frames this publishes
+// the window to 'last'. Steps and draws are sampled once each; every other
+// section once per frame, as the sum of its time in the frame.
+void frame_profile_end_frame();
+
+// Cycles to whole microseconds
+uint32_t frame_profile_us(const FrameProfile* profile, uint32_t cycles);
+
+const char* frame_profile_section_name(FrameSection section);
+// A short name, for the on-screen overlay
+const char* frame_profile_section_label(FrameSection section);
+
+// Writes the last complete window to the log
+void frame_profile_log(const FrameProfile* profile);
+
+// Charges the time until it goes out of scope to 'section'
+class FrameSectionScope {
+public:
+    FrameSectionScope(FrameSection section);
+    ~FrameSectionScope();
+
+private:
+    FrameSection section;
+    bool timing;
+    uint32_t start;
+};
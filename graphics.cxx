@@ -1,4 +1,5 @@
 #include "graphics.h"
+#include "raster.h"
 
 #define SCALE 10
 
@@ -27,12 +28,15 @@ const int LINE_THICKNESS_MIDDLE = 0; // Start point is on the line at center of
 const int LINE_THICKNESS_DRAW_CLOCKWISE = 1; // Start point is on the counter clockwise border line
 const int LINE_THICKNESS_DRAW_COUNTERCLOCKWISE = 2; // Start point is on the clockwise border line
 
+// drawThickLine() plots here, gfx_draw_line_thick() draws the result
+RasterRows thick_rows;
+
 /**
  * Draws a line from aXStart/aYStart to aXEnd/aYEnd including both ends
  * @param aOverlap One of LINE_OVERLAP_NONE, LINE_OVERLAP_MAJOR, LINE_OVERLAP_MINOR, LINE_OVERLAP_BOTH
  */
 void drawLineOverlap(
-    Canvas* canvas,
+    RasterRows* rows,
     unsigned int aXStart,
     unsigned int aYStart,
     unsigned int aXEnd,
@@ -67,7 +71,7 @@ void drawLineOverlap(
         //     aXEnd,
         //     aYEnd,
         //     aColor); // you can remove the check and this line if you have no fillRect() or drawLine() available.
-        canvas_draw_box(canvas, aXStart, aYStart, aXEnd - aXStart, aYEnd - aYStart);
+        raster_rows_box(rows, aXStart, aYStart, aXEnd - aXStart, aYEnd - aYStart);
     } else {
         // calculate direction
         tDeltaX = aXEnd - aXStart;
@@ -88,7 +92,7 @@ void drawLineOverlap(
         tDeltaYTimes2 = tDeltaY << 1;
         // draw start pixel
         // drawPixel(aXStart, aYStart, aColor);
-        canvas_draw_dot(canvas, aXStart, aYStart);
+        raster_rows_dot(rows, aXStart, aYStart);
         if(tDeltaX > tDeltaY) {
             // start value represents a half step in Y direction
             tError = tDeltaYTimes2 - tDeltaX;
@@ -99,20 +103,20 @@ void drawLineOverlap(
                     if(aOverlap & LINE_OVERLAP_MAJOR) {
                         // draw pixel in main direction before changing
                         // drawPixel(aXStart, aYStart, aColor);
-                        canvas_draw_dot(canvas, aXStart, aYStart);
+                        raster_rows_dot(rows, aXStart, aYStart);
                     }
                     // change Y
                     aYStart += tStepY;
                     if(aOverlap & LINE_OVERLAP_MINOR) {
                         // draw pixel in minor direction before changing
                         // drawPixel(aXStart - tStepX, aYStart, aColor);
-                        canvas_draw_dot(canvas, aXStart - tStepX, aYStart);
+                        raster_rows_dot(rows, aXStart - tStepX, aYStart);
                     }
                     tError -= tDeltaXTimes2;
                 }
                 tError += tDeltaYTimes2;
                 // drawPixel(aXStart, aYStart, aColor);
-                canvas_draw_dot(canvas, aXStart, aYStart);
+                raster_rows_dot(rows, aXStart, aYStart);
             }
         } else {
             tError = tDeltaXTimes2 - tDeltaY;
@@ -122,19 +126,19 @@ void drawLineOverlap(
                     if(aOverlap & LINE_OVERLAP_MAJOR) {
                         // draw pixel in main direction before changing
                         // drawPixel(aXStart, aYStart, aColor);
-                        canvas_draw_dot(canvas, aXStart, aYStart);
+                        raster_rows_dot(rows, aXStart, aYStart);
                     }
                     aXStart += tStepX;
                     if(aOverlap & LINE_OVERLAP_MINOR) {
                         // draw pixel in minor direction before changing
                         // drawPixel(aXStart, aYStart - tStepY, aColor);
-                        canvas_draw_dot(canvas, aXStart, aYStart - tStepY);
+                        raster_rows_dot(rows, aXStart, aYStart - tStepY);
                     }
                     tError -= tDeltaYTimes2;
                 }
                 tError += tDeltaXTimes2;
                 // drawPixel(aXStart, aYStart, aColor);
-                canvas_draw_dot(canvas, aXStart, aYStart);
+                raster_rows_dot(rows, aXStart, aYStart);
             }
         }
     }
@@ -147,7 +151,7 @@ void drawLineOverlap(
  * aThicknessMode can be one of LINE_THICKNESS_MIDDLE, LINE_THICKNESS_DRAW_CLOCKWISE, LINE_THICKNESS_DRAW_COUNTERCLOCKWISE
  */
 void drawThickLine(
-    Canvas* canvas,
+    RasterRows* rows,
     unsigned int aXStart,
     unsigned int aYStart,
     unsigned int aXEnd,
@@ -157,7 +161,7 @@ void drawThickLine(
     int16_t i, tDeltaX, tDeltaY, tDeltaXTimes2, tDeltaYTimes2, tError, tStepX, tStepY;
 
     if(aThickness <= 1) {
-        drawLineOverlap(canvas, aXStart, aYStart, aXEnd, aYEnd, LINE_OVERLAP_NONE);
+        drawLineOverlap(rows, aXStart, aYStart, aXEnd, aYEnd, LINE_OVERLAP_NONE);
     }
     /*
      * Clip to display size
@@ -247,7 +251,7 @@ void drawThickLine(
         // draw start line. We can alternatively use drawLineOverlap(aXStart, aYStart, aXEnd, aYEnd, LINE_OVERLAP_NONE, aColor) here.
         // drawLine(aXStart, aYStart, aXEnd, aYEnd);
         // canvas_draw_line(canvas, aXStart, aYStart, aXEnd, aYEnd);
-        drawLineOverlap(canvas, aXStart, aYStart, aXEnd, aYEnd, LINE_OVERLAP_NONE);
+        drawLineOverlap(rows, aXStart, aYStart, aXEnd, aYEnd, LINE_OVERLAP_NONE);
         // draw aThickness number of lines
         tError = tDeltaYTimes2 - tDeltaX;
         for(i = aThickness; i > 1; i--) {
@@ -281,7 +285,7 @@ void drawThickLine(
                 tOverlap = LINE_OVERLAP_MAJOR;
             }
             tError += tDeltaYTimes2;
-            drawLineOverlap(canvas, aXStart, aYStart, aXEnd, aYEnd, tOverlap);
+            drawLineOverlap(rows, aXStart, aYStart, aXEnd, aYEnd, tOverlap);
         }
     } else {
         // the other octant 2, 4, 6, 8 (between 45 and 90, 135 and 180, ... degree)
@@ -305,7 +309,7 @@ void drawThickLine(
         }
         //draw start line
         // drawLine(aXStart, aYStart, aXEnd, aYEnd);
-        canvas_draw_line(canvas, aXStart, aYStart, aXEnd, aYEnd);
+        raster_rows_line(rows, aXStart, aYStart, aXEnd, aYEnd);
         // draw aThickness number of lines
         tError = tDeltaXTimes2 - tDeltaY;
         for(i = aThickness; i > 1; i--) {
@@ -319,7 +323,7 @@ void drawThickLine(
                 tOverlap = LINE_OVERLAP_MAJOR;
             }
             tError += tDeltaXTimes2;
-            drawLineOverlap(canvas, aXStart, aYStart, aXEnd, aYEnd, tOverlap);
+            drawLineOverlap(rows, aXStart, aYStart, aXEnd, aYEnd, tOverlap);
         }
     }
 }
@@ -450,12 +454,18 @@ const uint8_t u8g2_font_micro_tn[148] =
 // TODO: allow points to be located outside the canvas. currently, the canvas_* methods
 // choke on this in some cases, resulting in large vertical/horizontal lines
 void gfx_draw_line(Canvas* canvas, float x1, float y1, float x2, float y2) {
+    Raster* r = raster_get(canvas);
+    if(r) {
+        raster_line(
+            r, roundf(x1 / SCALE), roundf(y1 / SCALE), roundf(x2 / SCALE), roundf(y2 / SCALE));
+        return;
+    }
     canvas_draw_line(
         canvas, roundf(x1 / SCALE), roundf(y1 / SCALE), roundf(x2 / SCALE), roundf(y2 / SCALE));
 }
 
 void gfx_draw_line(Canvas* canvas, const Vec2& p1, const Vec2& p2) {
-    gfx_draw_line(canvas, p1.x, p1.y, p2.x, p2.y);
+    gfx_draw_line(canvas, (float)p1.x, (float)p1.y, (float)p2.x, (float)p2.y);
 }
 
 void gfx_draw_line_thick(Canvas* canvas, float x1, float y1, float x2, float y2, int thickness) {
@@ -464,49 +474,109 @@ void gfx_draw_line_thick(Canvas* canvas, float x1, float y1, float x2, float y2,
     x2 = roundf(x2 / SCALE);
     y2 = roundf(y2 / SCALE);
 
-    drawThickLine(canvas, x1, y1, x2, y2, thickness, LINE_THICKNESS_MIDDLE);
+    // the strokes overlap, so gather them up and draw each pixel once
+    raster_rows_clear(&thick_rows);
+    drawThickLine(&thick_rows, x1, y1, x2, y2, thickness, LINE_THICKNESS_MIDDLE);
+    raster_rows_flush(&thick_rows, canvas);
 }
 
 void gfx_draw_line_thick(Canvas* canvas, const Vec2& p1, const Vec2& p2, int thickness) {
-    gfx_draw_line_thick(canvas, p1.x, p1.y, p2.x, p2.y, thickness);
+    gfx_draw_line_thick(canvas, (float)p1.x, (float)p1.y, (float)p2.x, (float)p2.y, thickness);
 }
 
 void gfx_draw_disc(Canvas* canvas, float x, float y, float r) {
+    Raster* raster = raster_get(canvas);
+    if(raster) {
+        raster_disc(raster, roundf(x / SCALE), roundf(y / SCALE), roundf(r / SCALE));
+        return;
+    }
     canvas_draw_disc(canvas, roundf(x / SCALE), roundf(y / SCALE), roundf(r / SCALE));
 }
-void gfx_draw_disc(Canvas* canvas, const Vec2& p, float r) {
-    gfx_draw_disc(canvas, p.x, p.y, r);
+void gfx_draw_disc(Canvas* canvas, const Vec2& p, Scalar r) {
+    gfx_draw_disc(canvas, (float)p.x, (float)p.y, (float)r);
 }
 
 void gfx_draw_circle(Canvas* canvas, float x, float y, float r) {
+    Raster* raster = raster_get(canvas);
+    if(raster) {
+        raster_circle(raster, roundf(x / SCALE), roundf(y / SCALE), roundf(r / SCALE));
+        return;
+    }
     canvas_draw_circle(canvas, roundf(x / SCALE), roundf(y / SCALE), roundf(r / SCALE));
 }
-void gfx_draw_circle(Canvas* canvas, const Vec2& p, float r) {
-    gfx_draw_circle(canvas, p.x, p.y, r);
+void gfx_draw_circle(Canvas* canvas, const Vec2& p, Scalar r) {
+    gfx_draw_circle(canvas, (float)p.x, (float)p.y, (float)r);
 }
 
 void gfx_draw_dot(Canvas* canvas, float x, float y) {
+    Raster* r = raster_get(canvas);
+    if(r) {
+        raster_dot(r, roundf(x / SCALE), roundf(y / SCALE));
+        return;
+    }
     canvas_draw_dot(canvas, roundf(x / SCALE), roundf(y / SCALE));
 }
 void gfx_draw_dot(Canvas* canvas, const Vec2& p) {
-    gfx_draw_dot(canvas, p.x, p.y);
+    gfx_draw_dot(canvas, (float)p.x, (float)p.y);
 }
 
-void gfx_draw_arc(Canvas* canvas, const Vec2& p, float r, float start, float end) {
+namespace {
+// Calls point(x, y) for each end of the arc's segments, in table units
+template <typename Point>
+void arc_points(const Vec2& p, Scalar r, float start, float end, Point point) {
     float adj_end = end;
     if(end < start) {
         adj_end += (float)M_PI * 2;
     }
+    float cx = (float)p.x;
+    float cy = (float)p.y;
+    float cr = (float)r;
     // initialize to start of arc
-    float sx = p.x + r * cosf(start);
-    float sy = p.y - r * sinf(start);
-    size_t segments = r / 8;
+    point(cx + cr * cosf(start), cy - cr * sinf(start));
+    size_t segments = cr / 8;
     for(size_t i = 1; i <= segments; i++) { // for now, use r to determin number of segments
-        float nx = p.x + r * cosf(start + i / (segments / (adj_end - start)));
-        float ny = p.y - r * sinf(start + i / (segments / (adj_end - start)));
-        gfx_draw_line(canvas, sx, sy, nx, ny);
+        point(
+            cx + cr * cosf(start + i / (segments / (adj_end - start))),
+            cy - cr * sinf(start + i / (segments / (adj_end - start))));
+    }
+}
+}
+
+void gfx_draw_arc(Canvas* canvas, const Vec2& p, Scalar r, float start, float end) {
+    bool first = true;
+    float sx = 0, sy = 0;
+    arc_points(p, r, start, end, [&](float nx, float ny) {
+        if(!first) {
+            gfx_draw_line(canvas, sx, sy, nx, ny);
+        }
+        first = false;
         sx = nx;
         sy = ny;
+    });
+}
+
+size_t gfx_arc_outline_size(Scalar r) {
+    return (size_t)((float)r / 8) + 1;
+}
+
+void gfx_arc_outline(std::vector<GfxPoint>& points, const Vec2& p, Scalar r, float start, float end) {
+    points.clear();
+    points.reserve(gfx_arc_outline_size(r));
+    arc_points(p, r, start, end, [&points](float x, float y) {
+        points.push_back({(int16_t)roundf(x / SCALE), (int16_t)roundf(y / SCALE)});
+    });
+}
+
+void gfx_draw_polyline(Canvas* canvas, const std::vector<GfxPoint>& points) {
+    Raster* r = raster_get(canvas);
+    for(size_t i = 1; i < points.size(); i++) {
+        const GfxPoint& a = points[i - 1];
+        const GfxPoint& b = points[i];
+        if(r) {
+            raster_line(r, a.x, a.y, b.x, b.y);
+        } else {
+            canvas_draw_line(canvas, a.x, a.y, b.x, b.y);
+        }
     }
 }
 
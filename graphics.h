@@ -1,12 +1,15 @@
 #pragma once
 
 #include <gui/gui.h>
+#include <vector>
 #include "vec2.h"
 
 // Use to draw table elements, which live on a 640 x 1280 grid
 // These methods will scale and round the coordinates
 // Also, they will (eventually) handle cases where the thing we're drawing
 // lies outside the table bounds.
+// They draw in black, straight into the framebuffer where they can (raster.h),
+// with the same pixels as the canvas_* functions.
 
 void gfx_draw_line(Canvas* canvas, float x1, float y1, float x2, float y2);
 void gfx_draw_line(Canvas* canvas, const Vec2& p1, const Vec2& p2);
@@ -15,15 +18,27 @@ void gfx_draw_line_thick(Canvas* canvas, float x1, float y1, float x2, float y2,
 void gfx_draw_line_thick(Canvas* canvas, const Vec2& p1, const Vec2& p2, int thickness);
 
 void gfx_draw_disc(Canvas* canvas, float x, float y, float r);
-void gfx_draw_disc(Canvas* canvas, const Vec2& p, float r);
+void gfx_draw_disc(Canvas* canvas, const Vec2& p, Scalar r);
 
 void gfx_draw_circle(Canvas* canvas, float x, float y, float r);
-void gfx_draw_circle(Canvas* canvas, const Vec2& p, float r);
+void gfx_draw_circle(Canvas* canvas, const Vec2& p, Scalar r);
 
 void gfx_draw_dot(Canvas* canvas, float x, float y);
 void gfx_draw_dot(Canvas* canvas, const Vec2& p);
 
-void gfx_draw_arc(Canvas* canvas, const Vec2& p, float r, float start, float end);
+void gfx_draw_arc(Canvas* canvas, const Vec2& p, Scalar r, float start, float end);
+
+// A point already scaled and rounded to the screen
+typedef struct {
+    int16_t x, y;
+} GfxPoint;
+
+// Outlines for things that never move: work out the screen points once, then
+// draw them as often as needed without any float math. An arc's outline is
+// exactly what gfx_draw_arc() draws.
+size_t gfx_arc_outline_size(Scalar r); // number of points
+void gfx_arc_outline(std::vector<GfxPoint>& points, const Vec2& p, Scalar r, float start, float end);
+void gfx_draw_polyline(Canvas* canvas, const std::vector<GfxPoint>& points);
 
 // Uses the micro font
 void gfx_draw_str(Canvas* canvas, int x, int y, Align h, Align v, const char* str);
@@ -0,0 +1,160 @@
+#include "pinball0.h"
+#include "colliders.h"
+#include "grid.h"
+
+namespace {
+int grid_col(Scalar x) {
+    int c = (int)(x / GRID_CELL_SIZE);
+    return c < 0 ? 0 : c >= GRID_COLS ? GRID_COLS - 1 : c;
+}
+int grid_row(Scalar y) {
+    int r = (int)(y / GRID_CELL_SIZE);
+    return r < 0 ? 0 : r >= GRID_ROWS ? GRID_ROWS - 1 : r;
+}
+}
+
+void CollisionGrid::clear() {
+    cell_start.clear();
+    cell_items.clear();
+    candidates.clear();
+    num_colliders = 0;
+}
+
+void CollisionGrid::build(const Colliders& colliders) {
+    clear();
+    num_colliders = colliders.size();
+
+    // Two passes: count items per cell, then fill. Keeps cell_items contiguous.
+    std::vector<uint16_t> counts(GRID_CELLS, 0);
+    Vec2 lo, hi;
+    for(size_t i = 0; i < num_colliders; i++) {
+        colliders.bounds(i, lo, hi);
+        for(int r = grid_row(lo.y); r <= grid_row(hi.y); r++) {
+            for(int c = grid_col(lo.x); c <= grid_col(hi.x); c++) {
+                counts[r * GRID_COLS + c]++;
+            }
+        }
+    }
+
+    cell_start.resize(GRID_CELLS + 1);
+    cell_start[0] = 0;
+    for(size_t c = 0; c < GRID_CELLS; c++) {
+        cell_start[c + 1] = cell_start[c] + counts[c];
+    }
+    cell_items.resize(cell_start[GRID_CELLS]);
+
+    for(size_t i = 0; i < num_colliders; i++) {
+        colliders.bounds(i, lo, hi);
+        for(int r = grid_row(lo.y); r <= grid_row(hi.y); r++) {
+            for(int c = grid_col(lo.x); c <= grid_col(hi.x); c++) {
+                size_t cell = r * GRID_COLS + c;
+                cell_items[cell_start[cell + 1] - counts[cell]] = i;
+                counts[cell]--;
+            }
+        }
+    }
+
+    candidates.resize((num_colliders + 31) / 32);
+    FURI_LOG_I(
+        TAG,
+        "Collision grid: %d colliders, %d cell entries",
+        (int)num_colliders,
+        (int)cell_items.size());
+}
+
+const std::vector<uint32_t>& CollisionGrid::query(const Ball& ball) {
+    for(auto& w : candidates) {
+        w = 0;
+    }
+
+    Scalar x0 = fminf(ball.p.x, ball.prev_p.x) - ball.r;
+    Scalar x1 = fmaxf(ball.p.x, ball.prev_p.x) + ball.r;
+    Scalar y0 = fminf(ball.p.y, ball.prev_p.y) - ball.r;
+    Scalar y1 = fmaxf(ball.p.y, ball.prev_p.y) + ball.r;
+
+    for(int r = grid_row(y0); r <= grid_row(y1); r++) {
+        for(int c = grid_col(x0); c <= grid_col(x1); c++) {
+            size_t cell = r * GRID_COLS + c;
+            for(size_t i = cell_start[cell]; i < cell_start[cell + 1]; i++) {
+                uint16_t id = cell_items[i];
+                candidates[id / 32] |= 1u << (id % 32);
+            }
+        }
+    }
+
+    uint32_t tested = 0;
+    for(auto w : candidates) {
+        tested += __builtin_popcount(w);
+    }
+    narrow_tests += tested;
+    narrow_skipped += num_colliders - tested;
+    return candidates;
+}
+
+void BallGrid::reserve(size_t balls) {
+    cell_start.resize(GRID_CELLS + 1);
+    counts.resize(GRID_CELLS);
+    cell_items.reserve(balls);
+    ball_cell.reserve(balls);
+    candidates.reserve((balls + 31) / 32);
+}
+
+void BallGrid::build(const std::vector<Ball>& balls) {
+    size_t n = balls.size();
+    cell_start.resize(GRID_CELLS + 1);
+    counts.assign(GRID_CELLS, 0);
+    cell_items.resize(n);
+    ball_cell.resize(n);
+    candidates.resize((n + 31) / 32);
+
+    // Same two passes as CollisionGrid, which leaves each cell's balls in
+    // index order
+    Scalar r_max = 0;
+    for(size_t i = 0; i < n; i++) {
+        const Ball& b = balls[i];
+        uint16_t cell = grid_row(b.p.y) * GRID_COLS + grid_col(b.p.x);
+        ball_cell[i] = cell;
+        counts[cell]++;
+        if(b.r > r_max) {
+            r_max = b.r;
+        }
+    }
+    reach = 1;
+    while(reach * GRID_CELL_SIZE < r_max * 2) {
+        reach++;
+    }
+
+    cell_start[0] = 0;
+    for(size_t c = 0; c < GRID_CELLS; c++) {
+        cell_start[c + 1] = cell_start[c] + counts[c];
+    }
+    for(size_t i = 0; i < n; i++) {
+        uint16_t cell = ball_cell[i];
+        cell_items[cell_start[cell + 1] - counts[cell]] = i;
+        counts[cell]--;
+    }
+}
+
+const std::vector<uint32_t>& BallGrid::query(size_t index) {
+    for(auto& w : candidates) {
+        w = 0;
+    }
+
+    int row = ball_cell[index] / GRID_COLS;
+    int col = ball_cell[index] % GRID_COLS;
+    int r0 = row > reach ? row - reach : 0;
+    int r1 = row + reach < GRID_ROWS ? row + reach : GRID_ROWS - 1;
+    int c0 = col > reach ? col - reach : 0;
+    int c1 = col + reach < GRID_COLS ? col + reach : GRID_COLS - 1;
+    for(int r = r0; r <= r1; r++) {
+        // cells are row-major, so a row's cells are one run of cell_items
+        for(size_t i = cell_start[r * GRID_COLS + c0]; i < cell_start[r * GRID_COLS + c1 + 1];
+            i++) {
+            uint16_t id = cell_items[i];
+            if(id > index) {
+                candidates[id / 32] |= 1u << (id % 32);
+            }
+        }
+    }
+    return candidates;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "vec2.h"
+
+class Colliders;
+class Ball;
+
+// Static uniform grid over the 640 x 1280 table space. Built once per table,
+// it lets solve() skip narrow-phase collision tests for objects that are
+// nowhere near a ball.
+#define GRID_CELL_SIZE 80
+#define GRID_COLS      (640 / GRID_CELL_SIZE)
+#define GRID_ROWS      (1280 / GRID_CELL_SIZE)
+#define GRID_CELLS     (GRID_COLS * GRID_ROWS)
+
+class CollisionGrid {
+public:
+    CollisionGrid()
+        : narrow_tests(0)
+        , narrow_skipped(0)
+        , num_colliders(0) {
+    }
+
+    // Bins every collider into the cells covered by its bounding box
+    void build(const Colliders& colliders);
+    void clear();
+    bool built() const {
+        return !cell_start.empty();
+    }
+
+    // Returns a bitmask over collider ids, marking every collider that shares a
+    // cell with the ball's swept circle (prev_p -> p). Bits are in id order, so
+    // each collider type is a contiguous run of bits.
+    const std::vector<uint32_t>& query(const Ball& ball);
+
+    // Running counters of narrow-phase tests performed and skipped
+    uint32_t narrow_tests;
+    uint32_t narrow_skipped;
+
+private:
+    size_t num_colliders;
+    std::vector<uint16_t> cell_start; // GRID_CELLS + 1 offsets into cell_items
+    std::vector<uint16_t> cell_items; // collider ids, grouped by cell
+    std::vector<uint32_t> candidates; // scratch bitmask returned by query()
+};
+
+// Uniform grid over the balls, on the same cells, rebuilt every substep so the
+// ball-ball pass only tests balls in nearby cells instead of every pair.
+class BallGrid {
+public:
+    BallGrid()
+        : reach(1) {
+    }
+
+    // Sizes the buffers for up to 'balls' balls, so build() needn't allocate
+    void reserve(size_t balls);
+    // Bins each ball by its centre
+    void build(const std::vector<Ball>& balls);
+
+    // Returns a bitmask over ball indexes, marking the balls after 'index' that
+    // are binned near enough to touch it, so each pair comes up once, in the
+    // same order as a loop over all pairs.
+    const std::vector<uint32_t>& query(size_t index);
+
+private:
+    int reach; // cells searched either side, so the two largest balls can touch
+    std::vector<uint16_t> cell_start; // GRID_CELLS + 1 offsets into cell_items
+    std::vector<uint16_t> counts; // scratch for build()
+    std::vector<uint16_t> cell_items; // ball indexes, grouped by cell
+    std::vector<uint16_t> ball_cell; // the cell each ball is in
+    std::vector<uint32_t> candidates; // scratch bitmask returned by query()
+};
@@ -0,0 +1,71 @@
+// Host replacements for the app object and its notifications. The real
+// ones live in pinball0.cxx / notifications.cxx and talk to the GUI,
+// input and notification services, which don't exist here.
+
+#include "pinball0.h"
+#include "table.h"
+#include "notifications.h"
+
+PinballApp::PinballApp() {
+    mutex = NULL;
+    storage = NULL;
+    notify = NULL;
+    table = NULL;
+    tick = 0;
+    game_mode = GM_TableSelect;
+    for(auto& k : keys) {
+        k = false;
+    }
+    processing = true;
+    idle_start = 0;
+    settings.sound_enabled = false;
+    settings.led_enabled = false;
+    settings.vibrate_enabled = false;
+    settings.debug_mode = true; // include the dbg tables
+    settings.selected_setting = 0;
+    settings.max_settings = 4;
+    text[0] = '\0';
+    load_profile.valid = false;
+    frame_profile.valid = false;
+    replay.recording = false;
+    replay.playing = false;
+    replay.file = nullptr;
+    resume.active = false;
+    initialized = true;
+}
+
+PinballApp::~PinballApp() {
+    replay_end(this);
+    delete table;
+}
+
+void notify_ball_released(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_table_bump(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_table_tilted(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_error_message(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_game_over(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_bumper_hit(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_rail_hit(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_portal(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_lost_life(void* ctx) {
+    UNUSED(ctx);
+}
+void notify_flipper(void* ctx) {
+    UNUSED(ctx);
+}
@@ -0,0 +1,429 @@
+// Headless physics benchmark. Loads every table in assets/tables and runs
+// N seconds of scripted flipper input through solve(), one frame of
+// PHYSICS_SUB_STEPS steps at a time, then reports substeps and collision
+// throughput per table, along with a hash of every ball's position on every
+// frame. Builds that are bit-exact deterministic print the same hash.
+//
+// -t writes the ball positions to a trace file, for pinball0_drift to compare
+// the float and fixed-point builds.
+//
+// -d times drawing instead: each frame is drawn once with the table's static
+// layer and once without, and the two framebuffers are compared.
+//
+// -m sweeps multiball instead: each table is run with 1, 2, 4 ... 64 copies of
+// its ball, reporting the time per frame, how many of the ball pairs were
+// tested against each other per substep and how much of the time balls slept.
+//
+// -p also runs the frame profiler, and prints each table's last window of it.
+//
+// -r also records each table's scripted game, up to its first game over, to
+// <dir>/<table>.pbr, for pinball0_replay.
+//
+// usage: pinball0_bench [-s seconds] [-C repo_dir] [-t trace] [-r dir] [-d | -m] [-p] [-v]
+//                       [filter ...]
+
+#include <chrono>
+#include <limits.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+#include "pinball0.h"
+#include "table.h"
+#include "physics.h"
+
+namespace {
+
+typedef struct {
+    Canvas* layer; // drawn with the static layer
+    Canvas* full; // drawn object by object
+    std::chrono::nanoseconds layer_time;
+    std::chrono::nanoseconds full_time;
+    uint32_t mismatches; // frames where the two differ
+} DrawStats;
+
+// Draws a frame both ways, as the draw callback would
+void draw_frame(Table* table, DrawStats& stats) {
+    canvas_clear(stats.layer);
+    auto start = std::chrono::steady_clock::now();
+    table->draw_static(stats.layer);
+    table->draw(stats.layer);
+    stats.layer_time += std::chrono::steady_clock::now() - start;
+
+    table->static_layer_enabled = false;
+    canvas_clear(stats.full);
+    start = std::chrono::steady_clock::now();
+    table->draw_static(stats.full);
+    table->draw(stats.full);
+    stats.full_time += std::chrono::steady_clock::now() - start;
+    table->static_layer_enabled = true;
+
+    if(memcmp(
+           canvas_get_buffer(stats.layer),
+           canvas_get_buffer(stats.full),
+           canvas_get_buffer_size(stats.full)) != 0) {
+        stats.mismatches++;
+    }
+}
+
+void set_flippers(PinballApp& app, Flipper::Side side, bool powered) {
+    app.keys[side == Flipper::LEFT ? InputKeyLeft : InputKeyRight] = powered;
+    for(auto& f : app.table->flippers) {
+        if(f.side == side) {
+            f.powered = powered;
+        }
+    }
+}
+
+// Deterministic input script: alternating flipper taps and the odd table bump
+void script_input(PinballApp& app, uint32_t frame) {
+    set_flippers(app, Flipper::LEFT, (frame % 45) < 8);
+    set_flippers(app, Flipper::RIGHT, ((frame + 20) % 53) < 8);
+    app.keys[InputKeyUp] = (frame % 150) < 3;
+    if(!app.table->balls_released) {
+        app.table->balls_released = true;
+    }
+}
+
+// FNV-1a over the raw bits of the ball positions
+void hash_balls(const Table* table, uint32_t& hash) {
+    for(const auto& b : table->balls) {
+        const uint8_t* bytes = (const uint8_t*)&b.p;
+        for(size_t i = 0; i < sizeof(b.p); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+}
+
+void trace_balls(FILE* trace, const Table* table, uint32_t frame) {
+    for(size_t i = 0; i < table->balls.size(); i++) {
+        const Vec2& p = table->balls[i].p;
+        fprintf(trace, "%u %u %.4f %.4f\n", frame, (unsigned)i, (double)p.x, (double)p.y);
+    }
+}
+
+// Replaces the table's balls with 'count' copies of its first ball, in rows
+// across the top of the table, and makes them the starting balls too
+void spawn_balls(Table* table, size_t count) {
+    Scalar r = table->balls_initial[0].r;
+    int gap = (int)(r * 3);
+    int per_row = 480 / gap;
+    table->balls.clear();
+    for(size_t i = 0; i < count; i++) {
+        Vec2 p(80 + (int)(i % per_row) * gap, 120 + (int)(i / per_row) * gap);
+        table->balls.push_back(Ball(p, r));
+        table->balls.back().add_velocity(Vec2((int)(i % 5) - 2, 0), .10f);
+    }
+    table->balls_initial = table->balls;
+}
+
+// Runs table 't' with 1, 2, 4 ... 64 balls, reloading it (and its balls) at
+// game over. Returns false if the table won't load.
+bool sweep_multiball(PinballApp& app, size_t t, const char* name, uint32_t frames) {
+    for(size_t count = 1; count <= 64; count *= 2) {
+        if(!table_load_table(&app, t + TABLE_INDEX_OFFSET)) {
+            return false;
+        }
+        spawn_balls(app.table, count);
+        app.game_mode = GM_Playing;
+
+        PhysicsStats total = {0, 0, 0, 0, 0};
+        std::chrono::nanoseconds elapsed(0);
+        uint32_t hash = 2166136261u;
+        for(uint32_t frame = 0; frame < frames; frame++) {
+            script_input(app, frame);
+
+            auto start = std::chrono::steady_clock::now();
+            solve(&app, PHYSICS_SUB_STEPS);
+            dispatch_collision_events(&app);
+            elapsed += std::chrono::steady_clock::now() - start;
+
+            hash_balls(app.table, hash);
+            app.table->step_animation();
+            if(app.table->game_over) {
+                total.substeps += app.table->stats.substeps;
+                total.ball_tests += app.table->stats.ball_tests;
+                total.ball_steps_asleep += app.table->stats.ball_steps_asleep;
+                table_load_table(&app, t + TABLE_INDEX_OFFSET);
+                spawn_balls(app.table, count);
+            }
+        }
+        total.substeps += app.table->stats.substeps;
+        total.ball_tests += app.table->stats.ball_tests;
+        total.ball_steps_asleep += app.table->stats.ball_steps_asleep;
+
+        double secs = std::chrono::duration<double>(elapsed).count();
+        printf(
+            "%-20s %6u %10.2f %14u %14.1f %7.1f%%   %08x\n",
+            name,
+            (unsigned)count,
+            secs * 1e6 / frames,
+            (unsigned)(count * (count - 1) / 2),
+            total.substeps ? (double)total.ball_tests / total.substeps : 0.0,
+            total.substeps ? 100.0 * total.ball_steps_asleep / (total.substeps * count) : 0.0,
+            (unsigned)hash);
+    }
+    return true;
+}
+
+void print_frame_profile(const FrameProfile& profile) {
+    if(!profile.valid) {
+        return;
+    }
+    double us = profile.cycles_per_us;
+    printf("  %-10s %8s %8s %8s\n", "us", "min", "avg", "max");
+    for(int i = 0; i < FrameSectionCount; i++) {
+        const FrameStat& stat = profile.last[i];
+        printf(
+            "  %-10s %8.2f %8.2f %8.2f\n",
+            frame_profile_section_name((FrameSection)i),
+            stat.min / us,
+            stat.avg / us,
+            stat.max / us);
+    }
+}
+
+bool matches(const char* name, int argc, char** argv, int first) {
+    if(first >= argc) {
+        return true;
+    }
+    for(int i = first; i < argc; i++) {
+        if(strstr(name, argv[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+int main(int argc, char** argv) {
+    float seconds = 10.0f;
+    const char* root = PINBALL_SOURCE_DIR;
+    const char* trace_path = nullptr;
+    std::string record_dir;
+    bool draw = false;
+    bool multiball = false;
+    bool profile = false;
+    int opt;
+    while((opt = getopt(argc, argv, "s:C:t:r:dmpv")) != -1) {
+        switch(opt) {
+        case 's':
+            seconds = atof(optarg);
+            break;
+        case 'C':
+            root = optarg;
+            break;
+        case 't':
+            trace_path = optarg;
+            break;
+        case 'r': {
+            // resolved before chdir, like the trace
+            char dir[PATH_MAX];
+            if(!realpath(optarg, dir)) {
+                fprintf(stderr, "Cannot find %s\n", optarg);
+                return 2;
+            }
+            record_dir = dir;
+        } break;
+        case 'd':
+            draw = true;
+            break;
+        case 'm':
+            multiball = true;
+            break;
+        case 'p':
+            profile = true;
+            break;
+        case 'v':
+            furi_log_set_level(FuriLogLevelInfo);
+            break;
+        default:
+            fprintf(
+                stderr,
+                "usage: %s [-s seconds] [-C repo_dir] [-t trace] [-r dir] [-d | -m] [-p] [-v] "
+                "[filter ...]\n",
+                argv[0]);
+            return 2;
+        }
+    }
+    // open the trace before chdir, so relative paths are where the user expects
+    FILE* trace = nullptr;
+    if(trace_path) {
+        trace = fopen(trace_path, "w");
+        if(!trace) {
+            fprintf(stderr, "Cannot write %s\n", trace_path);
+            return 2;
+        }
+    }
+    if(chdir(root) != 0) {
+        fprintf(stderr, "Cannot chdir to %s\n", root);
+        return 2;
+    }
+
+    PinballApp app;
+    table_table_list_init(&app);
+    if(profile) {
+        frame_profile_begin(&app.frame_profile);
+    }
+
+    const uint32_t frames = seconds * GAME_FPS;
+    int failures = 0;
+
+    DrawStats draw_stats;
+    draw_stats.layer = canvas_host_alloc(CanvasHostLayoutFlipper);
+    draw_stats.full = canvas_host_alloc(CanvasHostLayoutFlipper);
+
+    if(multiball) {
+        printf(
+            "multiball\n%-20s %6s %10s %14s %14s %8s %10s\n",
+            "table",
+            "balls",
+            "us/frame",
+            "pairs/substep",
+            "tested/substep",
+            "asleep",
+            "hash");
+    } else if(draw) {
+        printf(
+            "drawing\n%-20s %8s %14s %14s %8s %10s\n",
+            "table",
+            "frames",
+            "full us/frame",
+            "layer us/frame",
+            "speedup",
+            "mismatched");
+    } else {
+        printf(
+            "%s physics\n%-20s %8s %12s %14s %12s %10s %10s\n",
+#ifdef PINBALL_FIXED_POINT
+            "Q16.16 fixed-point",
+#else
+            "float",
+#endif
+            "table",
+            "frames",
+            "substeps/s",
+            "tests/s",
+            "collisions/s",
+            "us/frame",
+            "hash");
+    }
+
+    // the last menu item is SETTINGS, not a table
+    for(size_t t = 0; t + 1 < app.table_list.menu_items.size(); t++) {
+        const char* name = furi_string_get_cstr(app.table_list.menu_items[t].name);
+        const char* filename = furi_string_get_cstr(app.table_list.menu_items[t].filename);
+        if(!strcmp(filename, REPLAY_MENU_FILENAME) || !strcmp(filename, RESUME_MENU_FILENAME) ||
+           !matches(name, argc, argv, optind)) {
+            continue;
+        }
+        if(multiball) {
+            if(!sweep_multiball(app, t, name, frames)) {
+                printf("%-20s load failed\n", name);
+                failures++;
+            }
+            continue;
+        }
+        if(!table_load_table(&app, t + TABLE_INDEX_OFFSET)) {
+            for(char* c = app.text; *c; c++) {
+                if(*c == '\n') *c = ' ';
+            }
+            printf("%-20s load failed: %s\n", name, app.text);
+            failures++;
+            continue;
+        }
+        app.game_mode = GM_Playing;
+        if(trace) {
+            fprintf(trace, "table %s\n", name);
+        }
+        if(!record_dir.empty() &&
+           !replay_record(&app, (record_dir + "/" + name + ".pbr").c_str(), name)) {
+            printf("%-20s cannot record\n", name);
+            failures++;
+        }
+
+        PhysicsStats total = {0, 0, 0, 0, 0};
+        std::chrono::nanoseconds elapsed(0);
+        draw_stats.layer_time = draw_stats.full_time = std::chrono::nanoseconds(0);
+        draw_stats.mismatches = 0;
+        uint32_t hash = 2166136261u;
+        for(uint32_t frame = 0; frame < frames; frame++) {
+            script_input(app, frame);
+            uint32_t steps = PHYSICS_SUB_STEPS;
+            replay_frame(&app, &steps);
+
+            auto start = std::chrono::steady_clock::now();
+            solve(&app, steps);
+            dispatch_collision_events(&app);
+            elapsed += std::chrono::steady_clock::now() - start;
+
+            replay_frame_done(&app, steps);
+            hash_balls(app.table, hash);
+            if(trace) {
+                trace_balls(trace, app.table, frame);
+            }
+            if(draw) {
+                draw_frame(app.table, draw_stats);
+            }
+
+            app.table->step_animation();
+            frame_profile_end_frame();
+            if(app.table->game_over) {
+                // keep playing: fold the stats into the total and start over
+                replay_end(&app);
+                total.substeps += app.table->stats.substeps;
+                total.collision_tests += app.table->stats.collision_tests;
+                total.collisions += app.table->stats.collisions;
+                table_load_table(&app, t + TABLE_INDEX_OFFSET);
+            }
+        }
+        total.substeps += app.table->stats.substeps;
+        total.collision_tests += app.table->stats.collision_tests;
+        total.collisions += app.table->stats.collisions;
+        replay_end(&app);
+
+        if(draw) {
+            double full = std::chrono::duration<double>(draw_stats.full_time).count();
+            double layer = std::chrono::duration<double>(draw_stats.layer_time).count();
+            printf(
+                "%-20s %8u %14.2f %14.2f %7.1fx %10u\n",
+                name,
+                frames,
+                full * 1e6 / frames,
+                layer * 1e6 / frames,
+                layer > 0 ? full / layer : 0.0,
+                (unsigned)draw_stats.mismatches);
+            failures += draw_stats.mismatches != 0;
+            if(profile) {
+                print_frame_profile(app.frame_profile);
+            }
+            continue;
+        }
+
+        double secs = std::chrono::duration<double>(elapsed).count();
+        if(secs <= 0) {
+            secs = 1e-9;
+        }
+        printf(
+            "%-20s %8u %12.0f %14.0f %12.0f %10.2f   %08x\n",
+            name,
+            frames,
+            total.substeps / secs,
+            total.collision_tests / secs,
+            total.collisions / secs,
+            secs * 1e6 / frames,
+            (unsigned)hash);
+        if(profile) {
+            print_frame_profile(app.frame_profile);
+        }
+    }
+    if(trace) {
+        fclose(trace);
+    }
+    canvas_host_free(draw_stats.layer);
+    canvas_host_free(draw_stats.full);
+
+    // the error table is expected to fail, anything else is a regression
+    return failures > 1 ? 1 : 0;
+}
@@ -0,0 +1,269 @@
+// Host Canvas stand-in: a 64 x 128 1-bit framebuffer, laid out either as an
+// XBM image or the way the Flipper's portrait screen is. Dots, lines, boxes,
+// circles and discs are drawn with the same algorithms as the Flipper's u8g2;
+// text, triangles and icons are accepted and discarded.
+
+#include <gui/canvas.h>
+#include <stdlib.h>
+
+#define CANVAS_WIDTH  64
+#define CANVAS_HEIGHT 128
+
+struct Canvas {
+    uint8_t buffer[CANVAS_WIDTH * CANVAS_HEIGHT / 8];
+    CanvasHostLayout layout;
+    Color color;
+};
+
+namespace {
+uint8_t& pixel_byte(Canvas* canvas, int32_t x, int32_t y, uint8_t* bit) {
+    if(canvas->layout == CanvasHostLayoutFlipper) {
+        // the 128 x 64 panel turned on its side: 8 pages of 128 vertical bytes
+        int32_t py = CANVAS_WIDTH - 1 - x;
+        *bit = 1 << (py % 8);
+        return canvas->buffer[(py / 8) * CANVAS_HEIGHT + y];
+    }
+    // row-major, least significant bit on the left (as XBM)
+    *bit = 1 << (x % 8);
+    return canvas->buffer[y * (CANVAS_WIDTH / 8) + x / 8];
+}
+
+void draw_pixel(Canvas* canvas, int32_t x, int32_t y) {
+    if(x < 0 || x >= CANVAS_WIDTH || y < 0 || y >= CANVAS_HEIGHT) {
+        return;
+    }
+    uint8_t bit;
+    uint8_t& byte = pixel_byte(canvas, x, y, &bit);
+    switch(canvas->color) {
+    case ColorWhite:
+        byte &= ~bit;
+        break;
+    case ColorBlack:
+        byte |= bit;
+        break;
+    case ColorXOR:
+        byte ^= bit;
+        break;
+    }
+}
+
+void draw_vline(Canvas* canvas, int32_t x, int32_t y, int32_t h) {
+    if(x < 0 || x >= CANVAS_WIDTH) {
+        return;
+    }
+    for(int32_t i = y < 0 ? -y : 0; i < h && y + i < CANVAS_HEIGHT; i++) {
+        draw_pixel(canvas, x, y + i);
+    }
+}
+
+void draw_circle_section(Canvas* canvas, int32_t x, int32_t y, int32_t x0, int32_t y0) {
+    draw_pixel(canvas, x0 + x, y0 - y);
+    draw_pixel(canvas, x0 + y, y0 - x);
+    draw_pixel(canvas, x0 - x, y0 - y);
+    draw_pixel(canvas, x0 - y, y0 - x);
+    draw_pixel(canvas, x0 - x, y0 + y);
+    draw_pixel(canvas, x0 - y, y0 + x);
+    draw_pixel(canvas, x0 + x, y0 + y);
+    draw_pixel(canvas, x0 + y, y0 + x);
+}
+
+void draw_disc_section(Canvas* canvas, int32_t x, int32_t y, int32_t x0, int32_t y0) {
+    draw_vline(canvas, x0 + x, y0 - y, y + 1);
+    draw_vline(canvas, x0 + y, y0 - x, x + 1);
+    draw_vline(canvas, x0 - x, y0 - y, y + 1);
+    draw_vline(canvas, x0 - y, y0 - x, x + 1);
+    draw_vline(canvas, x0 - x, y0, y + 1);
+    draw_vline(canvas, x0 - y, y0, x + 1);
+    draw_vline(canvas, x0 + x, y0, y + 1);
+    draw_vline(canvas, x0 + y, y0, x + 1);
+}
+
+// Midpoint circle, calling 'section' for each octant step
+void draw_round(
+    Canvas* canvas,
+    int32_t x0,
+    int32_t y0,
+    int32_t r,
+    void (*section)(Canvas*, int32_t, int32_t, int32_t, int32_t)) {
+    // like u8g2, skip anything entirely off screen
+    if(x0 + r < 0 || x0 - r >= CANVAS_WIDTH || y0 + r < 0 || y0 - r >= CANVAS_HEIGHT) {
+        return;
+    }
+    int32_t f = 1 - r;
+    int32_t ddf_x = 1;
+    int32_t ddf_y = -2 * r;
+    int32_t x = 0;
+    int32_t y = r;
+    section(canvas, x, y, x0, y0);
+    while(x < y) {
+        if(f >= 0) {
+            y--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+        x++;
+        ddf_x += 2;
+        f += ddf_x;
+        section(canvas, x, y, x0, y0);
+    }
+}
+}
+
+Canvas* canvas_host_alloc(CanvasHostLayout layout) {
+    Canvas* canvas = new Canvas();
+    canvas->layout = layout;
+    canvas_clear(canvas);
+    return canvas;
+}
+
+bool canvas_host_get_pixel(Canvas* canvas, int32_t x, int32_t y) {
+    if(x < 0 || x >= CANVAS_WIDTH || y < 0 || y >= CANVAS_HEIGHT) {
+        return false;
+    }
+    uint8_t bit;
+    return pixel_byte(canvas, x, y, &bit) & bit;
+}
+
+void canvas_host_free(Canvas* canvas) {
+    delete canvas;
+}
+
+void canvas_clear(Canvas* canvas) {
+    memset(canvas->buffer, 0, sizeof(canvas->buffer));
+    canvas->color = ColorBlack;
+}
+
+uint8_t* canvas_get_buffer(Canvas* canvas) {
+    return canvas->buffer;
+}
+
+size_t canvas_get_buffer_size(const Canvas* canvas) {
+    return sizeof(canvas->buffer);
+}
+
+void canvas_set_color(Canvas* canvas, Color color) {
+    canvas->color = color;
+}
+
+void canvas_set_font(Canvas* canvas, Font font) {
+    UNUSED(canvas);
+    UNUSED(font);
+}
+
+void canvas_set_custom_u8g2_font(Canvas* canvas, const uint8_t* font) {
+    UNUSED(canvas);
+    UNUSED(font);
+}
+
+size_t canvas_string_width(Canvas* canvas, const char* str) {
+    UNUSED(canvas);
+    return strlen(str) * 4;
+}
+
+void canvas_draw_dot(Canvas* canvas, int32_t x, int32_t y) {
+    draw_pixel(canvas, x, y);
+}
+
+// Bresenham, stepping along the major axis from the lower end
+void canvas_draw_line(Canvas* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    int32_t dx = abs(x2 - x1);
+    int32_t dy = abs(y2 - y1);
+    bool swapxy = dy > dx;
+    if(swapxy) {
+        int32_t t = dx;
+        dx = dy;
+        dy = t;
+        t = x1;
+        x1 = y1;
+        y1 = t;
+        t = x2;
+        x2 = y2;
+        y2 = t;
+    }
+    if(x1 > x2) {
+        int32_t t = x1;
+        x1 = x2;
+        x2 = t;
+        t = y1;
+        y1 = y2;
+        y2 = t;
+    }
+    int32_t err = dx >> 1;
+    int32_t ystep = y2 > y1 ? 1 : -1;
+    int32_t y = y1;
+    for(int32_t x = x1; x <= x2; x++) {
+        if(swapxy) {
+            draw_pixel(canvas, y, x);
+        } else {
+            draw_pixel(canvas, x, y);
+        }
+        err -= dy;
+        if(err < 0) {
+            y += ystep;
+            err += dx;
+        }
+    }
+}
+
+// Clipped to the screen, so oversized (or wrapped negative) sizes stop at the edge
+void canvas_draw_box(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height) {
+    int64_t x1 = (int64_t)x + (width < INT32_MAX ? width : INT32_MAX);
+    int64_t y1 = (int64_t)y + (height < INT32_MAX ? height : INT32_MAX);
+    x1 = x1 < CANVAS_WIDTH ? x1 : CANVAS_WIDTH;
+    y1 = y1 < CANVAS_HEIGHT ? y1 : CANVAS_HEIGHT;
+    for(int64_t i = x < 0 ? 0 : x; i < x1; i++) {
+        draw_vline(canvas, i, y, y1 - y);
+    }
+}
+
+void canvas_draw_circle(Canvas* canvas, int32_t x, int32_t y, size_t radius) {
+    draw_round(canvas, x, y, radius, draw_circle_section);
+}
+
+void canvas_draw_disc(Canvas* canvas, int32_t x, int32_t y, size_t radius) {
+    draw_round(canvas, x, y, radius, draw_disc_section);
+}
+
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(str);
+}
+
+void canvas_draw_str_aligned(
+    Canvas* canvas,
+    int32_t x,
+    int32_t y,
+    Align horizontal,
+    Align vertical,
+    const char* str) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(horizontal);
+    UNUSED(vertical);
+    UNUSED(str);
+}
+
+void canvas_draw_triangle(
+    Canvas* canvas,
+    int32_t x,
+    int32_t y,
+    size_t base,
+    size_t height,
+    CanvasDirection dir) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(base);
+    UNUSED(height);
+    UNUSED(dir);
+}
+
+void canvas_draw_icon(Canvas* canvas, int32_t x, int32_t y, const Icon* icon) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(icon);
+}
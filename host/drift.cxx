@@ -0,0 +1,125 @@
+// Compares two ball trajectory traces written by pinball0_bench -t, typically
+// one from the float build and one from the fixed-point build, and reports per
+// table how far apart the balls drift and how long they stay together.
+//
+// usage: pinball0_drift [-d distance] a.trace b.trace
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef struct {
+    unsigned frame;
+    unsigned ball;
+    double x, y;
+} Sample;
+
+typedef struct {
+    std::string name;
+    std::vector<Sample> samples;
+} Run;
+
+// Trace format: "table <name>" starts a run, then one "<frame> <ball> <x> <y>"
+// line per ball per frame
+bool read_trace(const char* path, std::vector<Run>& runs) {
+    FILE* f = fopen(path, "r");
+    if(!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    while(fgets(line, sizeof(line), f)) {
+        if(strncmp(line, "table ", 6) == 0) {
+            line[strcspn(line, "\n")] = 0;
+            runs.push_back({line + 6, {}});
+            continue;
+        }
+        Sample s;
+        if(!runs.empty() && sscanf(line, "%u %u %lf %lf", &s.frame, &s.ball, &s.x, &s.y) == 4) {
+            runs.back().samples.push_back(s);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    double limit = 10.0;
+    int opt;
+    while((opt = getopt(argc, argv, "d:")) != -1) {
+        switch(opt) {
+        case 'd':
+            limit = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-d distance] a.trace b.trace\n", argv[0]);
+            return 2;
+        }
+    }
+    if(argc - optind != 2) {
+        fprintf(stderr, "usage: %s [-d distance] a.trace b.trace\n", argv[0]);
+        return 2;
+    }
+    std::vector<Run> a, b;
+    if(!read_trace(argv[optind], a) || !read_trace(argv[optind + 1], b)) {
+        return 2;
+    }
+
+    printf(
+        "%-20s %8s %12s %12s %14s\n", "table", "samples", "mean drift", "max drift", "frames < limit");
+    for(const Run& ra : a) {
+        const Run* rb = nullptr;
+        for(const Run& r : b) {
+            if(r.name == ra.name) {
+                rb = &r;
+                break;
+            }
+        }
+        if(!rb) {
+            printf("%-20s missing from %s\n", ra.name.c_str(), argv[optind + 1]);
+            continue;
+        }
+        // samples line up as long as both runs have the same balls in play
+        size_t n = ra.samples.size() < rb->samples.size() ? ra.samples.size() :
+                                                            rb->samples.size();
+        double sum = 0, max = 0;
+        unsigned diverged = 0;
+        bool together = true;
+        size_t i = 0;
+        for(; i < n; i++) {
+            const Sample& sa = ra.samples[i];
+            const Sample& sb = rb->samples[i];
+            if(sa.frame != sb.frame || sa.ball != sb.ball) {
+                break;
+            }
+            double d = hypot(sa.x - sb.x, sa.y - sb.y);
+            sum += d;
+            if(d > max) {
+                max = d;
+            }
+            if(together && d > limit) {
+                together = false;
+                diverged = sa.frame;
+            }
+        }
+        if(together) {
+            diverged = i ? ra.samples[i - 1].frame + 1 : 0;
+        }
+        printf(
+            "%-20s %8zu %12.3f %12.3f %14u\n",
+            ra.name.c_str(),
+            i,
+            i ? sum / i : 0.0,
+            max,
+            diverged);
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+// Host implementations of the furi / storage / toolbox stand-ins
+
+#include <furi.h>
+#include <furi_hal.h>
+#include <storage/storage.h>
+#include <toolbox/dir_walk.h>
+#include <toolbox/path.h>
+
+#include <chrono>
+#include <string>
+#include <stdarg.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <sys/stat.h>
+
+struct FuriString {
+    std::string s;
+};
+
+struct File {
+    FILE* fp;
+};
+
+struct DirWalk {
+    DIR* dir;
+    std::string path;
+};
+
+namespace {
+FuriLogLevel log_level = FuriLogLevelWarn;
+const auto start_time = std::chrono::steady_clock::now();
+}
+
+void furi_log_set_level(FuriLogLevel level) {
+    log_level = level;
+}
+
+void furi_log_print_format(FuriLogLevel level, const char* tag, const char* format, ...) {
+    if(level > log_level) {
+        return;
+    }
+    const char* prefix = "EWIDT";
+    fprintf(stderr, "[%c][%s] ", prefix[level - 1], tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+uint32_t furi_get_tick(void) {
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+size_t memmgr_get_free_heap(void) {
+    const size_t heap_size = 1024 * 1024;
+    size_t used = mallinfo2().uordblks;
+    return used < heap_size ? heap_size - used : 0;
+}
+
+HostDwt* furi_hal_host_dwt(void) {
+    static HostDwt dwt;
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    dwt.CYCCNT = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() * 64 / 1000;
+    return &dwt;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 64;
+}
+
+FuriString* furi_string_alloc(void) {
+    return new FuriString();
+}
+
+FuriString* furi_string_alloc_set_str(const char* cstr) {
+    return new FuriString{cstr};
+}
+
+void furi_string_free(FuriString* string) {
+    delete string;
+}
+
+void furi_string_set_str(FuriString* string, const char* cstr) {
+    string->s = cstr;
+}
+
+const char* furi_string_get_cstr(const FuriString* string) {
+    return string->s.c_str();
+}
+
+char furi_string_get_char(const FuriString* string, size_t index) {
+    return index < string->s.size() ? string->s[index] : '\0';
+}
+
+size_t furi_string_size(const FuriString* string) {
+    return string->s.size();
+}
+
+void furi_string_right(FuriString* string, size_t index) {
+    string->s.erase(0, index);
+}
+
+void furi_string_left(FuriString* string, size_t index) {
+    if(index < string->s.size()) {
+        string->s.erase(index);
+    }
+}
+
+void furi_string_cat_str(FuriString* string, const char* cstr) {
+    string->s += cstr;
+}
+
+size_t furi_string_search_rchar(const FuriString* string, char c, size_t start) {
+    if(start >= string->s.size()) {
+        return FURI_STRING_FAILURE;
+    }
+    size_t pos = string->s.rfind(c);
+    return pos == std::string::npos || pos < start ? FURI_STRING_FAILURE : pos;
+}
+
+File* storage_file_alloc(Storage* storage) {
+    UNUSED(storage);
+    return new File{nullptr};
+}
+
+void storage_file_free(File* file) {
+    storage_file_close(file);
+    delete file;
+}
+
+bool storage_file_open(File* file, const char* path, FS_AccessMode access_mode, FS_OpenMode open_mode) {
+    const char* mode = "rb";
+    if(access_mode & FSAM_WRITE) {
+        mode = open_mode == FSOM_OPEN_APPEND ? "ab" :
+               open_mode == FSOM_OPEN_EXISTING ? "r+b" :
+                                                 "wb";
+    }
+    file->fp = fopen(path, mode);
+    return file->fp != nullptr;
+}
+
+bool storage_file_close(File* file) {
+    if(file->fp) {
+        fclose(file->fp);
+        file->fp = nullptr;
+    }
+    return true;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    return file->fp ? fread(buff, 1, bytes_to_read, file->fp) : 0;
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    return file->fp ? fwrite(buff, 1, bytes_to_write, file->fp) : 0;
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    return file->fp && fseek(file->fp, offset, from_start ? SEEK_SET : SEEK_CUR) == 0;
+}
+
+uint64_t storage_file_tell(File* file) {
+    long pos = file->fp ? ftell(file->fp) : -1;
+    return pos < 0 ? 0 : pos;
+}
+
+uint64_t storage_file_size(File* file) {
+    struct stat st;
+    if(!file->fp || fstat(fileno(file->fp), &st) != 0) {
+        return 0;
+    }
+    return st.st_size;
+}
+
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo) {
+    UNUSED(storage);
+    struct stat st;
+    if(stat(path, &st) != 0) {
+        return FSE_NOT_EXIST;
+    }
+    if(fileinfo) {
+        fileinfo->flags = S_ISDIR(st.st_mode) ? FSF_DIRECTORY : 0;
+        fileinfo->size = st.st_size;
+    }
+    return FSE_OK;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    UNUSED(storage);
+    return remove(path) == 0 ? FSE_OK : FSE_NOT_EXIST;
+}
+
+FS_Error storage_common_timestamp(Storage* storage, const char* path, uint32_t* timestamp) {
+    UNUSED(storage);
+    struct stat st;
+    if(stat(path, &st) != 0) {
+        return FSE_NOT_EXIST;
+    }
+    *timestamp = st.st_mtime;
+    return FSE_OK;
+}
+
+DirWalk* dir_walk_alloc(Storage* storage) {
+    UNUSED(storage);
+    return new DirWalk{nullptr, ""};
+}
+
+void dir_walk_free(DirWalk* dir_walk) {
+    dir_walk_close(dir_walk);
+    delete dir_walk;
+}
+
+void dir_walk_set_recursive(DirWalk* dir_walk, bool recursive) {
+    UNUSED(dir_walk);
+    UNUSED(recursive);
+}
+
+bool dir_walk_open(DirWalk* dir_walk, const char* path) {
+    dir_walk->dir = opendir(path);
+    dir_walk->path = path;
+    return dir_walk->dir != nullptr;
+}
+
+DirWalkResult dir_walk_read(DirWalk* dir_walk, FuriString* return_path, FileInfo* fileinfo) {
+    if(!dir_walk->dir) {
+        return DirWalkError;
+    }
+    while(struct dirent* entry = readdir(dir_walk->dir)) {
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
+        return_path->s = dir_walk->path + "/" + entry->d_name;
+        if(fileinfo) {
+            storage_common_stat(nullptr, return_path->s.c_str(), fileinfo);
+        }
+        return DirWalkOK;
+    }
+    return DirWalkLast;
+}
+
+void dir_walk_close(DirWalk* dir_walk) {
+    if(dir_walk->dir) {
+        closedir(dir_walk->dir);
+        dir_walk->dir = nullptr;
+    }
+}
+
+void path_extract_filename_no_ext(const char* path, FuriString* filename) {
+    std::string s = path;
+    size_t slash = s.rfind('/');
+    if(slash != std::string::npos) {
+        s.erase(0, slash + 1);
+    }
+    size_t dot = s.rfind('.');
+    if(dot != std::string::npos) {
+        s.erase(dot);
+    }
+    filename->s = s;
+}
+
+void path_extract_extension(FuriString* path, char* ext, size_t ext_len_max) {
+    const std::string& s = path->s;
+    size_t dot = s.rfind('.');
+    size_t slash = s.rfind('/');
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        ext[0] = '\0';
+        return;
+    }
+    snprintf(ext, ext_len_max, "%s", s.c_str() + dot);
+}
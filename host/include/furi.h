@@ -0,0 +1,77 @@
+#pragma once
+// Host stand-in for the parts of the Flipper Zero furi API used by the
+// physics core and table loader. Just enough to compile and run on Linux.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UNUSED(x) (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+
+#define furi_assert(x) assert(x)
+#define furi_check(x)  assert(x)
+
+// Table assets are read relative to the working directory
+#define APP_ASSETS_PATH(path) "assets/" path
+#define APP_DATA_PATH(path)   "data/" path
+
+// newlib provides this, glibc does not
+#define infinityf() __builtin_inff()
+
+typedef enum {
+    FuriLogLevelNone = 0,
+    FuriLogLevelError,
+    FuriLogLevelWarn,
+    FuriLogLevelInfo,
+    FuriLogLevelDebug,
+    FuriLogLevelTrace,
+} FuriLogLevel;
+
+// Messages above this level are dropped. Defaults to FuriLogLevelWarn.
+void furi_log_set_level(FuriLogLevel level);
+void furi_log_print_format(FuriLogLevel level, const char* tag, const char* format, ...);
+
+#define FURI_LOG_E(tag, ...) furi_log_print_format(FuriLogLevelError, tag, __VA_ARGS__)
+#define FURI_LOG_W(tag, ...) furi_log_print_format(FuriLogLevelWarn, tag, __VA_ARGS__)
+#define FURI_LOG_I(tag, ...) furi_log_print_format(FuriLogLevelInfo, tag, __VA_ARGS__)
+#define FURI_LOG_D(tag, ...) furi_log_print_format(FuriLogLevelDebug, tag, __VA_ARGS__)
+#define FURI_LOG_T(tag, ...) furi_log_print_format(FuriLogLevelTrace, tag, __VA_ARGS__)
+
+// Milliseconds since the process started
+uint32_t furi_get_tick(void);
+
+// Free bytes of a nominal 1 MiB heap, from malloc's own accounting. Only
+// differences between readings mean anything.
+size_t memmgr_get_free_heap(void);
+
+typedef struct FuriMutex FuriMutex;
+typedef struct FuriMessageQueue FuriMessageQueue;
+
+typedef struct FuriString FuriString;
+
+FuriString* furi_string_alloc(void);
+FuriString* furi_string_alloc_set_str(const char* cstr);
+void furi_string_free(FuriString* string);
+void furi_string_set_str(FuriString* string, const char* cstr);
+const char* furi_string_get_cstr(const FuriString* string);
+char furi_string_get_char(const FuriString* string, size_t index);
+size_t furi_string_size(const FuriString* string);
+void furi_string_right(FuriString* string, size_t index);
+void furi_string_left(FuriString* string, size_t index);
+void furi_string_cat_str(FuriString* string, const char* cstr);
+size_t furi_string_search_rchar(const FuriString* string, char c, size_t start);
+
+#define FURI_STRING_FAILURE ((size_t) - 1)
+
+#ifdef __cplusplus
+}
+#endif
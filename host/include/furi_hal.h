@@ -0,0 +1,24 @@
+#pragma once
+// Host stand-in for the cycle counter. DWT->CYCCNT reads a steady clock
+// scaled to the Flipper's 64 MHz, so cycle counts convert to microseconds the
+// same way they do on the device.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t CYCCNT;
+} HostDwt;
+
+// Refreshes CYCCNT on every access
+HostDwt* furi_hal_host_dwt(void);
+#define DWT (furi_hal_host_dwt())
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
+
+#ifdef __cplusplus
+}
+#endif
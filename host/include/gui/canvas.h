@@ -0,0 +1,86 @@
+#pragma once
+// Host stand-in for the Canvas API, drawing into a 64 x 128 1-bit framebuffer.
+// Text, triangles and icons are accepted and ignored.
+
+#include <furi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ColorWhite = 0x00,
+    ColorBlack = 0x01,
+    ColorXOR = 0x02,
+} Color;
+
+typedef enum {
+    FontPrimary,
+    FontSecondary,
+    FontKeyboard,
+    FontBigNumbers,
+} Font;
+
+typedef enum {
+    AlignLeft,
+    AlignRight,
+    AlignTop,
+    AlignBottom,
+    AlignCenter,
+} Align;
+
+typedef enum {
+    CanvasDirectionLeftToRight,
+    CanvasDirectionTopToBottom,
+    CanvasDirectionRightToLeft,
+    CanvasDirectionBottomToTop,
+} CanvasDirection;
+
+typedef struct Canvas Canvas;
+typedef struct Icon Icon;
+
+// Host only: framebuffer layouts
+typedef enum {
+    CanvasHostLayoutXbm, // row-major, least significant bit leftmost
+    CanvasHostLayoutFlipper, // u8g2 pages of the 128 x 64 panel, rotated to portrait
+} CanvasHostLayout;
+
+// Host only: a blank canvas, freeing it, and reading a pixel back
+Canvas* canvas_host_alloc(CanvasHostLayout layout);
+void canvas_host_free(Canvas* canvas);
+bool canvas_host_get_pixel(Canvas* canvas, int32_t x, int32_t y);
+
+void canvas_clear(Canvas* canvas);
+uint8_t* canvas_get_buffer(Canvas* canvas);
+size_t canvas_get_buffer_size(const Canvas* canvas);
+
+void canvas_set_color(Canvas* canvas, Color color);
+void canvas_set_font(Canvas* canvas, Font font);
+void canvas_set_custom_u8g2_font(Canvas* canvas, const uint8_t* font);
+size_t canvas_string_width(Canvas* canvas, const char* str);
+
+void canvas_draw_dot(Canvas* canvas, int32_t x, int32_t y);
+void canvas_draw_line(Canvas* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+void canvas_draw_box(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height);
+void canvas_draw_circle(Canvas* canvas, int32_t x, int32_t y, size_t radius);
+void canvas_draw_disc(Canvas* canvas, int32_t x, int32_t y, size_t radius);
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str);
+void canvas_draw_str_aligned(
+    Canvas* canvas,
+    int32_t x,
+    int32_t y,
+    Align horizontal,
+    Align vertical,
+    const char* str);
+void canvas_draw_triangle(
+    Canvas* canvas,
+    int32_t x,
+    int32_t y,
+    size_t base,
+    size_t height,
+    CanvasDirection dir);
+void canvas_draw_icon(Canvas* canvas, int32_t x, int32_t y, const Icon* icon);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+// Host stand-in for the notification service types
+
+#include <furi.h>
+
+typedef struct NotificationApp NotificationApp;
+typedef struct NotificationMessage NotificationMessage;
+typedef const NotificationMessage* NotificationSequence[];
+
+#define RECORD_NOTIFICATION "notification"
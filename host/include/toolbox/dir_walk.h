@@ -0,0 +1,28 @@
+#pragma once
+// Host stand-in for DirWalk, backed by opendir()
+
+#include <furi.h>
+#include <storage/storage.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct DirWalk DirWalk;
+
+typedef enum {
+    DirWalkOK,
+    DirWalkError,
+    DirWalkLast,
+} DirWalkResult;
+
+DirWalk* dir_walk_alloc(Storage* storage);
+void dir_walk_free(DirWalk* dir_walk);
+void dir_walk_set_recursive(DirWalk* dir_walk, bool recursive);
+bool dir_walk_open(DirWalk* dir_walk, const char* path);
+DirWalkResult dir_walk_read(DirWalk* dir_walk, FuriString* return_path, FileInfo* fileinfo);
+void dir_walk_close(DirWalk* dir_walk);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+#include <furi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void path_extract_filename_no_ext(const char* path, FuriString* filename);
+void path_extract_extension(FuriString* path, char* ext, size_t ext_len_max);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+// Table load benchmark. Loads every table file in assets/tables, JSON and .pb0
+// alike, through table_load_table_from_file() and reports the load profile
+// (see load_profile.h): the fastest time per phase over -n loads, and the
+// allocations, heap peak and table arena use of a load.
+//
+// Table warnings are only shown with -v, along with the app's own report of
+// each load.
+//
+// usage: pinball0_loadbench [-n loads] [-C repo_dir] [-v] [file_name_filter ...]
+
+#include <algorithm>
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "pinball0.h"
+#include "table.h"
+
+namespace {
+
+bool matches(const char* name, int argc, char** argv, int first) {
+    if(first >= argc) {
+        return true;
+    }
+    for(int i = first; i < argc; i++) {
+        if(strstr(name, argv[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int loads = 20;
+    furi_log_set_level(FuriLogLevelNone); // the same warnings on every load
+    const char* root = PINBALL_SOURCE_DIR;
+    int opt;
+    while((opt = getopt(argc, argv, "n:C:v")) != -1) {
+        switch(opt) {
+        case 'n':
+            loads = std::max(1, atoi(optarg));
+            break;
+        case 'C':
+            root = optarg;
+            break;
+        case 'v':
+            furi_log_set_level(FuriLogLevelInfo);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n loads] [-C repo_dir] [-v] [filter ...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if(chdir(root) != 0) {
+        fprintf(stderr, "Cannot chdir to %s\n", root);
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    DIR* dir = opendir(APP_ASSETS_PATH("tables"));
+    if(!dir) {
+        fprintf(stderr, "Cannot read %s/" APP_ASSETS_PATH("tables") "\n", root);
+        return 2;
+    }
+    while(struct dirent* e = readdir(dir)) {
+        if(e->d_name[0] != '.' && matches(e->d_name, argc, argv, optind)) {
+            files.push_back(e->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+
+    // one menu item per file, so each is loaded as is
+    PinballApp app;
+    for(const auto& f : files) {
+        std::string path = APP_ASSETS_PATH("tables/") + f;
+        app.table_list.menu_items.push_back(
+            {furi_string_alloc_set_str(f.c_str()), furi_string_alloc_set_str(path.c_str())});
+    }
+
+    printf("%-26s", "file (us, fastest load)");
+    for(int p = 0; p <= LoadPhaseCount; p++) {
+        printf(" %8s", load_profile_phase_name((LoadPhase)p));
+    }
+    printf(" %7s %10s %13s\n", "allocs", "heap peak", "arena");
+
+    int failures = 0;
+    for(size_t t = 0; t < files.size(); t++) {
+        uint32_t best[LoadPhaseCount + 1];
+        std::fill(best, best + LoadPhaseCount + 1, UINT32_MAX);
+        bool ok = true;
+        for(int i = 0; i < loads; i++) {
+            ok = table_load_table(&app, t + TABLE_INDEX_OFFSET);
+            for(int p = 0; p <= LoadPhaseCount; p++) {
+                best[p] = std::min(best[p], load_profile_us(&app.load_profile, (LoadPhase)p));
+            }
+        }
+        const LoadProfile& profile = app.load_profile;
+        printf("%-26s", files[t].c_str());
+        for(int p = 0; p <= LoadPhaseCount; p++) {
+            printf(" %8u", (unsigned)best[p]);
+        }
+        printf(
+            " %7u %10u",
+            (unsigned)load_profile_allocs(&profile),
+            (unsigned)(profile.heap_start - profile.heap_min));
+        if(ok) {
+            printf(
+                " %6u/%-6u\n",
+                (unsigned)app.table->arena.used(),
+                (unsigned)app.table->arena.capacity());
+        } else {
+            printf(" (failed)\n");
+        }
+        failures += !ok;
+    }
+
+    // the error table is expected to fail, once per format
+    return failures > 2 ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// Compiles JSON tables into the binary .pb0 format described in table_format.h,
+// using the app's own JSON reader so both always agree. Each table.json is
+// written to table.pb0 alongside it, or to -o when compiling a single file.
+//
+// usage: pinball0_pb0c [-o out.pb0] [-v] table.json ...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "pinball0.h"
+#include "table.h"
+#include "table_format.h"
+
+namespace {
+
+typedef struct {
+    std::vector<uint8_t> data;
+    size_t count;
+} RecordBuffer;
+
+bool append_record(void* ctx, uint8_t type, const Pb0Record& record) {
+    RecordBuffer* buf = (RecordBuffer*)ctx;
+    Pb0RecordHeader rh = {type, (uint8_t)pb0_record_size(type)};
+    const uint8_t* p = (const uint8_t*)&rh;
+    buf->data.insert(buf->data.end(), p, p + sizeof(rh));
+    p = (const uint8_t*)&record;
+    buf->data.insert(buf->data.end(), p, p + rh.size);
+    buf->count++;
+    return buf->count <= UINT16_MAX;
+}
+
+size_t file_read(void* ctx, char* buf, size_t size) {
+    return fread(buf, 1, size, (FILE*)ctx);
+}
+
+bool compile(const char* in, const std::string& out) {
+    FILE* in_file = fopen(in, "rb");
+    if(!in_file) {
+        fprintf(stderr, "%s: cannot read\n", in);
+        return false;
+    }
+    Pb0Header header;
+    RecordBuffer records = {{}, 0};
+    bool ok = table_json_read(file_read, in_file, &header, append_record, &records);
+    fseek(in_file, 0, SEEK_END);
+    long json_size = ftell(in_file);
+    fclose(in_file);
+    if(!ok) {
+        fprintf(stderr, "%s: invalid JSON, or too many records\n", in);
+        return false;
+    }
+    header.record_count = records.count;
+
+    FILE* f = fopen(out.c_str(), "wb");
+    if(!f) {
+        fprintf(stderr, "%s: cannot write\n", out.c_str());
+        return false;
+    }
+    ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+         fwrite(records.data.data(), 1, records.data.size(), f) == records.data.size();
+    ok = fclose(f) == 0 && ok;
+    if(!ok) {
+        fprintf(stderr, "%s: write failed\n", out.c_str());
+        return false;
+    }
+    printf(
+        "%s -> %s: %zu records, %zu bytes (JSON %ld bytes)\n",
+        in,
+        out.c_str(),
+        records.count,
+        sizeof(header) + records.data.size(),
+        json_size);
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* out = nullptr;
+    int opt;
+    while((opt = getopt(argc, argv, "o:v")) != -1) {
+        switch(opt) {
+        case 'o':
+            out = optarg;
+            break;
+        case 'v':
+            furi_log_set_level(FuriLogLevelInfo);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-o out.pb0] [-v] table.json ...\n", argv[0]);
+            return 2;
+        }
+    }
+    if(optind >= argc || (out && argc - optind != 1)) {
+        fprintf(stderr, "usage: %s [-o out.pb0] [-v] table.json ...\n", argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    for(int i = optind; i < argc; i++) {
+        std::string path = out ? out : argv[i];
+        if(!out) {
+            size_t dot = path.rfind('.');
+            size_t slash = path.rfind('/');
+            if(dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+                path.erase(dot);
+            }
+            path += ".pb0";
+        }
+        if(!compile(argv[i], path)) {
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,279 @@
+// Golden-image test for the gfx_* drawing functions. Each scene is drawn into
+// a blank host canvas, in both the XBM and the Flipper framebuffer layouts,
+// and compared pixel for pixel with a PBM image in host/golden. A scene that
+// differs is written to <name>.actual.pbm in the current directory.
+//
+// -u rewrites the golden images from the current output instead.
+//
+// usage: pinball0_raster_test [-u] golden_dir
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+#include "pinball0.h"
+#include "graphics.h"
+#include "objects.h"
+
+namespace {
+
+typedef struct {
+    const char* name;
+    void (*draw)(Canvas* canvas);
+} Scene;
+
+// gfx_* take table units, ten to a pixel
+const float S = 10.0f;
+
+// Deterministic noise, so sub-pixel offsets exercise the rounding
+uint32_t lcg_state;
+float noise() {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (lcg_state >> 8) / (float)(1 << 24);
+}
+
+void draw_line_fan(Canvas* canvas) {
+    // reaches well past every edge
+    for(int a = 0; a < 360; a += 10) {
+        float rad = a * (float)M_PI / 180.0f;
+        gfx_draw_line(canvas, 32 * S, 64 * S, (32 + 90 * cosf(rad)) * S, (64 + 90 * sinf(rad)) * S);
+    }
+}
+
+void draw_line_cells(Canvas* canvas) {
+    lcg_state = 1;
+    for(int cy = 0; cy < 8; cy++) {
+        for(int cx = 0; cx < 4; cx++) {
+            float x = cx * 16 + 1 + noise();
+            float y = cy * 16 + 1 + noise();
+            float dx = noise() * 14;
+            float dy = noise() * 14;
+            if((cx + cy) % 2) {
+                gfx_draw_line(canvas, x * S, (y + dy) * S, (x + dx) * S, y * S);
+            } else {
+                gfx_draw_line(canvas, x * S, y * S, (x + dx) * S, (y + dy) * S);
+            }
+        }
+    }
+}
+
+// Three flipper-length strokes per cell, turning a little from cell to cell
+void draw_thick(Canvas* canvas, int thickness) {
+    lcg_state = thickness;
+    for(int cell = 0; cell < 8; cell++) {
+        float x = (cell % 2) * 32 + 16 + noise();
+        float y = (cell / 2) * 32 + 16 + noise();
+        for(int k = 0; k < 3; k++) {
+            float rad = (cell * 15 + thickness * 3 + k * 120) * (float)M_PI / 180.0f;
+            gfx_draw_line_thick(
+                canvas, x * S, y * S, (x + 12 * cosf(rad)) * S, (y + 12 * sinf(rad)) * S, thickness);
+        }
+    }
+}
+
+void draw_thick_1(Canvas* canvas) {
+    draw_thick(canvas, 1);
+}
+void draw_thick_2(Canvas* canvas) {
+    draw_thick(canvas, 2);
+}
+void draw_thick_3(Canvas* canvas) {
+    draw_thick(canvas, 3);
+}
+void draw_thick_4(Canvas* canvas) {
+    draw_thick(canvas, 4);
+}
+void draw_thick_5(Canvas* canvas) {
+    draw_thick(canvas, 5);
+}
+
+// Thick lines hanging off each edge, which drawThickLine clamps
+void draw_thick_edges(Canvas* canvas) {
+    gfx_draw_line_thick(canvas, 10 * S, 10 * S, 70 * S, 20 * S, 3);
+    gfx_draw_line_thick(canvas, 50 * S, 100 * S, 62 * S, 140 * S, 4);
+    gfx_draw_line_thick(canvas, 20 * S, 120 * S, 40 * S, 126 * S, 5);
+    gfx_draw_line_thick(canvas, 60 * S, 40 * S, 66 * S, 70 * S, 2);
+    gfx_draw_line_thick(canvas, 5 * S, 60 * S, 30 * S, 60 * S, 4);
+    gfx_draw_line_thick(canvas, 40 * S, 70 * S, 40 * S, 90 * S, 3);
+}
+
+void draw_discs(Canvas* canvas) {
+    for(int r = 0; r < 16; r++) {
+        gfx_draw_disc(canvas, ((r % 2) * 32 + 16) * S, (r / 2 * 16 + 8) * S, r * S * 0.5f);
+    }
+    // partly off screen
+    gfx_draw_disc(canvas, -3 * S, 20 * S, 8 * S);
+    gfx_draw_disc(canvas, 66 * S, 100 * S, 9 * S);
+    gfx_draw_disc(canvas, 30 * S, 130 * S, 6 * S);
+    gfx_draw_disc(canvas, 40 * S, -2 * S, 5 * S);
+}
+
+void draw_circles(Canvas* canvas) {
+    for(int r = 0; r < 16; r++) {
+        gfx_draw_circle(canvas, ((r % 2) * 32 + 16) * S, (r / 2 * 16 + 8) * S, r * S * 0.5f);
+    }
+    gfx_draw_circle(canvas, -3 * S, 20 * S, 8 * S);
+    gfx_draw_circle(canvas, 66 * S, 100 * S, 9 * S);
+    gfx_draw_circle(canvas, 30 * S, 130 * S, 6 * S);
+    gfx_draw_circle(canvas, 40 * S, -2 * S, 5 * S);
+}
+
+void draw_dots(Canvas* canvas) {
+    lcg_state = 7;
+    for(int i = 0; i < 400; i++) {
+        gfx_draw_dot(canvas, (noise() * 70 - 3) * S, (noise() * 136 - 4) * S);
+    }
+}
+
+// Table arcs of every size, in every quadrant and across the zero angle
+void draw_arcs(Canvas* canvas) {
+    lcg_state = 3;
+    for(int i = 0; i < 16; i++) {
+        float start = noise() * 2 * (float)M_PI;
+        float end = noise() * 2 * (float)M_PI;
+        Vec2 p(((i % 2) * 32 + 16 + noise()) * S, ((i / 2) * 16 + 8 + noise()) * S);
+        Arc arc(p, (4 + i * 2) * S, start, end);
+        arc.draw(canvas);
+    }
+    Arc full(Vec2(32 * S, 64 * S), 12 * S);
+    full.draw(canvas);
+}
+
+const Scene scenes[] = {
+    {"line_fan", draw_line_fan},
+    {"line_cells", draw_line_cells},
+    {"thick_1", draw_thick_1},
+    {"thick_2", draw_thick_2},
+    {"thick_3", draw_thick_3},
+    {"thick_4", draw_thick_4},
+    {"thick_5", draw_thick_5},
+    {"thick_edges", draw_thick_edges},
+    {"discs", draw_discs},
+    {"circles", draw_circles},
+    {"dots", draw_dots},
+    {"arcs", draw_arcs},
+};
+
+// Binary PBM: rows of bytes, most significant bit leftmost, 1 is black
+bool write_pbm(const std::string& path, Canvas* canvas) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if(!f) {
+        fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+    fprintf(f, "P4\n%d %d\n", LCD_WIDTH, LCD_HEIGHT);
+    for(int y = 0; y < LCD_HEIGHT; y++) {
+        for(int x = 0; x < LCD_WIDTH; x += 8) {
+            uint8_t byte = 0;
+            for(int b = 0; b < 8; b++) {
+                byte |= canvas_host_get_pixel(canvas, x + b, y) ? 0x80 >> b : 0;
+            }
+            fputc(byte, f);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Reads a PBM written by write_pbm, one bool per pixel
+bool read_pbm(const std::string& path, bool pixels[LCD_HEIGHT][LCD_WIDTH]) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if(!f) {
+        return false;
+    }
+    int w, h;
+    bool ok = fscanf(f, "P4 %d %d", &w, &h) == 2 && w == LCD_WIDTH && h == LCD_HEIGHT &&
+              fgetc(f) != EOF;
+    for(int y = 0; ok && y < LCD_HEIGHT; y++) {
+        for(int x = 0; ok && x < LCD_WIDTH; x += 8) {
+            int byte = fgetc(f);
+            ok = byte != EOF;
+            for(int b = 0; ok && b < 8; b++) {
+                pixels[y][x + b] = byte & (0x80 >> b);
+            }
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+// One canvas per layout for the whole run: the raster module recognizes a
+// canvas by its address, which a freed and reallocated canvas could reuse
+struct {
+    CanvasHostLayout layout;
+    const char* name;
+    Canvas* canvas;
+} layouts[] = {
+    {CanvasHostLayoutXbm, "xbm", nullptr},
+    {CanvasHostLayoutFlipper, "flipper", nullptr},
+};
+
+}
+
+int main(int argc, char** argv) {
+    bool update = false;
+    int opt;
+    while((opt = getopt(argc, argv, "u")) != -1) {
+        switch(opt) {
+        case 'u':
+            update = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-u] golden_dir\n", argv[0]);
+            return 2;
+        }
+    }
+    if(optind >= argc) {
+        fprintf(stderr, "usage: %s [-u] golden_dir\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[optind];
+
+    for(auto& layout : layouts) {
+        layout.canvas = canvas_host_alloc(layout.layout);
+    }
+    int failures = 0;
+    for(const Scene& scene : scenes) {
+        std::string golden_path = dir + "/" + scene.name + ".pbm";
+        bool golden[LCD_HEIGHT][LCD_WIDTH];
+        if(!update && !read_pbm(golden_path, golden)) {
+            printf("%-12s cannot read %s\n", scene.name, golden_path.c_str());
+            failures++;
+            continue;
+        }
+
+        for(const auto& layout : layouts) {
+            Canvas* canvas = layout.canvas;
+            canvas_clear(canvas);
+            scene.draw(canvas);
+
+            if(update) {
+                // both layouts draw the same picture, so write the first
+                failures += !write_pbm(golden_path, canvas);
+                printf("%-12s written\n", scene.name);
+                break;
+            }
+
+            int differ = 0;
+            for(int y = 0; y < LCD_HEIGHT; y++) {
+                for(int x = 0; x < LCD_WIDTH; x++) {
+                    differ += canvas_host_get_pixel(canvas, x, y) != golden[y][x];
+                }
+            }
+            if(differ) {
+                printf("%-12s %-8s %d pixels differ\n", scene.name, layout.name, differ);
+                write_pbm(std::string(scene.name) + ".actual.pbm", canvas);
+                failures++;
+            } else {
+                printf("%-12s %-8s ok\n", scene.name, layout.name);
+            }
+        }
+    }
+    for(auto& layout : layouts) {
+        canvas_host_free(layout.canvas);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+// Replays game recordings (.pbr) through solve() and checks each against the
+// hash of the ball positions it was recorded with, as a regression test of the
+// physics. Also reports the time spent in the physics per frame.
+//
+// A recording holds a hash for each physics build, float and fixed-point.
+// -u stores this build's hash in the recordings instead of checking it.
+//
+// Each recording is also rolled back: the table's snapshot from halfway
+// through is restored and the second half played again, which must end on the
+// same hash.
+//
+// usage: pinball0_replay [-C repo_dir] [-u] [-v] replay ...
+
+#include <chrono>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pinball0.h"
+#include "table.h"
+#include "physics.h"
+#include "replay.h"
+
+namespace {
+
+// The table halfway through a recording, and the frames that came after
+struct Rollback {
+    uint32_t frame;
+    std::vector<uint8_t> snapshot;
+    GameMode game_mode;
+    uint32_t hash;
+    std::vector<std::pair<uint8_t, uint32_t>> frames; // input, steps
+};
+
+void step(PinballApp& app, uint32_t steps) {
+    solve(&app, steps);
+    dispatch_collision_events(&app);
+}
+
+// Plays the recording at 'path' to its end, as the app's main loop would, except
+// that a game over doesn't stop it: the other physics build may lose the last
+// ball sooner. Returns the seconds spent in the physics, or a negative number
+// if it won't load.
+double play(PinballApp& app, const char* path, Rollback& rb) {
+    if(!replay_play(&app, path)) {
+        return -1;
+    }
+    rb.frame = app.replay.header.frames / 2;
+    rb.snapshot.clear();
+    rb.frames.clear();
+    std::chrono::nanoseconds elapsed(0);
+    while(true) {
+        if(app.replay.frames == rb.frame && rb.snapshot.empty()) {
+            rb.snapshot.resize(app.table->snapshot_size());
+            app.table->save_snapshot(rb.snapshot.data());
+            rb.game_mode = app.game_mode;
+            rb.hash = app.replay.hash;
+        }
+        uint32_t steps = PHYSICS_SUB_STEPS;
+        replay_frame(&app, &steps);
+        if(!app.replay.playing) {
+            break;
+        }
+        if(!rb.snapshot.empty()) {
+            rb.frames.push_back({app.replay.input, steps});
+        }
+        auto start = std::chrono::steady_clock::now();
+        step(app, steps);
+        elapsed += std::chrono::steady_clock::now() - start;
+        replay_frame_done(&app, steps);
+
+        app.table->step_animation();
+    }
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+// Restores the table to the middle of the recording and plays the rest again.
+// Returns the hash it ends on, or 0 if the snapshot won't restore.
+uint32_t roll_back(PinballApp& app, const Rollback& rb) {
+    if(!app.table->restore_snapshot(rb.snapshot.data(), rb.snapshot.size())) {
+        return 0;
+    }
+    app.game_mode = rb.game_mode;
+    uint32_t hash = rb.hash;
+    for(const auto& f : rb.frames) {
+        replay_apply_input(&app, f.first);
+        step(app, f.second);
+        replay_hash_balls(app.table, hash);
+    }
+    return hash;
+}
+
+bool store_hash(const char* path, uint32_t hash) {
+    FILE* f = fopen(path, "r+b");
+    if(!f) {
+        return false;
+    }
+    long offset = offsetof(ReplayHeader, hash) + replay_physics() * sizeof(uint32_t);
+    bool ok = fseek(f, offset, SEEK_SET) == 0 && fwrite(&hash, sizeof(hash), 1, f) == 1;
+    return fclose(f) == 0 && ok;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* root = PINBALL_SOURCE_DIR;
+    bool update = false;
+    int opt;
+    while((opt = getopt(argc, argv, "C:uv")) != -1) {
+        switch(opt) {
+        case 'C':
+            root = optarg;
+            break;
+        case 'u':
+            update = true;
+            break;
+        case 'v':
+            furi_log_set_level(FuriLogLevelInfo);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-C repo_dir] [-u] [-v] replay ...\n", argv[0]);
+            return 2;
+        }
+    }
+    if(optind >= argc) {
+        fprintf(stderr, "usage: %s [-C repo_dir] [-u] [-v] replay ...\n", argv[0]);
+        return 2;
+    }
+    // resolve the recordings before chdir, so relative paths are where the user expects
+    std::vector<std::string> paths;
+    for(int i = optind; i < argc; i++) {
+        char path[PATH_MAX];
+        if(!realpath(argv[i], path)) {
+            fprintf(stderr, "Cannot find %s\n", argv[i]);
+            return 2;
+        }
+        paths.push_back(path);
+    }
+    if(chdir(root) != 0) {
+        fprintf(stderr, "Cannot chdir to %s\n", root);
+        return 2;
+    }
+
+    PinballApp app;
+    table_table_list_init(&app);
+
+    printf(
+        "%s physics\n%-20s %8s %10s %10s\n",
+#ifdef PINBALL_FIXED_POINT
+        "Q16.16 fixed-point",
+#else
+        "float",
+#endif
+        "replay",
+        "frames",
+        "us/frame",
+        "hash");
+    int failures = 0;
+    Rollback rb;
+    for(const auto& path : paths) {
+        const char* name = strrchr(path.c_str(), '/') + 1;
+        double secs = play(app, path.c_str(), rb);
+        if(secs < 0) {
+            for(char* c = app.text; *c; c++) {
+                if(*c == '\n') *c = ' ';
+            }
+            printf("%-20s cannot play: %s\n", name, app.text);
+            failures++;
+            continue;
+        }
+        const Replay& r = app.replay;
+        uint32_t expected = r.header.hash[replay_physics()];
+        const char* result;
+        if(r.frames != r.header.frames) {
+            result = "ENDED EARLY";
+            failures++;
+        } else if(roll_back(app, rb) != r.hash) {
+            result = "ROLLBACK DIFFERS";
+            failures++;
+        } else if(update) {
+            bool ok = store_hash(path.c_str(), r.hash);
+            result = ok ? "stored" : "CANNOT STORE";
+            failures += !ok;
+        } else if(!expected) {
+            result = "NO HASH, -u to store it";
+            failures++;
+        } else if(r.hash != expected) {
+            result = "DIFFERS";
+            failures++;
+        } else {
+            result = "ok";
+        }
+        printf(
+            "%-20s %8u %10.2f   %08x %s\n",
+            name,
+            (unsigned)r.frames,
+            r.frames ? secs * 1e6 / r.frames : 0.0,
+            (unsigned)r.hash,
+            result);
+    }
+    return failures ? 1 : 0;
+}
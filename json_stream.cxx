@@ -0,0 +1,332 @@
+#include <furi.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pinball0.h"
+#include "json_stream.h"
+
+namespace {
+
+// Buffered character source over a JsonReadCallback
+class JsonReader {
+public:
+    JsonReader(JsonReadCallback read_, void* ctx_)
+        : read(read_)
+        , ctx(ctx_)
+        , pos(0)
+        , len(0)
+        , line(1) {
+    }
+    int peek() {
+        if(pos == len) {
+            len = read(ctx, buf, sizeof(buf));
+            pos = 0;
+            if(len == 0) {
+                return -1;
+            }
+        }
+        return (uint8_t)buf[pos];
+    }
+    int next() {
+        int c = peek();
+        if(c >= 0) {
+            pos++;
+            if(c == '\n') {
+                line++;
+            }
+        }
+        return c;
+    }
+
+    JsonReadCallback read;
+    void* ctx;
+    char buf[JSON_STREAM_CHUNK];
+    size_t pos;
+    size_t len;
+    int line;
+};
+
+bool fail(const JsonReader& r, const char* msg) {
+    FURI_LOG_E(TAG, "JSON error on line %d: %s", r.line, msg);
+    return false;
+}
+
+// Skips whitespace and comments
+bool skip_space(JsonReader& r) {
+    while(true) {
+        int c = r.peek();
+        if(c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            r.next();
+        } else if(c == '/') {
+            r.next();
+            c = r.next();
+            if(c == '/') {
+                while((c = r.next()) >= 0 && c != '\n') {
+                }
+            } else if(c == '*') {
+                int prev = 0;
+                while((c = r.next()) >= 0 && !(prev == '*' && c == '/')) {
+                    prev = c;
+                }
+                if(c < 0) {
+                    return fail(r, "unterminated comment");
+                }
+            } else {
+                return fail(r, "unexpected '/'");
+            }
+        } else {
+            return true;
+        }
+    }
+}
+
+void append(char* tok, size_t& n, char c) {
+    if(n < JSON_STREAM_TOKEN_MAX - 1) {
+        tok[n++] = c;
+    }
+}
+
+// Reads the rest of a string whose opening quote has been consumed
+bool parse_string(JsonReader& r, char* tok) {
+    size_t n = 0;
+    while(true) {
+        int c = r.next();
+        if(c < 0 || c == '\n') {
+            return fail(r, "unterminated string");
+        }
+        if(c == '"') {
+            break;
+        }
+        if(c != '\\') {
+            append(tok, n, c);
+            continue;
+        }
+        c = r.next();
+        switch(c) {
+        case 'b':
+            append(tok, n, '\b');
+            break;
+        case 'f':
+            append(tok, n, '\f');
+            break;
+        case 'n':
+            append(tok, n, '\n');
+            break;
+        case 'r':
+            append(tok, n, '\r');
+            break;
+        case 't':
+            append(tok, n, '\t');
+            break;
+        case 'u': {
+            // \uXXXX, as UTF-8
+            uint32_t cp = 0;
+            for(int i = 0; i < 4; i++) {
+                c = r.next();
+                int d = c >= '0' && c <= '9' ? c - '0' :
+                        c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                        c >= 'A' && c <= 'F' ? c - 'A' + 10 :
+                                               -1;
+                if(d < 0) {
+                    return fail(r, "bad \\u escape");
+                }
+                cp = (cp << 4) | d;
+            }
+            if(cp < 0x80) {
+                append(tok, n, cp);
+            } else if(cp < 0x800) {
+                append(tok, n, 0xC0 | (cp >> 6));
+                append(tok, n, 0x80 | (cp & 0x3F));
+            } else {
+                append(tok, n, 0xE0 | (cp >> 12));
+                append(tok, n, 0x80 | ((cp >> 6) & 0x3F));
+                append(tok, n, 0x80 | (cp & 0x3F));
+            }
+            break;
+        }
+        case '"':
+        case '\\':
+        case '/':
+            append(tok, n, c);
+            break;
+        default:
+            return fail(r, "bad escape");
+        }
+    }
+    tok[n] = 0;
+    return true;
+}
+
+// Reads a number whose first character 'c' has been consumed. Integers are
+// read with strtol() and anything with a fraction or exponent with strtod(),
+// as nxjson did.
+bool parse_number(JsonReader& r, int c, char* tok, JsonValue& v) {
+    size_t n = 0;
+    tok[n++] = c;
+    while((c = r.peek()) >= 0 && strchr("0123456789+-.eExXabcdefABCDEF", c)) {
+        if(n == JSON_STREAM_TOKEN_MAX - 1) {
+            return fail(r, "number too long");
+        }
+        tok[n++] = r.next();
+    }
+    tok[n] = 0;
+
+    char* end;
+    v.type = JsonNumber;
+    v.i = strtol(tok, &end, 0);
+    v.integer = *end != '.' && *end != 'e' && *end != 'E';
+    if(v.integer) {
+        v.f = v.i;
+    } else {
+        v.f = strtod(tok, &end);
+    }
+    if(end == tok || *end != 0) {
+        return fail(r, "invalid number");
+    }
+    return true;
+}
+
+// Reads the rest of true / false / null, whose first character 'c' has been consumed
+bool parse_literal(JsonReader& r, int c, JsonValue& v) {
+    const char* word = c == 't' ? "true" : c == 'f' ? "false" : "null";
+    for(const char* w = word + 1; *w; w++) {
+        if(r.next() != *w) {
+            return fail(r, "unexpected characters");
+        }
+    }
+    v.type = c == 'n' ? JsonNull : JsonBool;
+    v.i = c == 't';
+    return true;
+}
+
+typedef enum {
+    ExpectValue,
+    ExpectValueOrEnd, // just after '[' or ','
+    ExpectKeyOrEnd, // just after '{' or ','
+    ExpectColon,
+    ExpectCommaOrEnd,
+} JsonExpect;
+
+}
+
+bool json_stream_parse(JsonReadCallback read, void* read_ctx, JsonListener& listener) {
+    JsonReader r(read, read_ctx);
+    char tok[JSON_STREAM_TOKEN_MAX];
+    uint32_t arrays = 0; // bit n: is the container at depth n an array?
+    int depth = 0;
+    JsonExpect expect = ExpectValue;
+
+    static_assert(JSON_STREAM_DEPTH_MAX <= 32, "depth must fit 'arrays'");
+
+    while(true) {
+        if(!skip_space(r)) {
+            return false;
+        }
+        int c = r.next();
+        if(c < 0) {
+            return fail(r, "unexpected end of file");
+        }
+
+        bool in_array = depth > 0 && (arrays >> (depth - 1)) & 1;
+        bool closing = false;
+        switch(expect) {
+        case ExpectKeyOrEnd:
+            if(c == '}') {
+                closing = true;
+                break;
+            }
+            if(c != '"') {
+                return fail(r, "expected a key");
+            }
+            if(!parse_string(r, tok)) {
+                return false;
+            }
+            if(!listener.key(tok)) {
+                return false;
+            }
+            expect = ExpectColon;
+            continue;
+        case ExpectColon:
+            if(c != ':') {
+                return fail(r, "expected ':'");
+            }
+            expect = ExpectValue;
+            continue;
+        case ExpectCommaOrEnd:
+            if(c == ',') {
+                expect = in_array ? ExpectValueOrEnd : ExpectKeyOrEnd;
+                continue;
+            }
+            if(c != '}' && c != ']') {
+                return fail(r, in_array ? "expected ',' or ']'" : "expected ',' or '}'");
+            }
+            closing = true;
+            break;
+        case ExpectValueOrEnd:
+            if(c == ']') {
+                closing = true;
+            }
+            break;
+        case ExpectValue:
+            break;
+        }
+
+        if(closing) {
+            if((c == ']') != in_array) {
+                return fail(r, "mismatched brackets");
+            }
+            depth--;
+            arrays &= ~(1u << depth);
+            if(!listener.end(in_array)) {
+                return false;
+            }
+            if(depth == 0) {
+                return true;
+            }
+            expect = ExpectCommaOrEnd;
+            continue;
+        }
+
+        // a value
+        if(c == '{' || c == '[') {
+            if(depth == JSON_STREAM_DEPTH_MAX) {
+                return fail(r, "nested too deeply");
+            }
+            if(c == '[') {
+                arrays |= 1u << depth;
+            }
+            depth++;
+            if(!listener.begin(c == '[')) {
+                return false;
+            }
+            expect = c == '[' ? ExpectValueOrEnd : ExpectKeyOrEnd;
+            continue;
+        }
+
+        JsonValue v = {JsonNull, nullptr, 0, 0, false};
+        if(c == '"') {
+            if(!parse_string(r, tok)) {
+                return false;
+            }
+            v.type = JsonString;
+            v.str = tok;
+        } else if(c == '-' || c == '+' || (c >= '0' && c <= '9')) {
+            if(!parse_number(r, c, tok, v)) {
+                return false;
+            }
+        } else if(c == 't' || c == 'f' || c == 'n') {
+            if(!parse_literal(r, c, v)) {
+                return false;
+            }
+        } else {
+            return fail(r, "unexpected character");
+        }
+        if(!listener.value(v)) {
+            return false;
+        }
+        if(depth == 0) {
+            return true;
+        }
+        expect = ExpectCommaOrEnd;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming (SAX style) JSON parser. Pulls text through a small fixed buffer
+// and reports each element to a JsonListener as soon as it's complete, so
+// memory use doesn't depend on the size of the document.
+//
+// Like nxjson before it, it accepts // and /* */ comments and doesn't mind
+// trailing commas. Strings (keys included) longer than JSON_STREAM_TOKEN_MAX
+// are truncated.
+
+#define JSON_STREAM_CHUNK     64 // bytes read at a time
+#define JSON_STREAM_TOKEN_MAX 32 // longest string or number, including NUL
+#define JSON_STREAM_DEPTH_MAX 16 // deepest nesting of objects and arrays
+
+typedef enum {
+    JsonNull,
+    JsonBool,
+    JsonNumber,
+    JsonString,
+} JsonValueType;
+
+typedef struct {
+    JsonValueType type;
+    const char* str; // JsonString: the unescaped text, valid during the callback only
+    int32_t i; // JsonNumber: the integer part, JsonBool: 0 or 1
+    float f; // JsonNumber: the value
+    bool integer; // JsonNumber: written without a fraction or exponent
+} JsonValue;
+
+class JsonListener {
+public:
+    virtual ~JsonListener() = default;
+    // Each returns false to stop parsing
+    virtual bool begin(bool array) = 0; // '{' or '['
+    virtual bool end(bool array) = 0; // '}' or ']'
+    virtual bool key(const char* key) = 0; // an object member's name
+    virtual bool value(const JsonValue& value) = 0;
+};
+
+// Supplies up to 'size' more bytes of JSON text, returning 0 at the end
+typedef size_t (*JsonReadCallback)(void* ctx, char* buf, size_t size);
+
+// Parses one JSON value. Returns false on a syntax error (logged, with its
+// line number), on running out of text early, or if the listener stopped.
+bool json_stream_parse(JsonReadCallback read, void* read_ctx, JsonListener& listener);
@@ -0,0 +1,114 @@
+#include <furi.h>
+#include <furi_hal.h>
+
+#include "pinball0.h"
+#include "load_profile.h"
+
+namespace {
+LoadProfile* active = nullptr;
+LoadPhase current = LoadPhaseParse;
+uint32_t phase_start = 0;
+
+const char* const phase_names[LoadPhaseCount] = {"read", "parse", "build", "signals", "bake"};
+
+void sample_heap() {
+    size_t free = memmgr_get_free_heap();
+    if(free < active->heap_min) {
+        active->heap_min = free;
+    }
+    uint32_t used = free < active->heap_start ? active->heap_start - free : 0;
+    if(used > active->heap_peak[current]) {
+        active->heap_peak[current] = used;
+    }
+}
+
+void switch_phase(LoadPhase next) {
+    if(active) {
+        uint32_t now = DWT->CYCCNT;
+        active->cycles[current] += now - phase_start;
+        phase_start = now;
+        sample_heap();
+    }
+    current = next;
+}
+}
+
+void load_profile_begin(LoadProfile* profile) {
+    memset(profile, 0, sizeof(LoadProfile));
+    profile->heap_start = memmgr_get_free_heap();
+    profile->heap_min = profile->heap_start;
+    profile->cycles_per_us = furi_hal_cortex_instructions_per_microsecond();
+    current = LoadPhaseParse;
+    phase_start = DWT->CYCCNT;
+    active = profile;
+}
+
+void load_profile_end() {
+    if(active) {
+        switch_phase(LoadPhaseParse);
+        active->valid = true;
+        active = nullptr;
+    }
+}
+
+uint32_t load_profile_us(const LoadProfile* profile, LoadPhase phase) {
+    uint64_t cycles = 0;
+    for(int i = 0; i < LoadPhaseCount; i++) {
+        if(phase == LoadPhaseCount || phase == i) {
+            cycles += profile->cycles[i];
+        }
+    }
+    return cycles / (profile->cycles_per_us ? profile->cycles_per_us : 1);
+}
+
+uint32_t load_profile_allocs(const LoadProfile* profile) {
+    uint32_t allocs = 0;
+    for(int i = 0; i < LoadPhaseCount; i++) {
+        allocs += profile->allocs[i];
+    }
+    return allocs;
+}
+
+const char* load_profile_phase_name(LoadPhase phase) {
+    return phase < LoadPhaseCount ? phase_names[phase] : "total";
+}
+
+void load_profile_log(const LoadProfile* profile, const char* name) {
+    FURI_LOG_I(
+        TAG,
+        "Loaded %s in %lu us: %lu allocs, heap peak %lu bytes, %lu bytes free at worst",
+        name,
+        (unsigned long)load_profile_us(profile, LoadPhaseCount),
+        (unsigned long)load_profile_allocs(profile),
+        (unsigned long)(profile->heap_start - profile->heap_min),
+        (unsigned long)profile->heap_min);
+    for(int i = 0; i < LoadPhaseCount; i++) {
+        FURI_LOG_I(
+            TAG,
+            "  %-8s %7lu us %5lu allocs %6lu bytes peak",
+            phase_names[i],
+            (unsigned long)load_profile_us(profile, (LoadPhase)i),
+            (unsigned long)profile->allocs[i],
+            (unsigned long)profile->heap_peak[i]);
+    }
+}
+
+void load_profile_count_alloc() {
+    if(active) {
+        active->allocs[current]++;
+        sample_heap();
+    }
+}
+
+LoadPhaseScope::LoadPhaseScope(LoadPhase phase)
+    : prev(current) {
+    if(phase != current) {
+        switch_phase(phase);
+    }
+}
+
+LoadPhaseScope::~LoadPhaseScope() {
+    if(prev != current) {
+        switch_phase(prev);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Table load profiling. While a LoadProfile is active, time, allocations and
+// heap use are charged to the current phase, which LoadPhaseScope switches.
+// Time comes from the DWT cycle counter, allocations are those made through
+// operator new, and the heap peak is the most memory in use (relative to the
+// start of the load) seen at any allocation or phase switch.
+
+typedef enum {
+    LoadPhaseRead, // storage reads
+    LoadPhaseParse, // JSON parsing, or .pb0 record decoding
+    LoadPhaseBuild, // table object construction
+    LoadPhaseValidate, // signal validation
+    LoadPhaseBake, // collider arrays and broadphase grid
+    LoadPhaseCount,
+} LoadPhase;
+
+typedef struct {
+    uint32_t cycles[LoadPhaseCount];
+    uint32_t allocs[LoadPhaseCount];
+    uint32_t heap_peak[LoadPhaseCount]; // bytes in use above heap_start
+    size_t heap_start; // free heap when the load began
+    size_t heap_min; // least free heap seen during the load
+    uint32_t cycles_per_us;
+    bool valid; // a load has been profiled
+} LoadProfile;
+
+// Starts profiling into 'profile', charging the Parse phase
+void load_profile_begin(LoadProfile* profile);
+// Stops profiling. Safe to call when nothing is active.
+void load_profile_end();
+
+// Called by operator new for every allocation
+void load_profile_count_alloc();
+
+// Elapsed microseconds of a phase, or of the whole load for LoadPhaseCount
+uint32_t load_profile_us(const LoadProfile* profile, LoadPhase phase);
+uint32_t load_profile_allocs(const LoadProfile* profile);
+
+const char* load_profile_phase_name(LoadPhase phase);
+
+// Writes the report to the log
+void load_profile_log(const LoadProfile* profile, const char* name);
+
+// Charges everything until it goes out of scope to 'phase', then switches back
+class LoadPhaseScope {
+public:
+    LoadPhaseScope(LoadPhase phase);
+    ~LoadPhaseScope();
+
+private:
+    LoadPhase prev;
+};
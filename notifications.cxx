@@ -1,275 +1,370 @@
+#include <algorithm>
+#include <vector>
 #include "notifications.h"
 #include "pinball0.h"
 
-static const NotificationMessage* nm_list[32];
+// Every notification is built ahead of time, once for each combination of the
+// sound, LED and vibrate settings, into one pool that is never written again.
+// notification_message() is asynchronous, so a sequence still playing must
+// not change under it; with the pool, firing one is a pointer handoff and a
+// settings change just picks different sequences.
 
-// static FuriMutex* nm_mutex;
+#define NOTIFY_MAX_MESSAGES 32 // per sequence, the terminating NULL included
+#define NOTIFY_COMBOS       8 // settings combinations
 
-// void notify_init() {
-//     nm_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
-// }
-// void notify_free() {
-//     furi_mutex_free(nm_mutex);
-// }
+typedef struct {
+    bool sound;
+    bool led;
+    bool vibrate;
+} Enabled;
 
-void notify_ball_released(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.vibrate_enabled) {
-        nm_list[n++] = &message_vibro_on;
+class Builder {
+public:
+    Builder()
+        : n(0) {
+    }
+    void add(const NotificationMessage* message) {
+        furi_check(n < NOTIFY_MAX_MESSAGES - 1);
+        list[n++] = message;
     }
-    nm_list[n++] = &message_delay_100;
-    if(app->settings.vibrate_enabled) {
-        nm_list[n++] = &message_vibro_off;
+
+    const NotificationMessage* list[NOTIFY_MAX_MESSAGES];
+    size_t n;
+};
+
+typedef enum {
+    NotifyBallReleased,
+    NotifyTableBump,
+    NotifyTableTilted,
+    NotifyErrorMessage,
+    NotifyGameOver,
+    NotifyBumperHit,
+    NotifyRailHit,
+    NotifyPortal,
+    NotifyLostLife,
+    NotifyFlipper,
+    NotifyCount,
+} Notify;
+
+static void build_ball_released(Builder& s, const Enabled& on) {
+    if(on.vibrate) {
+        s.add(&message_vibro_on);
+    }
+    s.add(&message_delay_100);
+    if(on.vibrate) {
+        s.add(&message_vibro_off);
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_table_bump(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.vibrate_enabled) {
-        nm_list[n++] = &message_vibro_on;
+static void build_table_bump(Builder& s, const Enabled& on) {
+    if(on.vibrate) {
+        s.add(&message_vibro_on);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_red_255;
+    if(on.led) {
+        s.add(&message_red_255);
     }
-    nm_list[n++] = &message_delay_100;
-    if(app->settings.vibrate_enabled) {
-        nm_list[n++] = &message_vibro_off;
+    s.add(&message_delay_100);
+    if(on.vibrate) {
+        s.add(&message_vibro_off);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_red_0;
+    if(on.led) {
+        s.add(&message_red_0);
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_table_tilted(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-
+static void build_table_tilted(Builder& s, const Enabled& on) {
     for(int i = 0; i < 2; i++) {
-        nm_list[n++] = &message_display_backlight_off;
-        if(app->settings.vibrate_enabled) {
-            nm_list[n++] = &message_vibro_on;
+        s.add(&message_display_backlight_off);
+        if(on.vibrate) {
+            s.add(&message_vibro_on);
         }
-        if(app->settings.led_enabled) {
-            nm_list[n++] = &message_red_255;
+        if(on.led) {
+            s.add(&message_red_255);
         }
-        nm_list[n++] = &message_delay_500;
+        s.add(&message_delay_500);
 
-        nm_list[n++] = &message_display_backlight_on;
-        if(app->settings.vibrate_enabled) {
-            nm_list[n++] = &message_vibro_off;
+        s.add(&message_display_backlight_on);
+        if(on.vibrate) {
+            s.add(&message_vibro_off);
         }
-        if(app->settings.led_enabled) {
-            nm_list[n++] = &message_red_0;
+        if(on.led) {
+            s.add(&message_red_0);
         }
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_error_message(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_c6;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_sound_off;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_c5;
-        nm_list[n++] = &message_delay_250;
-        nm_list[n++] = &message_sound_off;
+static void build_error_message(Builder& s, const Enabled& on) {
+    if(on.sound) {
+        s.add(&message_note_c6);
+        s.add(&message_delay_50);
+        s.add(&message_sound_off);
+        s.add(&message_delay_50);
+        s.add(&message_note_c5);
+        s.add(&message_delay_250);
+        s.add(&message_sound_off);
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_game_over(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_delay_500;
-        nm_list[n++] = &message_note_b5;
-        nm_list[n++] = &message_delay_250;
-        nm_list[n++] = &message_note_f6;
-        nm_list[n++] = &message_delay_250;
-        nm_list[n++] = &message_sound_off;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_f6;
-        nm_list[n++] = &message_delay_100;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_f6;
-        nm_list[n++] = &message_delay_100;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_e6;
-        nm_list[n++] = &message_delay_100;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_d6;
-        nm_list[n++] = &message_delay_100;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_c6;
-        nm_list[n++] = &message_delay_1000;
-        nm_list[n++] = &message_sound_off;
+static void build_game_over(Builder& s, const Enabled& on) {
+    if(on.sound) {
+        s.add(&message_delay_500);
+        s.add(&message_note_b5);
+        s.add(&message_delay_250);
+        s.add(&message_note_f6);
+        s.add(&message_delay_250);
+        s.add(&message_sound_off);
+        s.add(&message_delay_50);
+        s.add(&message_note_f6);
+        s.add(&message_delay_100);
+        s.add(&message_delay_50);
+        s.add(&message_note_f6);
+        s.add(&message_delay_100);
+        s.add(&message_delay_50);
+        s.add(&message_note_e6);
+        s.add(&message_delay_100);
+        s.add(&message_delay_50);
+        s.add(&message_note_d6);
+        s.add(&message_delay_100);
+        s.add(&message_delay_50);
+        s.add(&message_note_c6);
+        s.add(&message_delay_1000);
+        s.add(&message_sound_off);
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_bumper_hit(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_blue_255;
+static void build_bumper_hit(Builder& s, const Enabled& on) {
+    if(on.led) {
+        s.add(&message_blue_255);
     }
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_f4;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_note_f5;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_sound_off;
+    if(on.sound) {
+        s.add(&message_note_f4);
+        s.add(&message_delay_10);
+        s.add(&message_note_f5);
+        s.add(&message_delay_10);
+        s.add(&message_sound_off);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_blue_0;
+    if(on.led) {
+        s.add(&message_blue_0);
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_rail_hit(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_d4;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_note_d5;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_sound_off;
+static void build_rail_hit(Builder& s, const Enabled& on) {
+    if(on.sound) {
+        s.add(&message_note_d4);
+        s.add(&message_delay_10);
+        s.add(&message_note_d5);
+        s.add(&message_delay_10);
+        s.add(&message_sound_off);
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_portal(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_blue_255;
-        nm_list[n++] = &message_red_255;
+static void build_portal(Builder& s, const Enabled& on) {
+    if(on.led) {
+        s.add(&message_blue_255);
+        s.add(&message_red_255);
     }
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_c4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_e4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_b4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_c5;
-        nm_list[n++] = &message_delay_50;
+    if(on.sound) {
+        s.add(&message_note_c4);
+        s.add(&message_delay_50);
+        s.add(&message_note_e4);
+        s.add(&message_delay_50);
+        s.add(&message_note_b4);
+        s.add(&message_delay_50);
+        s.add(&message_note_c5);
+        s.add(&message_delay_50);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_blue_255;
-        nm_list[n++] = &message_red_0;
+    if(on.led) {
+        s.add(&message_blue_255);
+        s.add(&message_red_0);
     }
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_e4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_g4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_c5;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_e5;
-        nm_list[n++] = &message_delay_50;
-
-        nm_list[n++] = &message_sound_off;
+    if(on.sound) {
+        s.add(&message_note_e4);
+        s.add(&message_delay_50);
+        s.add(&message_note_g4);
+        s.add(&message_delay_50);
+        s.add(&message_note_c5);
+        s.add(&message_delay_50);
+        s.add(&message_note_e5);
+        s.add(&message_delay_50);
+
+        s.add(&message_sound_off);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_blue_0;
+    if(on.led) {
+        s.add(&message_blue_0);
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
 }
 
-void notify_lost_life(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_red_255;
-        nm_list[n++] = &message_green_255;
+static void build_lost_life(Builder& s, const Enabled& on) {
+    if(on.led) {
+        s.add(&message_red_255);
+        s.add(&message_green_255);
+    }
+    if(on.sound) {
+        s.add(&message_note_c5);
+        s.add(&message_delay_50);
+        s.add(&message_note_c4);
+        s.add(&message_delay_50);
+        s.add(&message_note_b4);
+        s.add(&message_delay_50);
+        s.add(&message_note_b3);
+        s.add(&message_delay_50);
     }
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_c5;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_c4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_b4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_b3;
-        nm_list[n++] = &message_delay_50;
+    if(on.led) {
+        s.add(&message_green_0);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_green_0;
+    if(on.sound) {
+        s.add(&message_note_as4);
+        s.add(&message_delay_50);
+        s.add(&message_note_as3);
+        s.add(&message_delay_50);
+        s.add(&message_note_a4);
+        s.add(&message_delay_50);
+        s.add(&message_note_a3);
+        s.add(&message_delay_50);
     }
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_as4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_as3;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_a4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_a3;
-        nm_list[n++] = &message_delay_50;
+    if(on.led) {
+        s.add(&message_green_255);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_green_255;
+    if(on.sound) {
+        s.add(&message_note_gs4);
+        s.add(&message_delay_50);
+        s.add(&message_note_gs3);
+        s.add(&message_delay_50);
+        s.add(&message_note_g4);
+        s.add(&message_delay_50);
+        s.add(&message_note_g4);
+        s.add(&message_delay_50);
+
+        s.add(&message_sound_off);
     }
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_gs4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_gs3;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_g4;
-        nm_list[n++] = &message_delay_50;
-        nm_list[n++] = &message_note_g4;
-        nm_list[n++] = &message_delay_50;
-
-        nm_list[n++] = &message_sound_off;
+    if(on.led) {
+        s.add(&message_red_0);
+        s.add(&message_green_0);
     }
-    if(app->settings.led_enabled) {
-        nm_list[n++] = &message_red_0;
-        nm_list[n++] = &message_green_0;
+}
+
+static void build_flipper(Builder& s, const Enabled& on) {
+    if(on.sound) {
+        s.add(&message_note_c4);
+        s.add(&message_delay_10);
+        s.add(&message_note_cs4);
+        s.add(&message_delay_10);
+        s.add(&message_sound_off);
     }
-    furi_assert(n < 32);
-    nm_list[n] = NULL;
-    notification_message_block(app->notify, &nm_list);
 }
 
-void notify_flipper(void* ctx) {
-    PinballApp* app = (PinballApp*)ctx;
-    int n = 0;
-    if(app->settings.sound_enabled) {
-        nm_list[n++] = &message_note_c4;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_note_cs4;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_sound_off;
+typedef void (*BuildFn)(Builder& s, const Enabled& on);
+static const BuildFn builders[NotifyCount] = {
+    build_ball_released,
+    build_table_bump,
+    build_table_tilted,
+    build_error_message,
+    build_game_over,
+    build_bumper_hit,
+    build_rail_hit,
+    build_portal,
+    build_lost_life,
+    build_flipper,
+};
+
+// NULL-terminated sequences, back to back; sequences[event][combo] points into it
+static std::vector<const NotificationMessage*> pool;
+static const NotificationMessage* const* sequences[NotifyCount][NOTIFY_COMBOS];
+
+static size_t combo(const PinballApp* app) {
+    return (app->settings.sound_enabled ? 1 : 0) | (app->settings.led_enabled ? 2 : 0) |
+           (app->settings.vibrate_enabled ? 4 : 0);
+}
+
+void notify_init() {
+    // where each sequence starts in the pool, which may still move as it grows
+    size_t start[NotifyCount][NOTIFY_COMBOS];
+    pool.clear();
+    for(int e = 0; e < NotifyCount; e++) {
+        for(size_t c = 0; c < NOTIFY_COMBOS; c++) {
+            Enabled on = {(c & 1) != 0, (c & 2) != 0, (c & 4) != 0};
+            Builder b;
+            builders[e](b, on);
+            b.list[b.n++] = NULL;
+
+            // most events only use some of the settings: share identical sequences
+            start[e][c] = pool.size();
+            for(size_t prev = 0; prev < c; prev++) {
+                if(std::equal(b.list, b.list + b.n, pool.begin() + start[e][prev])) {
+                    start[e][c] = start[e][prev];
+                    break;
+                }
+            }
+            if(start[e][c] == pool.size()) {
+                pool.insert(pool.end(), b.list, b.list + b.n);
+            }
+        }
+    }
+    pool.shrink_to_fit();
+    for(int e = 0; e < NotifyCount; e++) {
+        for(size_t c = 0; c < NOTIFY_COMBOS; c++) {
+            sequences[e][c] = pool.data() + start[e][c];
+        }
     }
-    nm_list[n] = NULL;
-    notification_message(app->notify, &nm_list);
+    FURI_LOG_I(TAG, "Notification pool: %u messages", pool.size());
+}
+
+void notify_free() {
+    pool.clear();
+    pool.shrink_to_fit();
 }
 
-/*
-Mario coin sound - ish
-        nm_list[n++] = &message_note_b5;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_delay_10;
-        nm_list[n++] = &message_sound_off;
-        nm_list[n++] = &message_note_e6;
-        nm_list[n++] = &message_delay_250;
-        nm_list[n++] = &message_delay_100;
-
-*/
+static const NotificationSequence* sequence(const PinballApp* app, Notify event) {
+    furi_check(!pool.empty());
+    return reinterpret_cast<const NotificationSequence*>(sequences[event][combo(app)]);
+}
+
+void notify_ball_released(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyBallReleased));
+}
+
+void notify_table_bump(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyTableBump));
+}
+
+void notify_table_tilted(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyTableTilted));
+}
+
+void notify_error_message(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyErrorMessage));
+}
+
+void notify_game_over(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyGameOver));
+}
+
+void notify_bumper_hit(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyBumperHit));
+}
+
+void notify_rail_hit(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyRailHit));
+}
+
+void notify_portal(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyPortal));
+}
+
+void notify_lost_life(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message_block(app->notify, sequence(app, NotifyLostLife));
+}
+
+void notify_flipper(void* ctx) {
+    PinballApp* app = (PinballApp*)ctx;
+    notification_message(app->notify, sequence(app, NotifyFlipper));
+}
@@ -3,8 +3,9 @@
 #include <furi.h>
 #include <notification/notification.h>
 
-// void notify_init();
-// void notify_free();
+// Builds every notification sequence up front; call before any notify_*()
+void notify_init();
+void notify_free();
 
 void notify_ball_released(void* ctx);
 void notify_table_bump(void* ctx);
@@ -5,7 +5,7 @@
 #include "pinball0.h"
 #include "graphics.h"
 
-Object::Object(const Vec2& p_, float r_)
+Object::Object(const Vec2& p_, Scalar r_)
     : p(p_)
     , prev_p(p_)
     , a({0.0, 0.0})
@@ -16,7 +16,7 @@ Object::Object(const Vec2& p_, float r_)
     , score(0) {
 }
 
-void Object::update(float dt) {
+void Object::update(Scalar dt) {
     if(fixed) {
         return;
     }
@@ -32,6 +32,10 @@ void Ball::draw(Canvas* canvas) {
     gfx_draw_disc(canvas, p, r);
 }
 
+void Ball::draw(Canvas* canvas, float alpha) {
+    gfx_draw_disc(canvas, prev_p + (p - prev_p) * alpha, r);
+}
+
 Flipper::Flipper(const Vec2& p_, Side side_, size_t size_)
     : p(p_)
     , side(side_)
@@ -40,6 +44,8 @@ Flipper::Flipper(const Vec2& p_, Side side_, size_t size_)
     , max_rotation(1.0f)
     , omega(4.0f)
     , rotation(0.0f)
+    , prev_rotation(0.0f)
+    , current_omega(0.0f)
     , powered(false)
     , score(50)
     , notification(nullptr) {
@@ -50,16 +56,40 @@ Flipper::Flipper(const Vec2& p_, Side side_, size_t size_)
         rest_angle = M_PI + 0.4;
         sign = -1;
     }
+    build_sweep();
+}
+
+void Flipper::build_sweep() {
+    for(int i = 0; i < FLIPPER_LUT_SIZE; i++) {
+        Scalar angle = rest_angle + sign * max_rotation * i / (FLIPPER_LUT_SIZE - 1);
+        Vec2 dir(cosf(angle), -sinf(angle));
+        sweep_dir[i] = dir;
+        // d(dir)/d(angle), in the direction rotation moves the flipper
+        sweep_normal[i] = Vec2(dir.y, -dir.x) * sign;
+    }
+    sweep_scale = Scalar(FLIPPER_LUT_SIZE - 1) / max_rotation;
 }
 
-void Flipper::draw(Canvas* canvas) {
+void Flipper::sweep_at(Scalar rot, Vec2& dir, Vec2& normal) const {
+    Scalar f = fmax(Scalar(0), rot * sweep_scale);
+    int i = (int)f;
+    if(i >= FLIPPER_LUT_SIZE - 1) {
+        i = FLIPPER_LUT_SIZE - 2;
+    }
+    Scalar frac = fmin(f - Scalar(i), Scalar(1));
+    // entries are close enough that the lerp stays within 1e-4 of unit length
+    dir = sweep_dir[i] + (sweep_dir[i + 1] - sweep_dir[i]) * frac;
+    normal = sweep_normal[i] + (sweep_normal[i + 1] - sweep_normal[i]) * frac;
+}
+
+void Flipper::draw(Canvas* canvas, float alpha) {
     // tip
-    float angle = rest_angle + sign * rotation;
-    Vec2 dir(cos(angle), -sin(angle));
+    Vec2 dir, normal;
+    sweep_at(prev_rotation + (rotation - prev_rotation) * alpha, dir, normal);
 
     // draw the tip
     Vec2 tip = p + dir * size;
-    gfx_draw_line_thick(canvas, p, tip, (r * 1.5f) / 10.0f);
+    gfx_draw_line_thick(canvas, p, tip, (int)((r * 1.5f) / 10));
     gfx_draw_disc(canvas, tip, r * 0.6f);
 
     // // base / pivot
@@ -86,29 +116,56 @@ void Flipper::draw(Canvas* canvas) {
     // gfx_draw_line(canvas, start, end);
 }
 
-void Flipper::update(float dt) {
-    float prev_rotation = rotation;
+void Flipper::update(Scalar dt) {
+    prev_rotation = rotation;
     if(powered) {
         rotation = fmin(rotation + dt * omega, max_rotation);
     } else {
-        rotation = fmax(rotation - dt * omega, 0.0f);
+        rotation = fmax(rotation - dt * omega, Scalar(0));
     }
     current_omega = sign * (rotation - prev_rotation) / dt;
 }
 
 bool Flipper::collide(Ball& ball) {
-    Vec2 closest = Vec2_closest(p, get_tip(), ball.p);
-    Vec2 dir = ball.p - closest;
-    float dist = dir.mag();
-    if(dist <= VEC2_EPSILON || dist > ball.r + r) {
+    Vec2 u, n;
+    sweep_at(rotation, u, n);
+    Scalar reach = ball.r + r;
+    Scalar len = (int)size;
+    // the ball can't touch us if it's too far from our line
+    Vec2 rel = ball.p - p;
+    if(fabsf(rel.dot(n)) > reach && !ball.needs_sweep()) {
         return false;
     }
-    dir = dir / dist;
+    // u is already a unit vector, so no need for the general Vec2_closest()
+    auto closest_to = [&](const Vec2& q) {
+        return p + u * fmax(Scalar(0), fmin(len, (q - p).dot(u)));
+    };
 
+    Vec2 tip = p + u * len;
     Vec2 ball_v = ball.p - ball.prev_p;
+    Vec2 closest = closest_to(ball.p);
+    Vec2 dir = ball.p - closest;
+    Scalar dist = dir.mag();
+    if(dist > reach) {
+        // A fast ball may have passed clean through the flipper during the last
+        // step. If so, rewind it to the time of impact and respond from there.
+        Scalar t;
+        if(!ball.needs_sweep() ||
+           !Vec2_sweep_capsule(p, tip, reach, ball.prev_p, ball.p, t)) {
+            return false;
+        }
+        ball.p = ball.prev_p + ball_v * t;
+        closest = closest_to(ball.p);
+        dir = ball.p - closest;
+        dist = dir.mag();
+    }
+    if(dist <= VEC2_EPSILON) {
+        return false;
+    }
+    dir = dir / dist;
 
     // adjust ball position
-    float corr = ball.r + r - dist;
+    Scalar corr = reach - dist;
     ball.p += dir * corr;
 
     closest += dir * r;
@@ -118,12 +175,12 @@ bool Flipper::collide(Ball& ball) {
     perp.normalize();
     Vec2 surface_velocity = perp * 1.7f; // TODO: flipper power??
     // FURI_LOG_I(TAG, "sv: %.3f,%.3f", (double)surface_velocity.x, (double)surface_velocity.y);
-    if(current_omega != 0.0f) surface_velocity *= current_omega;
+    if(current_omega != 0) surface_velocity *= current_omega;
     // FURI_LOG_I(TAG, "sv: %.3f,%.3f", (double)surface_velocity.x, (double)surface_velocity.y);
 
     // TODO: Flippers currently aren't "bouncy" when they are still
-    float v = ball_v.dot(dir);
-    float v_new = surface_velocity.dot(dir);
+    Scalar v = ball_v.dot(dir);
+    Scalar v_new = surface_velocity.dot(dir);
     // FURI_LOG_I(TAG, "v_new: %.4f, v: %.4f", (double)v_new, (double)v);
     ball_v += dir * (v_new - v);
     ball.prev_p = ball.p - ball_v;
@@ -131,8 +188,8 @@ bool Flipper::collide(Ball& ball) {
 }
 
 Vec2 Flipper::get_tip() const {
-    float angle = rest_angle + sign * rotation;
-    Vec2 dir(cos(angle), -sin(angle));
+    Vec2 dir, normal;
+    sweep_at(rotation, dir, normal);
     Vec2 tip = p + dir * size;
     return tip;
 }
@@ -159,6 +216,15 @@ void FixedObject::reset_state() {
     hidden = saved.hidden;
 }
 
+uint8_t FixedObject::snapshot() const {
+    return (physical ? 1 : 0) | (hidden ? 2 : 0);
+}
+
+void FixedObject::restore(uint8_t state) {
+    physical = state & 1;
+    hidden = state & 2;
+}
+
 void Polygon::draw(Canvas* canvas) {
     if(!hidden) {
         for(size_t i = 0; i < points.size() - 1; i++) {
@@ -172,62 +238,19 @@ void Polygon::draw(Canvas* canvas) {
     }
 }
 
-// Attempt to handle double_sided rails better
-bool Polygon::collide(Ball& ball) {
-    Vec2 ball_v = ball.p - ball.prev_p;
-    Vec2 dir;
-    Vec2 closest = points[0];
-    Vec2 normal = normals[0];
-    float min_dist = infinityf();
-
-    for(size_t i = 0; i < points.size() - 1; i++) {
-        Vec2& p1 = points[i];
-        Vec2& p2 = points[i + 1];
-
-        Vec2 c = Vec2_closest(p1, p2, ball.p);
-        dir = ball.p - c;
-        float dist = dir.mag();
-        if(dist < min_dist) {
-            min_dist = dist;
-            closest = c;
-            normal = normals[i];
-        }
-    }
-    dir = ball.p - closest;
-    float dist = dir.mag();
-    if(dist > ball.r) {
-        return false;
-    }
-
-    if(dist <= VEC2_EPSILON) {
-        dir = normal;
-        dist = normal.mag();
+void Polygon::bake(Colliders& colliders, uint16_t id) const {
+    if(points.size() < 2) {
+        return;
     }
-    dir = dir / dist;
-    if(ball_v.dot(normal) < 0.0f) {
-        // FURI_LOG_I(TAG, "Collision Moving TOWARDS");
-        ball.p += dir * (ball.r - dist);
-    } else {
-        // TODO: This is key - we're moving away, so don't alter our v / prev_p!
-        // FURI_LOG_I(TAG, "Collision Moving AWAY");
-        return false;
-        // ball.p += dir * -(dist + ball.r);
+    RailCollider rail;
+    rail.first = colliders.segments.size();
+    rail.count = points.size() - 1;
+    rail.owner = id;
+    rail.bounce = bounce;
+    for(size_t i = 0; i < points.size() - 1; i++) {
+        colliders.segments.push_back({points[i], points[i + 1], normals[i]});
     }
-
-    // FURI_LOG_I(
-    //     TAG,
-    //     "p: %.3f,%.3f  dir: %.3f,%.3f  norm: %.3f,%.3f",
-    //     (double)ball.p.x,
-    //     (double)ball.p.y,
-    //     (double)dir.x,
-    //     (double)dir.y,
-    //     (double)normal.x,
-    //     (double)normal.y);
-    float v = ball_v.dot(dir);
-    float v_new = fabs(v) * bounce;
-    ball_v += dir * (v_new - v);
-    ball.prev_p = ball.p - ball_v;
-    return true;
+    colliders.rails.push_back(rail);
 }
 
 void Polygon::finalize() {
@@ -280,83 +303,8 @@ void Portal::draw(Canvas* canvas) {
 #endif
 }
 
-// TODO: simplify this code?
-bool Portal::collide(Ball& ball) {
-    Vec2 ball_v = ball.p - ball.prev_p;
-    float dist;
-
-    Vec2 a_cl = Vec2_closest(a1, a2, ball.p);
-    dist = (ball.p - a_cl).mag();
-    if(dist <= ball.r && ball_v.dot(na) < 0.0f) {
-        // entering portal a! move it to portal b
-        // how far "along" the portal are we?
-        enter_p = a_cl;
-        float offset = (a_cl - a1).mag() / amag;
-        ball.p = b2 - bu * (bmag * offset);
-        // ensure we're "outside" the next portal to prevent rapid re-entry
-        ball.p += nb * ball.r;
-
-        // get projections on entry portal
-        float m = -ball_v.dot(au); // tangent magnitude
-        float n = ball_v.dot(na); // normal magnitude
-
-        // FURI_LOG_I(
-        //     TAG,
-        //     "v: %.3f,%.3f  u: %.3f,%.3f  n: %.3f,%.3f  M: %.3f  N: %.3f",
-        //     (double)ball_v.x,
-        //     (double)ball_v.y,
-        //     (double)au.x,
-        //     (double)au.y,
-        //     (double)na.x,
-        //     (double)na.y,
-        //     (double)m,
-        //     (double)n);
-
-        // transform to exit portal
-        ball_v.x = bu.x * m - nb.x * n;
-        ball_v.y = bu.y * m - nb.y * n;
-        FURI_LOG_I(TAG, "new v: %.3f,%.3f", (double)ball_v.x, (double)ball_v.y);
-
-        ball.prev_p = ball.p - ball_v;
-        return true;
-    }
-
-    Vec2 b_cl = Vec2_closest(b1, b2, ball.p);
-    dist = (ball.p - b_cl).mag();
-    if(dist <= ball.r && ball_v.dot(nb) < 0.0f) {
-        // entering portal b! move it to portal a
-        // how far "along" the portal are we?
-        enter_p = b_cl;
-        float offset = (b_cl - b1).mag() / bmag;
-        ball.p = a2 - au * (amag * offset);
-        // ensure we're "outside" the next portal to prevent rapid re-entry
-        ball.p += na * ball.r;
-
-        // get projections on entry portal
-        float m = -ball_v.dot(bu); // tangent magnitude
-        float n = ball_v.dot(nb); // normal magnitude
-
-        // FURI_LOG_I(
-        //     TAG,
-        //     "v: %.3f,%.3f  u: %.3f,%.3f  n: %.3f,%.3f  M: %.3f  N: %.3f",
-        //     (double)ball_v.x,
-        //     (double)ball_v.y,
-        //     (double)bu.x,
-        //     (double)bu.y,
-        //     (double)nb.x,
-        //     (double)nb.y,
-        //     (double)m,
-        //     (double)n);
-
-        // transform to exit portal
-        ball_v.x = au.x * m - na.x * n;
-        ball_v.y = au.y * m - na.y * n;
-        FURI_LOG_I(TAG, "new v: %.3f,%.3f", (double)ball_v.x, (double)ball_v.y);
-
-        ball.prev_p = ball.p - ball_v;
-        return true;
-    }
-    return false;
+void Portal::bake(Colliders& colliders, uint16_t id) const {
+    colliders.portals.push_back({a1, a2, b1, b2, na, nb, au, bu, amag, bmag, id});
 }
 
 void Portal::reset_animation() {
@@ -388,6 +336,9 @@ Arc::Arc(const Vec2& p_, float r_, float s_, float e_, Surface surf_)
     , start(s_)
     , end(e_)
     , surface(surf_) {
+    if(!is_circle()) {
+        gfx_arc_outline(outline, p, r, start, end);
+    }
     // Vec2 s(p.x + r * cosf(start), p.y - r * sinf(start));
     // Vec2 e(p.x + r * cosf(end), p.y - r * sinf(end));
     // FURI_LOG_I(
@@ -398,119 +349,30 @@ void Arc::draw(Canvas* canvas) {
     if(hidden) {
         return;
     }
-    if(start == 0 && end == (float)M_PI * 2) {
+    if(is_circle()) {
         gfx_draw_circle(canvas, p, r);
     } else {
-        float adj_end = end;
-        if(end < start) {
-            adj_end += (float)M_PI * 2;
-        }
-        // initialize to start of arc
-        float sx = p.x + r * cosf(start);
-        float sy = p.y - r * sinf(start);
-        size_t segments = r / 8;
-        for(size_t i = 1; i <= segments; i++) { // for now, use r to determin number of segments
-            float nx = p.x + r * cosf(start + i / (segments / (adj_end - start)));
-            float ny = p.y - r * sinf(start + i / (segments / (adj_end - start)));
-            gfx_draw_line(canvas, sx, sy, nx, ny);
-            sx = nx;
-            sy = ny;
-        }
+        gfx_draw_polyline(canvas, outline);
     }
 }
 
-// returns value between 0 and 2 PI
-// assumes x,y are on cartesean plane, thus you should pass it a neg y
-// since the display on flipper is y-inverted
-float vector_to_angle(float x, float y) {
-    if(x == 0) // special cases UP or DOWN
-        return (y > 0) ? M_PI_2 : (y == 0) ? 0 : M_PI + M_PI_2;
-    else if(y == 0) // special cases LEFT or RIGHT
-        return (x >= 0) ? 0 : M_PI;
-    float ret = atanf(y / x); // quadrant I
-    if(x < 0 && y < 0) // quadrant III
-        ret = (float)M_PI + ret;
-    else if(x < 0) // quadrant II
-        ret = (float)M_PI + ret; // it actually substracts
-    else if(y < 0) // quadrant IV
-        ret = (float)M_PI + (float)M_PI_2 + ((float)M_PI_2 + ret); // it actually substracts
-    return ret;
-}
-
-// Matthias research - 10 minute physics
-bool Arc::collide(Ball& ball) {
-    Vec2 dir = ball.p - p;
-    float dist = dir.mag();
-    // FURI_LOG_I(
-    //     TAG,
-    //     "ball.p: %.3f,%.3f  p: %.3f,%.3f",
-    //     (double)ball.p.x,
-    //     (double)ball.p.y,
-    //     (double)p.x,
-    //     (double)p.y);
-    // FURI_LOG_I(TAG, "dir: %.3f,%.3f  dist: %.3f", (double)dir.x, (double)dir.y, (double)dist);
-
-    if(surface == OUTSIDE) {
-        if(dist > r + ball.r) {
-            return false;
-        }
-        // FURI_LOG_I(TAG, "hitting arc");
-        float angle = vector_to_angle(dir.x, -dir.y);
-        if((start < end && start <= angle && angle <= end) ||
-           (start > end && (angle >= start || angle <= end))) {
-            // FURI_LOG_I(TAG, "colliding with arc");
-            dir.normalize();
-
-            Vec2 ball_v = ball.p - ball.prev_p;
-            float corr = ball.r + r - dist;
-            ball.p += dir * corr;
-            float v = ball_v.dot(dir);
-            ball_v += dir * (3.0f - v); // TODO: pushVel, this should be a prop
-            ball.prev_p = ball.p - ball_v;
-            return true;
-        }
-    }
-    if(surface == INSIDE) {
-        Vec2 prev_dir = ball.prev_p - p;
-        float prev_dist = prev_dir.mag();
-        if(prev_dist < r && dist + ball.r > r) {
-            // FURI_LOG_I(TAG, "Inside an arc!");
-            float angle = vector_to_angle(dir.x, -dir.y);
-            // FURI_LOG_I(TAG, "%f : %f : %f", (double)start, (double)angle, (double)end);
-            // if(angle >= start && angle <= end) {
-            if((start < end && start <= angle && angle <= end) ||
-               (start > end && (angle >= start || angle <= end))) {
-                // FURI_LOG_I(TAG, "Within the arc angle");
-
-                dir.normalize();
-                Vec2 ball_v = ball.p - ball.prev_p;
-
-                // correct our position to be "on" the arc
-                float corr = dist + ball.r - r;
-                ball.p -= dir * corr;
-
-                // Adjust restitution on tangent and normals independently
-                Vec2 tangent = {-dir.y, dir.x};
-                float T = (ball_v.x * tangent.x + ball_v.y * tangent.y) * ARC_TANGENT_RESTITUTION;
-                float N = (ball_v.x * tangent.y - ball_v.y * tangent.x) * ARC_NORMAL_RESTITUTION;
-
-                ball_v.x = tangent.x * T - tangent.y * N;
-                ball_v.y = tangent.y * T + tangent.x * N;
-
-                // Current collision - works good, but handles restitution holistically
-                // float v = ball_v.dot(dir);
-                // ball_v -= dir * v * 2.0f * bounce;
-
-                ball.prev_p = ball.p - ball_v;
-                return true;
-            }
-        }
+void Arc::bake(Colliders& colliders, uint16_t id) const {
+    float span = end - start;
+    if(span < 0) {
+        span += (float)M_PI * 2;
     }
-    return false;
+    uint8_t sector = start == end                ? ArcSectorNone :
+                     span >= (float)M_PI * 2     ? ArcSectorFull :
+                     span <= (float)M_PI         ? ArcSectorMinor :
+                                                   ArcSectorMajor;
+    Vec2 s(cosf(Scalar(start)), sinf(Scalar(start)));
+    Vec2 e(cosf(Scalar(end)), sinf(Scalar(end)));
+    colliders.arcs.push_back({p, r, s, e, sector, (uint8_t)surface, id});
 }
 
 Bumper::Bumper(const Vec2& p_, float r_)
-    : Arc(p_, r_) {
+    : Arc(p_, r_)
+    , decay(0) {
     score = 500;
 }
 
@@ -535,23 +397,15 @@ void Bumper::step_animation() {
 
 void Rollover::draw(Canvas* canvas) {
     if(activated) {
-        canvas_draw_str_aligned(canvas, p.x / 10, p.y / 10, AlignCenter, AlignCenter, c);
+        canvas_draw_str_aligned(
+            canvas, (int)p.x / 10, (int)p.y / 10, AlignCenter, AlignCenter, c);
     } else {
         gfx_draw_dot(canvas, p);
     }
 }
 
-bool Rollover::collide(Ball& ball) {
-    if(activated) {
-        return false; // we've already rolled over it, prevent further signals
-    }
-    Vec2 dir = ball.p - p;
-    float dist = dir.mag();
-    if(dist < 30) {
-        activated = true;
-        return true;
-    }
-    return false;
+void Rollover::bake(Colliders& colliders, uint16_t id) const {
+    colliders.triggers.push_back({p, 30, Vec2(), false, id});
 }
 
 // Reset the rollover
@@ -567,6 +421,15 @@ void Rollover::reset_state() {
     activated = false;
 }
 
+uint8_t Rollover::snapshot() const {
+    return FixedObject::snapshot() | (activated ? 4 : 0);
+}
+
+void Rollover::restore(uint8_t state) {
+    FixedObject::restore(state);
+    activated = state & 4;
+}
+
 void Turbo::draw(Canvas* canvas) {
     gfx_draw_line(canvas, chevron_1[0], chevron_1[1]);
     gfx_draw_line(canvas, chevron_1[1], chevron_1[2]);
@@ -575,15 +438,10 @@ void Turbo::draw(Canvas* canvas) {
     gfx_draw_line(canvas, chevron_2[1], chevron_2[2]);
 }
 
-bool Turbo::collide(Ball& ball) {
-    float dist = (ball.p - p).mag();
-    // our distance check doesn't include the ball radius as we want the ball
-    // to enter the turbo area a bit before being affected by the boost
-    if(dist < r + 10) {
-        // apply the turbo in 'dir' with force of 'boost'
-        ball.prev_p = ball.p - (dir * (boost));
-    }
-    return false;
+// our distance check doesn't include the ball radius as we want the ball
+// to enter the turbo area a bit before being affected by the boost
+void Turbo::bake(Colliders& colliders, uint16_t id) const {
+    colliders.triggers.push_back({p, r + 10, dir * boost, true, id});
 }
 
 Plunger::Plunger(const Vec2& p_)
@@ -594,7 +452,7 @@ Plunger::Plunger(const Vec2& p_)
 
 void Plunger::draw(Canvas* canvas) {
     // draw the end / striker
-    canvas_draw_circle(canvas, p.x / 10, p.y / 10, r / 10);
+    canvas_draw_circle(canvas, (int)p.x / 10, (int)p.y / 10, (int)r / 10);
     // draw a line, adjusted for compression
     // canvas_draw_line(
     //     canvas,
@@ -606,62 +464,65 @@ void Plunger::draw(Canvas* canvas) {
 }
 
 void Chaser::draw(Canvas* canvas) {
-    Vec2& p1 = points[0];
-    Vec2& p2 = points[1];
+    // chasers live in screen coords
+    int x1 = (int)points[0].x;
+    int y1 = (int)points[0].y;
+    int x2 = (int)points[1].x;
+    int y2 = (int)points[1].y;
 
     // TODO: feels like we can do all this with less code?
     switch(style) {
     case Style::SLASH: // / / / / / / / / /
-        if(p1.x == p2.x) {
-            int start = p1.y;
-            int end = p2.y;
+        if(x1 == x2) {
+            int start = y1;
+            int end = y2;
             if(start < end) {
                 for(int y = start + offset; y < end; y += gap) {
-                    canvas_draw_line(canvas, p1.x - 2, y + 2, p1.x + 2, y - 2);
+                    canvas_draw_line(canvas, x1 - 2, y + 2, x1 + 2, y - 2);
                 }
             } else {
                 for(int y = start - offset; y > end; y -= gap) {
-                    canvas_draw_line(canvas, p1.x - 2, y + 2, p1.x + 2, y - 2);
+                    canvas_draw_line(canvas, x1 - 2, y + 2, x1 + 2, y - 2);
                 }
             }
-        } else if(p1.y == p2.y) {
-            int start = p1.x;
-            int end = p2.x;
+        } else if(y1 == y2) {
+            int start = x1;
+            int end = x2;
             if(start < end) {
                 for(int x = start + offset; x < end; x += gap) {
-                    canvas_draw_line(canvas, x - 2, p1.y + 2, x + 2, p1.y - 2);
+                    canvas_draw_line(canvas, x - 2, y1 + 2, x + 2, y1 - 2);
                 }
             } else {
                 for(int x = start - offset; x > end; x -= gap) {
-                    canvas_draw_line(canvas, x - 2, p1.y + 2, x + 2, p1.y - 2);
+                    canvas_draw_line(canvas, x - 2, y1 + 2, x + 2, y1 - 2);
                 }
             }
         }
         break;
     default: // Style::SIMPLE, just dots
         // for all pixels between p and q, draw them with offset and gap
-        if(p1.x == p2.x) {
-            int start = p1.y;
-            int end = p2.y;
+        if(x1 == x2) {
+            int start = y1;
+            int end = y2;
             if(start < end) {
                 for(int y = start + offset; y < end; y += gap) {
-                    canvas_draw_disc(canvas, p1.x, y, 1);
+                    canvas_draw_disc(canvas, x1, y, 1);
                 }
             } else {
                 for(int y = start - offset; y > end; y -= gap) {
-                    canvas_draw_disc(canvas, p1.x, y, 1);
+                    canvas_draw_disc(canvas, x1, y, 1);
                 }
             }
-        } else if(p1.y == p2.y) {
-            int start = p1.x;
-            int end = p2.x;
+        } else if(y1 == y2) {
+            int start = x1;
+            int end = x2;
             if(start < end) {
                 for(int x = start + offset; x < end; x += gap) {
-                    canvas_draw_disc(canvas, x, p1.y, 1);
+                    canvas_draw_disc(canvas, x, y1, 1);
                 }
             } else {
                 for(int x = start - offset; x > end; x -= gap) {
-                    canvas_draw_disc(canvas, x, p1.y, 1);
+                    canvas_draw_disc(canvas, x, y1, 1);
                 }
             }
         }
@@ -669,6 +530,12 @@ void Chaser::draw(Canvas* canvas) {
     }
 }
 
+// Chasers are never physical, and their points are in screen coords anyway
+void Chaser::bake(Colliders& colliders, uint16_t id) const {
+    UNUSED(colliders);
+    UNUSED(id);
+}
+
 void Chaser::step_animation() {
     tick++;
     if(tick % (speed) == 0) {
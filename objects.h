@@ -4,11 +4,14 @@
 #include <gui/canvas.h> // for Canvas*
 
 #include "signals.h"
+#include "colliders.h"
+#include "graphics.h"
 
 #define DEF_BALL_RADIUS   20
 #define DEF_BUMPER_RADIUS 40
 #define DEF_BUMPER_BOUNCE 1.0f
 #define DEF_FLIPPER_SIZE  120
+#define FLIPPER_LUT_SIZE  33 // sweep table entries, ~0.03 rad apart
 #define DEF_RAIL_BOUNCE   0.9f
 #define DEF_TURBO_RADIUS  20
 #define DEF_TURBO_BOOST   5
@@ -19,25 +22,25 @@
 // A dynamic, moveable object with acceleration
 class Object {
 public:
-    Object(const Vec2& p_, float r_);
+    Object(const Vec2& p_, Scalar r_);
     virtual ~Object() = default;
 
     // Verlet data
     Vec2 p; // position
     Vec2 prev_p; // previous position
     Vec2 a;
-    float r;
+    Scalar r;
 
     bool physical; // is this a real object that can be hit?
-    float bounce; // < 1 dampens, > 1 adds power
+    Scalar bounce; // < 1 dampens, > 1 adds power
     bool fixed; // should this move?
     int score; // incremental score for hitting this
 
-    void update(float dt); // updates position
+    void update(Scalar dt); // updates position
     inline void accelerate(const Vec2& da) {
         a += da;
     }
-    inline void add_velocity(const Vec2& v, float dt) {
+    inline void add_velocity(const Vec2& v, Scalar dt) {
         prev_p -= v * dt;
     }
 
@@ -46,10 +49,39 @@ public:
 
 class Ball : public Object {
 public:
-    Ball(const Vec2& p_ = Vec2(), float r_ = DEF_BALL_RADIUS)
-        : Object(p_, r_) {
+    Ball(const Vec2& p_ = Vec2(), Scalar r_ = DEF_BALL_RADIUS)
+        : Object(p_, r_)
+        , swept(false)
+        , asleep(false)
+        , still_steps(0)
+        , rest_p(p_) {
+    }
+
+    // True while prev_p -> p is the path the ball actually travelled in its last
+    // update. Collision responses rewrite prev_p, after which it is cleared and
+    // swept (continuous) collision tests are skipped until the next update.
+    bool swept;
+
+    // Is the ball moving far enough per step that it could tunnel through a rail?
+    bool needs_sweep() const {
+        return swept && (p - prev_p).mag2() > r * r;
+    }
+
+    // A ball that has stayed put for a while sleeps: solve() leaves it out of
+    // integration and collisions until something wakes it (see physics.h)
+    bool asleep;
+    uint16_t still_steps; // steps spent barely moving, near rest_p
+    Vec2 rest_p;
+    Vec2 step_p; // where the current step started, to see what contacts did
+
+    void wake() {
+        asleep = false;
+        still_steps = 0;
+        rest_p = p;
     }
     void draw(Canvas* canvas);
+    // Draws the ball alpha [0..1] of the way from prev_p to p
+    void draw(Canvas* canvas, float alpha);
 };
 
 class Flipper {
@@ -61,24 +93,38 @@ public:
 
     Flipper(const Vec2& p_, Side side, size_t size_ = DEF_FLIPPER_SIZE);
 
-    void draw(Canvas* canvas);
-    void update(float dt); // updates position to new position
+    // Draws the flipper alpha [0..1] of the way from its previous rotation
+    void draw(Canvas* canvas, float alpha = 1.0f);
+    void update(Scalar dt); // updates position to new position
     bool collide(Ball& ball);
 
     Vec2 get_tip() const;
 
+    // (Re)builds the sweep table; needed after changing rest_angle or max_rotation
+    void build_sweep();
+    // Unit direction from pivot to tip at rotation 'rot', and its normal on the
+    // side the flipper swings toward. Interpolated from the sweep table.
+    void sweep_at(Scalar rot, Vec2& dir, Vec2& normal) const;
+
     Vec2 p;
     Side side;
     size_t size;
-    float r;
+    Scalar r;
+
+    Scalar rest_angle;
+    Scalar max_rotation;
+    Scalar sign;
+    Scalar omega; // angular velocity
 
-    float rest_angle;
-    float max_rotation;
-    float sign;
-    float omega; // angular velocity
+    // dir and normal at FLIPPER_LUT_SIZE rotations evenly spread over
+    // [0, max_rotation], so collision and drawing need no trig
+    Vec2 sweep_dir[FLIPPER_LUT_SIZE];
+    Vec2 sweep_normal[FLIPPER_LUT_SIZE];
+    Scalar sweep_scale; // table entries per radian
 
-    float rotation;
-    float current_omega;
+    Scalar rotation;
+    Scalar prev_rotation; // rotation before the last update()
+    Scalar current_omega;
 
     bool powered; // is this flipper being activated? i.e. is keypad pressed?
 
@@ -97,17 +143,22 @@ public:
         , tx_id(INVALID_ID)
         , rx_id(INVALID_ID)
         , tx_type(SignalType::ALL)
+        , tx_group(0)
+        , tx_bit(0)
         , notification(nullptr) {
     }
     virtual ~FixedObject() = default;
 
-    float bounce;
+    Scalar bounce;
     bool physical; // interacts with ball vs table decoration
     bool hidden; // do not draw
     int score;
     int tx_id;
     int rx_id;
     SignalType tx_type;
+    // where SignalManager::validate() filed this object, if it sends
+    uint16_t tx_group;
+    uint32_t tx_bit;
 
     void (*notification)(void* app);
 
@@ -117,15 +168,37 @@ public:
     } saved;
 
     virtual void draw(Canvas* canvas) = 0;
-    virtual bool collide(Ball& ball) = 0;
+    // Adds this object's collision shapes to 'colliders', owned by objects[id]
+    virtual void bake(Colliders& colliders, uint16_t id) const = 0;
+    // Can the ball currently hit this object?
+    virtual bool collidable() const {
+        return physical;
+    }
+    // Called when one of our colliders was hit, at 'contact'
+    virtual void hit(const Vec2& /* contact */) {
+    }
     virtual void reset_animation() {};
     virtual void step_animation() {};
+    // Does draw() look the same for the life of the table? If so, the object
+    // is only drawn once, into the table's static layer.
+    virtual bool is_static() const {
+        return false;
+    }
+    // Signals can show and hide an object, so only one without them can be static
+    bool has_signals() const {
+        return tx_id != INVALID_ID || rx_id != INVALID_ID;
+    }
 
     virtual void signal_receive();
     virtual void signal_send();
 
     virtual void save_state();
     virtual void reset_state();
+
+    // Runtime state in a byte, for table snapshots: physical and hidden, and
+    // from bit 2 up whatever a subclass adds
+    virtual uint8_t snapshot() const;
+    virtual void restore(uint8_t state);
 };
 
 class Polygon : public FixedObject {
@@ -137,7 +210,10 @@ public:
     std::vector<Vec2> normals;
 
     void draw(Canvas* canvas);
-    bool collide(Ball& ball);
+    void bake(Colliders& colliders, uint16_t id) const;
+    bool is_static() const {
+        return !has_signals();
+    }
     void add_point(const Vec2& np) {
         points.push_back(np);
     }
@@ -158,14 +234,17 @@ public:
     Vec2 b1, b2; // portal 'b'
     Vec2 na, nb; // normals
     Vec2 au, bu; // unit vectors
-    float amag, bmag; // length of portals
+    Scalar amag, bmag; // length of portals
     bool bidirectional{true}; // TODO: ehhh?
 
     Vec2 enter_p; // where we entered portal
     size_t decay{0}; // used for animation
 
     void draw(Canvas* canvas);
-    bool collide(Ball& ball);
+    void bake(Colliders& colliders, uint16_t id) const;
+    void hit(const Vec2& contact) {
+        enter_p = contact;
+    }
     void reset_animation();
     void step_animation();
     void finalize();
@@ -186,12 +265,21 @@ public:
         Surface surf_ = OUTSIDE);
 
     Vec2 p;
-    float r;
+    Scalar r;
     float start;
     float end;
     Surface surface;
     void draw(Canvas* canvas);
-    bool collide(Ball& ball);
+    void bake(Colliders& colliders, uint16_t id) const;
+    bool is_static() const {
+        return !has_signals();
+    }
+    bool is_circle() const {
+        return start == 0 && end == (float)M_PI * 2;
+    }
+
+private:
+    std::vector<GfxPoint> outline; // screen points, unless it's a whole circle
 };
 
 class Bumper : public Arc {
@@ -203,6 +291,10 @@ public:
     void draw(Canvas* canvas);
     void reset_animation();
     void step_animation();
+    // only bumpers the ball can't hit never animate
+    bool is_static() const {
+        return Arc::is_static() && !physical;
+    }
 };
 
 class Plunger : public Object {
@@ -231,12 +323,21 @@ public:
     bool activated{false};
 
     void draw(Canvas* canvas);
-    bool collide(Ball& ball);
+    void bake(Colliders& colliders, uint16_t id) const;
+    // once rolled over it can't be hit again, preventing further signals
+    bool collidable() const {
+        return physical && !activated;
+    }
+    void hit(const Vec2& /* contact */) {
+        activated = true;
+    }
 
     void signal_receive();
     void signal_send();
 
     void reset_state();
+    uint8_t snapshot() const;
+    void restore(uint8_t state);
 };
 
 class Turbo : public FixedObject {
@@ -248,7 +349,7 @@ public:
         , boost(boost_)
         , r(radius_) {
         // Our boost direction
-        dir = Vec2(cosf(angle), -sinf(angle));
+        dir = Vec2(cosf(Scalar(angle)), -sinf(Scalar(angle)));
 
         // define the points of the chevrons at the 0 angle
         chevron_1[0] = Vec2(p.x, p.y - r);
@@ -285,7 +386,10 @@ public:
     Vec2 chevron_2[3];
 
     void draw(Canvas* canvas);
-    bool collide(Ball& ball);
+    void bake(Colliders& colliders, uint16_t id) const;
+    bool is_static() const {
+        return !has_signals();
+    }
 };
 
 // Visual item only - chase of dots in one direction
@@ -316,5 +420,9 @@ public:
     Style style;
 
     void draw(Canvas* canvas);
+    void bake(Colliders& colliders, uint16_t id) const;
     void step_animation();
+    bool is_static() const {
+        return false;
+    }
 };
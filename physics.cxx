@@ -0,0 +1,436 @@
+#include "pinball0.h"
+#include "table.h"
+#include "notifications.h"
+#include "physics.h"
+#include "frame_profile.h"
+
+// Queues a hit for dispatch_collision_events(), if there's anything to dispatch
+static void queue_hit(
+    Table* table,
+    CollisionEventType type,
+    uint16_t index,
+    void (*notification)(void* app),
+    int score) {
+    if(notification || score) {
+        table->events.push(type, index);
+    }
+}
+
+// Ball b hit one of objects[owner]'s colliders: let the object react, then
+// re-sync which objects can be hit. Only a sent signal can change other objects.
+// The signal is sent here, since it can change what the ball hits next; the
+// notification and score wait for dispatch_collision_events().
+static void solve_hit(PinballApp* pb, uint16_t owner, Ball& b, const Vec2& contact) {
+    Table* table = pb->table;
+    FixedObject* o = table->objects[owner];
+    table->stats.collisions++;
+    b.swept = false;
+    o->hit(contact);
+    if(pb->game_mode == GM_Tilted || table->balls_released == false) {
+        o->reset_state(); // ensure we do nothing!
+    } else {
+        queue_hit(table, CollisionEventObject, owner, o->notification, o->score);
+        // Send this object's signal (if defined)
+        table->sm.send(o);
+        o->reset_animation();
+    }
+    if(o->tx_id != INVALID_ID) {
+        table->colliders.sync(table->objects);
+        // the signal may have taken away what a sleeping ball rests on
+        table->wake_balls();
+    } else {
+        table->colliders.live[owner] = o->collidable();
+    }
+}
+
+// Calls fn(i - begin) for every set bit i of mask in [begin, end)
+template <typename F>
+static inline void
+    for_each_candidate(const std::vector<uint32_t>& mask, size_t begin, size_t end, F fn) {
+    for(size_t w = begin / 32; w * 32 < end; w++) {
+        uint32_t bits = mask[w];
+        if(w == begin / 32) {
+            bits &= ~0u << (begin % 32);
+        }
+        if((w + 1) * 32 > end) {
+            bits &= ~0u >> (32 - end % 32);
+        }
+        while(bits) {
+            fn(w * 32 + __builtin_ctz(bits) - begin);
+            bits &= bits - 1;
+        }
+    }
+}
+
+// Tests one ball against the static colliders near it, then the flippers
+static void solve_ball_collisions(PinballApp* pb, Ball& b) {
+    Table* table = pb->table;
+    Colliders& c = table->colliders;
+    PhysicsStats& stats = table->stats;
+
+    auto rail = [&](size_t i) {
+        const RailCollider& rc = c.rails[i];
+        if(c.live[rc.owner]) {
+            stats.collision_tests++;
+            if(collide_rail(c, rc, b)) solve_hit(pb, rc.owner, b, b.p);
+        }
+    };
+    auto arc = [&](size_t i) {
+        const ArcCollider& ac = c.arcs[i];
+        if(c.live[ac.owner]) {
+            stats.collision_tests++;
+            if(collide_arc(ac, b)) solve_hit(pb, ac.owner, b, b.p);
+        }
+    };
+    auto portal = [&](size_t i) {
+        const PortalCollider& pc = c.portals[i];
+        Vec2 contact;
+        if(c.live[pc.owner]) {
+            stats.collision_tests++;
+            if(collide_portal(pc, b, contact)) {
+                solve_hit(pb, pc.owner, b, contact);
+                b.wake(); // it's somewhere else now
+            }
+        }
+    };
+    auto trigger = [&](size_t i) {
+        const TriggerCollider& tc = c.triggers[i];
+        if(c.live[tc.owner]) {
+            stats.collision_tests++;
+            if(collide_trigger(tc, b)) solve_hit(pb, tc.owner, b, b.p);
+        }
+    };
+
+    if(table->grid.built()) {
+        // only test the colliders sharing a grid cell with this ball
+        const std::vector<uint32_t>& mask = table->grid.query(b);
+        {
+            FrameSectionScope scope(FrameSectionRails);
+            for_each_candidate(mask, 0, c.arcs_begin(), rail);
+        }
+        {
+            FrameSectionScope scope(FrameSectionArcs);
+            for_each_candidate(mask, c.arcs_begin(), c.portals_begin(), arc);
+        }
+        {
+            FrameSectionScope scope(FrameSectionPortals);
+            for_each_candidate(mask, c.portals_begin(), c.triggers_begin(), portal);
+        }
+        {
+            FrameSectionScope scope(FrameSectionTriggers);
+            for_each_candidate(mask, c.triggers_begin(), c.size(), trigger);
+        }
+    } else {
+        {
+            FrameSectionScope scope(FrameSectionRails);
+            for(size_t i = 0; i < c.rails.size(); i++) rail(i);
+        }
+        {
+            FrameSectionScope scope(FrameSectionArcs);
+            for(size_t i = 0; i < c.arcs.size(); i++) arc(i);
+        }
+        {
+            FrameSectionScope scope(FrameSectionPortals);
+            for(size_t i = 0; i < c.portals.size(); i++) portal(i);
+        }
+        {
+            FrameSectionScope scope(FrameSectionTriggers);
+            for(size_t i = 0; i < c.triggers.size(); i++) trigger(i);
+        }
+    }
+
+    FrameSectionScope scope(FrameSectionFlippers);
+    for(size_t i = 0; i < table->flippers.size(); i++) {
+        Flipper& f = table->flippers[i];
+        table->stats.collision_tests++;
+        if(f.collide(b)) {
+            table->stats.collisions++;
+            b.swept = false;
+            if(pb->game_mode == GM_Tilted) {
+                continue;
+            }
+            queue_hit(table, CollisionEventFlipper, i, f.notification, f.score);
+        }
+    }
+}
+
+#ifdef PHYSICS_ADAPTIVE_SUB_STEPS
+// Number of points along the last step's path to test for collisions, so that
+// the fastest ball on the table never moves more than PHYSICS_MAX_TRAVEL between them
+static uint32_t adaptive_samples(Table* table) {
+    Scalar v2 = 0;
+    for(auto& b : table->balls) {
+        v2 = fmaxf(v2, (b.p - b.prev_p).mag2());
+    }
+    uint32_t samples = (int)(sqrtf(v2) / PHYSICS_MAX_TRAVEL) + 1;
+    return samples < 1 ? 1 : samples > PHYSICS_MAX_SAMPLES ? PHYSICS_MAX_SAMPLES : samples;
+}
+#endif
+
+// Pushes apart one pair of touching balls and trades their velocities along
+// the line between them
+static void solve_ball_pair(Ball& ball1, Ball& ball2) {
+    if(ball1.asleep && ball2.asleep) {
+        return;
+    }
+    Vec2 axis = ball1.p - ball2.p;
+    Scalar dist2 = axis.mag2();
+    Scalar rr = ball1.r + ball2.r;
+    // a NaN position never passes, and balls exactly on top of each other
+    // have no axis to be pushed apart along
+    if(!(dist2 < rr * rr) || dist2 == 0) {
+        return;
+    }
+    ball1.wake();
+    ball2.wake();
+
+    Scalar dist = sqrtf(dist2);
+    Vec2 v1 = ball1.p - ball1.prev_p;
+    Vec2 v2 = ball2.p - ball2.prev_p;
+
+    Scalar factor = (dist - rr) / dist;
+    ball1.p -= axis * factor * 0.5f;
+    ball2.p -= axis * factor * 0.5f;
+
+    Scalar damping = 1.01f;
+    Scalar f1 = (damping * (axis.x * v1.x + axis.y * v1.y)) / dist2;
+    Scalar f2 = (damping * (axis.x * v2.x + axis.y * v2.y)) / dist2;
+
+    v1.x += f2 * axis.x - f1 * axis.x;
+    v2.x += f1 * axis.x - f2 * axis.x;
+    v1.y += f2 * axis.y - f1 * axis.y;
+    v2.y += f1 * axis.y - f2 * axis.y;
+
+    ball1.prev_p = ball1.p - v1;
+    ball2.prev_p = ball2.p - v2;
+    ball1.swept = false;
+    ball2.swept = false;
+}
+
+// Tests every pair of balls that are near each other, in index order. With a
+// few balls that's every pair; with more, the ball grid finds the near ones.
+static void solve_ball_pairs(Table* table) {
+    auto& balls = table->balls;
+    size_t n = balls.size();
+    if(n < PHYSICS_BALL_GRID_MIN) {
+        for(size_t b1 = 0; b1 < n; b1++) {
+            for(size_t b2 = b1 + 1; b2 < n; b2++) {
+                solve_ball_pair(balls[b1], balls[b2]);
+            }
+        }
+        table->stats.ball_tests += n * (n - 1) / 2;
+        return;
+    }
+
+    table->ball_grid.build(balls);
+    for(size_t b1 = 0; b1 < n; b1++) {
+        const auto& candidates = table->ball_grid.query(b1);
+        for(size_t w = 0; w < candidates.size(); w++) {
+            for(uint32_t bits = candidates[w]; bits; bits &= bits - 1) {
+                size_t b2 = w * 32 + __builtin_ctz(bits);
+                solve_ball_pair(balls[b1], balls[b2]);
+                table->stats.ball_tests++;
+            }
+        }
+    }
+}
+
+#ifndef PHYSICS_NO_SLEEP
+// Is the push 'contact' gave a ball this step holding it up against gravity?
+static bool supported(const Vec2& contact) {
+    Scalar side = contact.x < Scalar(0) ? -contact.x : contact.x;
+    return contact.y < Scalar(0) && side <= Scalar(PHYSICS_SLEEP_SLOPE) * -contact.y;
+}
+
+// Counts the steps a ball has barely moved for, held up by its contacts, and
+// puts it to sleep after enough of them. 'contact' is how far its collisions
+// moved it this step.
+static void settle_ball(Ball& b, const Vec2& contact) {
+    if(supported(contact) &&
+       (b.p - b.prev_p).mag2() < Scalar(PHYSICS_SLEEP_SPEED * PHYSICS_SLEEP_SPEED) &&
+       (b.p - b.rest_p).mag2() < Scalar(PHYSICS_SLEEP_DRIFT * PHYSICS_SLEEP_DRIFT)) {
+        if(++b.still_steps >= PHYSICS_SLEEP_STEPS) {
+            b.asleep = true;
+            b.prev_p = b.p;
+        }
+    } else {
+        b.wake();
+    }
+}
+#endif
+
+// Wakes the sleeping balls within reach of a flipper that's moving
+static void wake_near_flipper(Table* table, const Flipper& f) {
+    for(auto& b : table->balls) {
+        Scalar reach = Scalar((int)f.size) + f.r + b.r;
+        if(b.asleep && (b.p - f.p).mag2() < reach * reach) {
+            b.wake();
+        }
+    }
+}
+
+void solve(PinballApp* pb, uint32_t steps) {
+    Table* table = pb->table;
+
+    const Scalar sub_dt = PHYSICS_DT;
+    for(uint32_t ss = 0; ss < steps; ss++) {
+        FrameSectionScope step(FrameSectionStep);
+        table->stats.substeps++;
+
+        // apply gravity (and any other forces?)
+        // FURI_LOG_I(TAG, "Applying gravity");
+        if(table->balls_released) {
+            Scalar bump_amt = 1;
+            if(pb->keys[InputKeyUp]) {
+                bump_amt = -1.04f;
+                table->wake_balls();
+            }
+            for(auto& b : table->balls) {
+                if(b.asleep) {
+                    continue;
+                }
+                // We multiply GRAVITY by dt since gravity is based on seconds
+                b.accelerate(Vec2(0, GRAVITY * bump_amt * sub_dt));
+            }
+        }
+
+#ifndef PHYSICS_NO_SLEEP
+        for(auto& b : table->balls) {
+            b.step_p = b.p;
+        }
+#endif
+
+        // collisions among the balls
+        if(table->balls.size() > 1) {
+            FrameSectionScope scope(FrameSectionBalls);
+            solve_ball_pairs(table);
+        }
+
+        // collisions with static objects and flippers
+#ifdef PHYSICS_ADAPTIVE_SUB_STEPS
+        uint32_t samples = adaptive_samples(table);
+        for(auto& b : table->balls) {
+            if(b.asleep) {
+                continue;
+            }
+            if(samples > 1) {
+                // Test the last step's path at 'samples' points, ending at p.
+                // p and prev_p move together, so velocity is unchanged, and a
+                // bounce at one point redirects the rest of the path.
+                Vec2 back = (b.p - b.prev_p) * (Scalar((int)samples - 1) / Scalar((int)samples));
+                b.p -= back;
+                b.prev_p -= back;
+                b.swept = false;
+                for(uint32_t i = 1; i < samples; i++) {
+                    solve_ball_collisions(pb, b);
+                    Vec2 step = (b.p - b.prev_p) / Scalar((int)samples);
+                    b.p += step;
+                    b.prev_p += step;
+                }
+            }
+            solve_ball_collisions(pb, b);
+        }
+#else
+        for(auto& b : table->balls) {
+            if(!b.asleep) {
+                solve_ball_collisions(pb, b);
+            }
+        }
+#endif
+
+        // update positions - of balls AND flippers
+        if(table->balls_released) {
+            for(auto& b : table->balls) {
+                if(b.asleep) {
+                    table->stats.ball_steps_asleep++;
+                    continue;
+                }
+#ifndef PHYSICS_NO_SLEEP
+                Vec2 contact = b.p - b.step_p;
+#endif
+                b.update(sub_dt);
+                b.swept = true;
+#ifndef PHYSICS_NO_SLEEP
+                settle_ball(b, contact);
+#endif
+            }
+        }
+        for(auto& f : table->flippers) {
+            f.update(sub_dt);
+            if(f.rotation != f.prev_rotation) {
+                wake_near_flipper(table, f);
+            }
+        }
+    }
+
+    // Did any balls fall off the table?
+    if(table->balls.size()) {
+        auto num_in_play = table->balls.size();
+        auto i = table->balls.begin();
+        while(i != table->balls.end()) {
+            if(i->p.y > 1280 + 100) {
+                FURI_LOG_I(TAG, "ball off table!");
+                i = table->balls.erase(i);
+                num_in_play--;
+                table->events.lose_life();
+            } else {
+                ++i;
+            }
+        }
+        if(num_in_play == 0) {
+            table->balls_released = false;
+            table->lives.value--;
+            if(table->lives.value > 0) {
+                // Reset our ball to it's starting position, in the capacity
+                // bake() reserved, so nothing is allocated outside the arena
+                table->balls.assign(table->balls_initial.begin(), table->balls_initial.end());
+                if(pb->game_mode == GM_Tilted) {
+                    pb->game_mode = GM_Playing;
+                }
+            } else {
+                table->game_over = true;
+            }
+        }
+    }
+}
+
+void dispatch_collision_events(PinballApp* pb) {
+    Table* table = pb->table;
+    CollisionEvents& events = table->events;
+    uint32_t n = events.pending();
+    // each distinct notification plays once, in the order of the hits; the
+    // notification service queues them
+    void (*notifications[PHYSICS_MAX_NOTIFICATIONS])(void* app);
+    size_t notification_count = 0;
+    for(uint32_t i = 0; i < n; i++) {
+        // an object hit on several substeps, or by several balls, is queued once
+        const CollisionEvent& e = events.at(i);
+        void (*notify)(void* app);
+        if(e.type == CollisionEventFlipper) {
+            const Flipper& f = table->flippers[e.index];
+            table->score.value += f.score;
+            notify = f.notification;
+        } else {
+            const FixedObject* o = table->objects[e.index];
+            table->score.value += o->score;
+            notify = o->notification;
+        }
+        // two bumpers in one frame still make the one bumper sound
+        bool queued = notify == nullptr;
+        for(size_t j = 0; j < notification_count && !queued; j++) {
+            queued = notifications[j] == notify;
+        }
+        if(!queued && notification_count < PHYSICS_MAX_NOTIFICATIONS) {
+            notifications[notification_count++] = notify;
+        }
+    }
+    events.release(n);
+    for(size_t i = 0; i < notification_count; i++) {
+        (*notifications[i])(pb);
+    }
+    // last, as it blocks until played and its LEDs would be overwritten by a
+    // hit's after it
+    if(events.take_lost_life()) {
+        notify_lost_life(pb);
+    }
+}
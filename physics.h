@@ -0,0 +1,54 @@
+#pragma once
+
+#include "pinball0.h"
+
+// Gravity should be lower than 9.8 m/s^2 since the ball is on
+// an angled table. We could calc this and derive the actual
+// vertical vector based on the angle of the table yadda yadda yadda
+#define GRAVITY           3.0f // 9.8f
+#define PHYSICS_SUB_STEPS 5
+
+// Physics always advances in fixed steps of PHYSICS_DT seconds,
+// PHYSICS_SUB_STEPS of them per frame at GAME_FPS
+#define PHYSICS_STEPS_PER_SEC (GAME_FPS * PHYSICS_SUB_STEPS)
+#define PHYSICS_DT            (1.0f / PHYSICS_STEPS_PER_SEC)
+// Cap on steps per solve() call at GAME_FPS, so one slow frame can't snowball
+// into more; longer frames get their extra steps on top
+#define PHYSICS_MAX_STEPS (PHYSICS_SUB_STEPS * 4)
+
+// Fast balls are caught by swept tests against rails and flippers. Defining
+// PHYSICS_ADAPTIVE_SUB_STEPS additionally splits each step's collision pass
+// into up to PHYSICS_MAX_SAMPLES passes along the path of the fastest ball,
+// which also covers arcs, bumpers and other round objects.
+// #define PHYSICS_ADAPTIVE_SUB_STEPS
+#define PHYSICS_MAX_TRAVEL  (DEF_BALL_RADIUS / 2)
+#define PHYSICS_MAX_SAMPLES 4
+
+// Ball-ball collisions test every pair below PHYSICS_BALL_GRID_MIN balls, and
+// only the pairs in neighbouring cells of a per-step ball grid from there up
+#define PHYSICS_BALL_GRID_MIN 4
+
+// A ball that moves less than PHYSICS_SLEEP_SPEED per step, and stays within
+// PHYSICS_SLEEP_DRIFT of where it stopped, for PHYSICS_SLEEP_STEPS steps in a
+// row falls asleep, like one resting in the plunger lane or on a held flipper.
+// Every one of those steps its contacts must hold it up against gravity: push
+// it upwards, leaning no more than PHYSICS_SLEEP_SLOPE sideways per unit up.
+// A ball crawling down a gentle slope is never held up like that, so it never
+// freezes there.
+// It wakes when a flipper near it moves, the table is bumped or tilted, a
+// signal changes the table, or an awake ball touches it; going through a
+// portal starts a ball's count over. Uncomment to keep every ball awake.
+// #define PHYSICS_NO_SLEEP
+#define PHYSICS_SLEEP_STEPS 30
+#define PHYSICS_SLEEP_SPEED 0.05f
+#define PHYSICS_SLEEP_DRIFT 1.0f
+#define PHYSICS_SLEEP_SLOPE 0.02f
+
+// Advances the current table by 'steps' fixed steps of PHYSICS_DT
+void solve(PinballApp* pb, uint32_t steps);
+// Distinct notifications one frame's hits can play; there are fewer kinds
+#define PHYSICS_MAX_NOTIFICATIONS 8
+
+// Scores the hits queued by solve() and plays each kind of notification they
+// make once. Call once per frame, after solve().
+void dispatch_collision_events(PinballApp* pb);
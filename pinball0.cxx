@@ -1,4 +1,5 @@
 #include <furi.h>
+#include <furi_hal.h>
 
 #include <notification/notification.h>
 #include <cstring>
@@ -6,153 +7,95 @@
 #include "table.h"
 #include "notifications.h"
 #include "settings.h"
+#include "physics.h"
+#include "graphics.h"
+#include "frame_profile.h"
 
 /* generated by fbt from .png files in images folder */
 #include <pinball0_icons.h>
 
-// Gravity should be lower than 9.8 m/s^2 since the ball is on
-// an angled table. We could calc this and derive the actual
-// vertical vector based on the angle of the table yadda yadda yadda
-#define GRAVITY           3.0f // 9.8f
-#define PHYSICS_SUB_STEPS 5
-#define GAME_FPS          30
 #define MANUAL_ADJUSTMENT 20
 #define IDLE_TIMEOUT      120 * 1000 // 120 seconds * 1000 ticks/sec
 #define BUMP_COOLDOWN     1 * 1000 // 1 seconds
 #define BUMP_MAX          3
+#define IDLE_SLOW_TIMEOUT 15 * 1000 // drop to IDLE_FPS after 15 seconds without input
+#define IDLE_FPS          5
+
+// Debug mode report of the last table load: ms and allocations per phase, and
+// the table's arena use if it loaded
+static void draw_load_profile(
+    Canvas* canvas,
+    const LoadProfile& profile,
+    const Arena* arena,
+    int y) {
+    const int line = 8;
+    const int rows = LoadPhaseCount + 2 + (arena ? 1 : 0);
+    canvas_set_font(canvas, FontSecondary);
+    canvas_set_color(canvas, ColorWhite);
+    canvas_draw_box(canvas, 0, y - 1, LCD_WIDTH, line * rows + 1);
+    canvas_set_color(canvas, ColorBlack);
+
+    char buf[16];
+    for(int i = 0; i <= LoadPhaseCount; i++) {
+        LoadPhase phase = (LoadPhase)i;
+        uint32_t us = load_profile_us(&profile, phase);
+        uint32_t allocs = phase == LoadPhaseCount ? load_profile_allocs(&profile) :
+                                                    profile.allocs[phase];
+        canvas_draw_str_aligned(canvas, 1, y, AlignLeft, AlignTop, load_profile_phase_name(phase));
+        snprintf(buf, sizeof(buf), "%lu.%lu", us / 1000, us % 1000 / 100);
+        canvas_draw_str_aligned(canvas, 42, y, AlignRight, AlignTop, buf);
+        snprintf(buf, sizeof(buf), "%lu", allocs);
+        canvas_draw_str_aligned(canvas, 63, y, AlignRight, AlignTop, buf);
+        y += line;
+    }
+    canvas_draw_str_aligned(canvas, 1, y, AlignLeft, AlignTop, "peak");
+    snprintf(buf, sizeof(buf), "%uB", profile.heap_start - profile.heap_min);
+    canvas_draw_str_aligned(canvas, 63, y, AlignRight, AlignTop, buf);
+    if(arena) {
+        y += line;
+        canvas_draw_str_aligned(canvas, 1, y, AlignLeft, AlignTop, "arena");
+        snprintf(buf, sizeof(buf), "%u/%u", arena->used(), arena->capacity());
+        canvas_draw_str_aligned(canvas, 63, y, AlignRight, AlignTop, buf);
+    }
+}
 
-void solve(PinballApp* pb, float dt) {
-    Table* table = pb->table;
-
-    float sub_dt = dt / PHYSICS_SUB_STEPS;
-    for(int ss = 0; ss < PHYSICS_SUB_STEPS; ss++) {
-        // apply gravity (and any other forces?)
-        // FURI_LOG_I(TAG, "Applying gravity");
-        if(table->balls_released) {
-            float bump_amt = 1.0f;
-            if(pb->keys[InputKeyUp]) {
-                bump_amt = -1.04f;
-            }
-            for(auto& b : table->balls) {
-                // We multiply GRAVITY by dt since gravity is based on seconds
-                b.accelerate(Vec2(0, GRAVITY * bump_amt * sub_dt));
-            }
-        }
-
-        // apply collisions (among moving objects)
-        // only needed for multi-ball! - is this true? what about flippers...
-        for(size_t b1 = 0; b1 < table->balls.size(); b1++) {
-            for(size_t b2 = b1 + 1; b2 < table->balls.size(); b2++) {
-                if(b1 != b2) {
-                    auto& ball1 = table->balls[b1];
-                    auto& ball2 = table->balls[b2];
-
-                    Vec2 axis = ball1.p - ball2.p;
-                    float dist2 = axis.mag2();
-                    float dist = sqrtf(dist2);
-                    float rr = ball1.r + ball2.r;
-                    if(dist < rr) {
-                        Vec2 v1 = ball1.p - ball1.prev_p;
-                        Vec2 v2 = ball2.p - ball2.prev_p;
-
-                        float factor = (dist - rr) / dist;
-                        ball1.p -= axis * factor * 0.5f;
-                        ball2.p -= axis * factor * 0.5f;
-
-                        float damping = 1.01f;
-                        float f1 = (damping * (axis.x * v1.x + axis.y * v1.y)) / dist2;
-                        float f2 = (damping * (axis.x * v2.x + axis.y * v2.y)) / dist2;
-
-                        v1.x += f2 * axis.x - f1 * axis.x;
-                        v2.x += f1 * axis.x - f2 * axis.x;
-                        v1.y += f2 * axis.y - f1 * axis.y;
-                        v2.y += f1 * axis.y - f2 * axis.y;
-
-                        ball1.prev_p = ball1.p - v1;
-                        ball2.prev_p = ball2.p - v2;
-                    }
-                }
-            }
-        }
-
-        // collisions with static objects and flippers
-        for(auto& b : table->balls) {
-            for(auto& o : table->objects) {
-                if(o->physical && o->collide(b)) {
-                    if(pb->game_mode == GM_Tilted || table->balls_released == false) {
-                        o->reset_state(); // ensure we do nothing!
-                        continue;
-                    }
-                    if(o->notification) {
-                        (*o->notification)(pb);
-                    }
-                    // Send this object's signal (if defined)
-                    table->sm.send(o);
-
-                    table->score.value += o->score;
-                    o->reset_animation();
-                    continue;
-                }
-            }
-            for(auto& f : table->flippers) {
-                if(f.collide(b)) {
-                    if(pb->game_mode == GM_Tilted) {
-                        continue;
-                    }
-                    if(f.notification) {
-                        (*f.notification)(pb);
-                    }
-                    table->score.value += f.score;
-                    continue;
-                }
-            }
-        }
-
-        // update positions - of balls AND flippers
-        if(table->balls_released) {
-            for(auto& b : table->balls) {
-                b.update(sub_dt);
-            }
-        }
-        for(auto& f : table->flippers) {
-            f.update(sub_dt);
-        }
+// Formats a time for the profile overlay: whole us below a millisecond, and ms
+// with one decimal from there up, so a point always means ms
+static void format_profile_time(char* buf, size_t size, uint32_t us) {
+    if(us < 1000) {
+        snprintf(buf, size, "%lu", us);
+    } else {
+        snprintf(buf, size, "%lu.%lu", us / 1000, us % 1000 / 100);
     }
+}
 
-    // Did any balls fall off the table?
-    if(table->balls.size()) {
-        auto num_in_play = table->balls.size();
-        auto i = table->balls.begin();
-        while(i != table->balls.end()) {
-            if(i->p.y > 1280 + 100) {
-                FURI_LOG_I(TAG, "ball off table!");
-                i = table->balls.erase(i);
-                num_in_play--;
-                notify_lost_life(pb);
-            } else {
-                ++i;
-            }
-        }
-        if(num_in_play == 0) {
-            table->balls_released = false;
-            table->lives.value--;
-            if(table->lives.value > 0) {
-                // Reset our ball to it's starting position
-                table->balls = table->balls_initial;
-                if(pb->game_mode == GM_Tilted) {
-                    pb->game_mode = GM_Playing;
-                }
-            } else {
-                table->game_over = true;
-            }
-        }
+// Debug mode overlay of the last frame profile window: min, avg and max time
+// of each section
+static void draw_frame_profile(Canvas* canvas, const FrameProfile& profile, int y) {
+    const int line = 8;
+    canvas_set_font(canvas, FontSecondary);
+    canvas_set_color(canvas, ColorWhite);
+    canvas_draw_box(canvas, 0, y - 1, LCD_WIDTH, line * FrameSectionCount + 1);
+    canvas_set_color(canvas, ColorBlack);
+
+    char buf[8];
+    for(int i = 0; i < FrameSectionCount; i++) {
+        const FrameStat& stat = profile.last[i];
+        canvas_draw_str_aligned(
+            canvas, 1, y, AlignLeft, AlignTop, frame_profile_section_label((FrameSection)i));
+        format_profile_time(buf, sizeof(buf), frame_profile_us(&profile, stat.min));
+        gfx_draw_str(canvas, 35, y + 1, AlignRight, AlignTop, buf);
+        format_profile_time(buf, sizeof(buf), frame_profile_us(&profile, stat.avg));
+        gfx_draw_str(canvas, 49, y + 1, AlignRight, AlignTop, buf);
+        format_profile_time(buf, sizeof(buf), frame_profile_us(&profile, stat.max));
+        gfx_draw_str(canvas, 63, y + 1, AlignRight, AlignTop, buf);
+        y += line;
     }
 }
 
-static void pinball_draw_callback(Canvas* const canvas, void* ctx) {
-    furi_assert(ctx);
-    PinballApp* pb = (PinballApp*)ctx;
-    furi_mutex_acquire(pb->mutex, FuriWaitForever);
+static void pinball_draw(Canvas* const canvas, PinballApp* pb) {
+    // the table's unchanging parts go down first, while the canvas is blank
+    pb->table->draw_static(canvas);
 
     // What are we drawing? table select / menu or the actual game?
     switch(pb->game_mode) {
@@ -186,6 +129,9 @@ static void pinball_draw_callback(Canvas* const canvas, void* ctx) {
     } break;
     case GM_Playing:
         pb->table->draw(canvas);
+        if(pb->settings.debug_mode && !pb->table->balls_released && pb->load_profile.valid) {
+            draw_load_profile(canvas, pb->load_profile, &pb->table->arena, 8);
+        }
         break;
     case GM_GameOver: {
         pb->table->draw(canvas);
@@ -244,6 +190,9 @@ static void pinball_draw_callback(Canvas* const canvas, void* ctx) {
         }
 
         pb->table->draw(canvas);
+        if(pb->settings.debug_mode && pb->load_profile.valid) {
+            draw_load_profile(canvas, pb->load_profile, nullptr, 70);
+        }
     } break;
     case GM_Settings: {
         // TODO: like... do better here. maybe vector of settings strings, etc
@@ -334,7 +283,20 @@ static void pinball_draw_callback(Canvas* const canvas, void* ctx) {
         FURI_LOG_E(TAG, "Unknown Game Mode");
         break;
     }
+}
 
+static void pinball_draw_callback(Canvas* const canvas, void* ctx) {
+    furi_assert(ctx);
+    PinballApp* pb = (PinballApp*)ctx;
+    furi_mutex_acquire(pb->mutex, FuriWaitForever);
+    {
+        FrameSectionScope scope(FrameSectionDraw);
+        pinball_draw(canvas, pb);
+    }
+    if(pb->settings.debug_mode && pb->frame_profile.valid && pb->table->balls_released &&
+       (pb->game_mode == GM_Playing || pb->game_mode == GM_Tilted)) {
+        draw_frame_profile(canvas, pb->frame_profile, 8);
+    }
     furi_mutex_release(pb->mutex);
 }
 
@@ -356,7 +318,7 @@ PinballApp::PinballApp() {
 
     storage = (Storage*)furi_record_open(RECORD_STORAGE);
     notify = (NotificationApp*)furi_record_open(RECORD_NOTIFICATION);
-    // notify_init();
+    notify_init();
     notification_message(notify, &sequence_display_backlight_enforce_on);
 
     table = NULL;
@@ -368,13 +330,21 @@ PinballApp::PinballApp() {
     keys[InputKeyRight] = false;
     keys[InputKeyLeft] = false;
 
+    load_profile.valid = false;
+    frame_profile.valid = false;
+    replay.recording = false;
+    replay.playing = false;
+    replay.file = nullptr;
+    resume.active = false;
+
     initialized = true;
 }
 
 PinballApp::~PinballApp() {
+    replay_end(this);
     furi_mutex_free(mutex);
     delete table;
-    // notify_free();
+    notify_free();
 
     notification_message(notify, &sequence_display_backlight_enforce_auto);
     notification_message(notify, &sequence_reset_rgb);
@@ -383,6 +353,20 @@ PinballApp::~PinballApp() {
     furi_record_close(RECORD_NOTIFICATION);
 }
 
+// How long a frame of the current screen lasts, in ms, or 0 if nothing on it
+// moves and it only needs redrawing on input. Anything but a ball in play
+// slows to IDLE_FPS once the player has left it alone for a while.
+static uint32_t frame_period(const PinballApp& app, uint32_t now) {
+    if(app.game_mode == GM_Settings) {
+        return 0;
+    }
+    if((app.game_mode == GM_Playing || app.game_mode == GM_Tilted) &&
+       app.table->balls_released) {
+        return 1000 / GAME_FPS;
+    }
+    return now - app.idle_start >= IDLE_SLOW_TIMEOUT ? 1000 / IDLE_FPS : 1000 / GAME_FPS;
+}
+
 extern "C" int32_t pinball0_app(void* p) {
     UNUSED(p);
 
@@ -393,6 +377,9 @@ extern "C" int32_t pinball0_app(void* p) {
     }
 
     pinball_load_settings(app);
+    if(app.settings.debug_mode) {
+        frame_profile_begin(&app.frame_profile);
+    }
 
     // read the list of tables from storage
     table_table_list_init(&app);
@@ -416,19 +403,38 @@ extern "C" int32_t pinball0_app(void* p) {
 
     app.processing = true;
 
-    float dt = 0.0f;
+    // Elapsed time is accumulated in units of 1/PHYSICS_STEPS_PER_SEC ms, so that
+    // one physics step is exactly 1000 units and no rounding drift builds up
+    uint32_t accumulator = 0;
     uint32_t last_frame_time = furi_get_tick();
     app.idle_start = last_frame_time;
 
-    // I'm not thrilled with this event loop - kinda messy but it'll do for now
+    // frame budget tracking, reported in debug mode
+    uint32_t frame_work_max = 0;
+    uint32_t frame_work_total = 0;
+
+    // The loop sleeps on the input queue until either a key is pressed or the
+    // next frame is due. Screens with nothing moving get no frames at all.
+    uint32_t next_frame = last_frame_time;
     InputEvent event;
     while(app.processing) {
-        FuriStatus event_status = furi_message_queue_get(event_queue, &event, 10);
+        uint32_t now = furi_get_tick();
+        uint32_t period = frame_period(app, now);
+        uint32_t wait = FuriWaitForever;
+        if(period) {
+            wait = (int32_t)(next_frame - now) > 0 ? next_frame - now : 0;
+        }
+        FuriStatus event_status = furi_message_queue_get(event_queue, &event, wait);
         furi_mutex_acquire(app.mutex, FuriWaitForever);
+        uint32_t frame_start = furi_get_tick();
 
         if(event_status == FuriStatusOk) {
-            if(event.type == InputTypePress || event.type == InputTypeLong ||
-               event.type == InputTypeRepeat) {
+            FrameSectionScope scope(FrameSectionInput);
+            if(app.replay.playing && event.key != InputKeyBack) {
+                // the recording has the keys until it ends
+            } else if(
+                event.type == InputTypePress || event.type == InputTypeLong ||
+                event.type == InputTypeRepeat) {
                 switch(event.key) {
                 case InputKeyBack: // navigate to previous screen or exit
                     switch(app.game_mode) {
@@ -439,6 +445,8 @@ extern "C" int32_t pinball0_app(void* p) {
                         pinball_save_settings(app);
                         // fall through
                     default:
+                        resume_save(&app);
+                        replay_end(&app);
                         app.game_mode = GM_TableSelect;
                         table_load_table(&app, TABLE_SELECT);
                         break;
@@ -515,10 +523,7 @@ extern "C" int32_t pinball0_app(void* p) {
                                 } else {
                                     FURI_LOG_W(TAG, "TABLE TILTED!");
                                     app.game_mode = GM_Tilted;
-                                    app.table->bump_count = 0;
-                                    for(auto& o : app.table->objects) {
-                                        o->reset_state();
-                                    }
+                                    app.table->tilt();
                                     notify_table_tilted(&app);
                                 }
                             }
@@ -573,15 +578,30 @@ extern "C" int32_t pinball0_app(void* p) {
                         break;
                     case GM_TableSelect: {
                         size_t sel = app.table_list.selected;
+                        const auto& item = app.table_list.menu_items[sel];
+                        const char* filename = furi_string_get_cstr(item.filename);
+                        bool resume = !strcmp(filename, RESUME_MENU_FILENAME);
+                        bool replay = !strcmp(filename, REPLAY_MENU_FILENAME);
+                        // continuing and replaying set the game mode themselves
                         if(sel == app.table_list.menu_items.size() - 1) {
                             app.game_mode = GM_Settings;
                             table_load_table(&app, TABLE_SETTINGS);
-                        } else if(!table_load_table(&app, sel + TABLE_INDEX_OFFSET)) {
+                        } else if(
+                            resume ? resume_continue(&app) :
+                            replay ? replay_play(&app, REPLAY_PATH) :
+                                     table_load_table(&app, sel + TABLE_INDEX_OFFSET)) {
+                            if(!resume && !replay) {
+                                const char* name = furi_string_get_cstr(item.name);
+                                app.game_mode = GM_Playing;
+                                resume_begin(&app, filename, name);
+                                if(app.settings.debug_mode) {
+                                    replay_record(&app, REPLAY_PATH, name);
+                                }
+                            }
+                        } else {
                             app.game_mode = GM_Error;
                             table_load_table(&app, TABLE_ERROR);
                             notify_error_message(&app);
-                        } else {
-                            app.game_mode = GM_Playing;
                         }
                     } break;
                     case GM_Settings:
@@ -597,6 +617,11 @@ extern "C" int32_t pinball0_app(void* p) {
                             break;
                         case 3:
                             app.settings.debug_mode = !app.settings.debug_mode;
+                            if(app.settings.debug_mode) {
+                                frame_profile_begin(&app.frame_profile);
+                            } else {
+                                frame_profile_end();
+                            }
                             break;
                         default:
                             break;
@@ -625,16 +650,89 @@ extern "C" int32_t pinball0_app(void* p) {
             app.idle_start = furi_get_tick();
         }
 
-        // update physics / motion
-        solve(&app, dt);
-        for(auto& o : app.table->objects) {
-            o->step_animation();
+        // the key may have changed screens, or woken one up from its idle tick
+        period = frame_period(app, frame_start);
+        if(event_status == FuriStatusOk &&
+           (int32_t)(next_frame - frame_start) > (int32_t)period) {
+            next_frame = frame_start;
+        }
+        bool frame_due = period && (int32_t)(frame_start - next_frame) >= 0;
+        if(!frame_due) {
+            if(!period) {
+                // nothing moves here, so there's no physics to catch up on later
+                last_frame_time = frame_start;
+                if(event_status == FuriStatusOk) {
+                    view_port_update(view_port);
+                }
+            }
+            furi_mutex_release(app.mutex);
+            continue;
+        }
+        next_frame += period;
+        if((int32_t)(frame_start - next_frame) >= 0) {
+            next_frame = frame_start + period; // running late, don't try to catch up
+        }
+
+        // update physics / motion in fixed steps; a long stall only costs as
+        // much over a frame's steps as PHYSICS_MAX_STEPS is over a game frame's,
+        // and the rest of the backlog is dropped. Idle frames are longer and
+        // need more steps, or their animations would run slow.
+        accumulator += (frame_start - last_frame_time) * PHYSICS_STEPS_PER_SEC;
+        last_frame_time = frame_start;
+        uint32_t frame_steps = (period * PHYSICS_STEPS_PER_SEC + 999) / 1000;
+        uint32_t max_steps = frame_steps + PHYSICS_MAX_STEPS - PHYSICS_SUB_STEPS;
+        if(max_steps < PHYSICS_MAX_STEPS) {
+            max_steps = PHYSICS_MAX_STEPS;
+        }
+        uint32_t steps = accumulator / 1000;
+        if(steps > max_steps) {
+            steps = max_steps;
+            accumulator = steps * 1000;
         }
+        accumulator -= steps * 1000;
+        replay_frame(&app, &steps);
+        solve(&app, steps);
+        dispatch_collision_events(&app);
+        replay_frame_done(&app, steps);
+        app.table->alpha = accumulator / 1000.0f;
+
+        if(app.settings.debug_mode && app.tick % (GAME_FPS * 10) == 0) {
+            if(app.table->grid.built()) {
+                FURI_LOG_I(
+                    TAG,
+                    "Broadphase: %lu narrow tests, %lu skipped",
+                    app.table->grid.narrow_tests,
+                    app.table->grid.narrow_skipped);
+            }
+            FURI_LOG_I(
+                TAG,
+                "Table arena: %u of %u bytes used, %u block(s)",
+                app.table->arena.used(),
+                app.table->arena.capacity(),
+                app.table->arena.blocks());
+            FURI_LOG_I(
+                TAG,
+                "Frame: avg %lu ms, max %lu ms, budget %d ms",
+                frame_work_total / (GAME_FPS * 10),
+                frame_work_max,
+                1000 / GAME_FPS);
+            frame_work_max = 0;
+            frame_work_total = 0;
+            FURI_LOG_I(TAG, "Static layer %s", app.table->static_layer_ready ? "on" : "off");
+            if(app.table->events.dropped) {
+                FURI_LOG_W(TAG, "Collision events: %lu dropped", app.table->events.dropped);
+            }
+            frame_profile_log(&app.frame_profile);
+        }
+        app.table->step_animation();
+        frame_profile_end_frame();
 
         // check game state
         if(app.game_mode != GM_GameOver && app.table->game_over) {
             FURI_LOG_I(TAG, "GAME OVER!");
             app.game_mode = GM_GameOver;
+            replay_end(&app);
+            resume_stop(&app);
             notify_game_over(&app);
         }
 
@@ -650,18 +748,14 @@ extern "C" int32_t pinball0_app(void* p) {
             break;
         }
 
-        // game loop timing
-        uint32_t time_lapsed = current_tick - last_frame_time;
-        dt = time_lapsed / 1000.0f;
-        while(dt < 1.0f / GAME_FPS) {
-            time_lapsed = furi_get_tick() - last_frame_time;
-            dt = time_lapsed / 1000.0f;
-        }
+        uint32_t frame_work = current_tick - frame_start;
+        frame_work_total += frame_work;
+        if(frame_work > frame_work_max) frame_work_max = frame_work;
         app.tick++;
-        last_frame_time = furi_get_tick();
     }
 
     // general cleanup
+    frame_profile_end();
     view_port_enabled_set(view_port, false);
     gui_remove_view_port(gui, view_port);
     furi_record_close(RECORD_GUI);
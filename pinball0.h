@@ -17,6 +17,10 @@
 #include "vec2.h"
 #include "objects.h"
 #include "settings.h"
+#include "load_profile.h"
+#include "frame_profile.h"
+#include "replay.h"
+#include "resume.h"
 
 // #define DRAW_NORMALS
 
@@ -27,6 +31,8 @@
 #define LCD_WIDTH  64
 #define LCD_HEIGHT 128
 
+#define GAME_FPS 30
+
 typedef enum GameMode {
     GM_TableSelect,
     GM_Playing,
@@ -84,4 +90,9 @@ typedef struct PinballApp {
     NotificationApp* notify; // allows us to blink/buzz during game
     char text[256]; // general temp buffer
 
+    LoadProfile load_profile; // of the last table loaded from file
+    FrameProfile frame_profile; // hot-path timing, active in debug mode
+    Replay replay; // the game being recorded or played back
+    Resume resume; // the game to save if it's left unfinished
+
 } PinballApp;
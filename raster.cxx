@@ -0,0 +1,348 @@
+#include <furi.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raster.h"
+
+static_assert(LCD_WIDTH == 64, "RasterRows keeps a row in one uint64_t");
+
+namespace {
+// Rasters for the last few canvases seen: the app only ever has the one, the
+// host benchmark draws into two
+typedef struct {
+    Canvas* canvas;
+    uint8_t* buffer;
+    bool bound; // layout recognized
+    Raster raster;
+} RasterBinding;
+
+const size_t RASTER_BINDINGS = 2;
+RasterBinding bindings[RASTER_BINDINGS];
+size_t next_binding = 0;
+
+const int32_t RASTER_BYTES = LCD_WIDTH * LCD_HEIGHT / 8;
+
+uint8_t reverse_bits(uint8_t b) {
+    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+    return (b & 0xAA) >> 1 | (b & 0x55) << 1;
+}
+
+// Pixels lo to hi (0-7, left to right) of a byte
+uint8_t byte_mask(const Raster* r, int32_t lo, int32_t hi) {
+    uint8_t mask = (0xFF << lo) & (0xFF >> (7 - hi));
+    return r->msb_left ? reverse_bits(mask) : mask;
+}
+
+int32_t byte_index(const Raster* r, int32_t x, int32_t y) {
+    return r->origin + y * r->row_stride + (x >> 3) * r->col_stride;
+}
+
+uint8_t bit_of(const Raster* r, int32_t x) {
+    return r->msb_left ? 0x80 >> (x & 7) : 1 << (x & 7);
+}
+
+// Toggles (x, y) with canvas_draw_dot() and reports the one bit that changed
+bool probe(Canvas* canvas, uint8_t* before, int32_t x, int32_t y, int32_t* index, uint8_t* bit) {
+    uint8_t* buffer = canvas_get_buffer(canvas);
+    size_t size = canvas_get_buffer_size(canvas);
+    memcpy(before, buffer, size);
+    canvas_draw_dot(canvas, x, y);
+    int32_t changes = 0;
+    for(size_t i = 0; i < size; i++) {
+        if(buffer[i] != before[i]) {
+            *index = i;
+            *bit = buffer[i] ^ before[i];
+            changes++;
+        }
+    }
+    canvas_draw_dot(canvas, x, y);
+    return changes == 1 && (*bit & (*bit - 1)) == 0;
+}
+
+bool bind(Canvas* canvas, Raster& raster) {
+    size_t size = canvas_get_buffer_size(canvas);
+    if(!canvas_get_buffer(canvas) || size < (size_t)RASTER_BYTES) {
+        return false;
+    }
+    uint8_t* before = (uint8_t*)malloc(size);
+    if(!before) {
+        return false;
+    }
+    canvas_set_color(canvas, ColorXOR);
+
+    int32_t i00, i10, i80, i01;
+    uint8_t b00, b10, b80, b01;
+    bool ok = probe(canvas, before, 0, 0, &i00, &b00) && probe(canvas, before, 1, 0, &i10, &b10) &&
+              probe(canvas, before, 8, 0, &i80, &b80) && probe(canvas, before, 0, 1, &i01, &b01);
+    // pixels 0 and 1 share a byte, and 8 and row 1 start their own bytes
+    ok = ok && i10 == i00 && (b00 == 0x01 || b00 == 0x80) && b80 == b00 && b01 == b00;
+    if(ok) {
+        raster.buffer = canvas_get_buffer(canvas);
+        raster.origin = i00;
+        raster.row_stride = i01 - i00;
+        raster.col_stride = i80 - i00;
+        raster.msb_left = b00 == 0x80;
+        ok = b10 == bit_of(&raster, 1);
+    }
+    // check the model against pixels spread over the screen
+    const int32_t checks[][2] = {
+        {LCD_WIDTH - 1, LCD_HEIGHT - 1}, {LCD_WIDTH - 1, 0}, {0, LCD_HEIGHT - 1}, {37, 90}, {13, 21}};
+    for(size_t c = 0; ok && c < COUNT_OF(checks); c++) {
+        int32_t index;
+        uint8_t bit;
+        int32_t x = checks[c][0];
+        int32_t y = checks[c][1];
+        ok = probe(canvas, before, x, y, &index, &bit) && index == byte_index(&raster, x, y) &&
+             bit == bit_of(&raster, x);
+    }
+
+    canvas_set_color(canvas, ColorBlack);
+    free(before);
+    if(ok) {
+        FURI_LOG_I(
+            TAG,
+            "Raster: rows %ld bytes apart, columns %ld, %s bit first",
+            (long)raster.row_stride,
+            (long)raster.col_stride,
+            raster.msb_left ? "high" : "low");
+    } else {
+        FURI_LOG_W(TAG, "Raster: unknown framebuffer layout, drawing through the canvas");
+    }
+    return ok;
+}
+
+// Bresenham as canvas_draw_line() does it, handing over each row's run of
+// pixels: a single pixel for steep lines, longer runs for shallow ones.
+template <typename Run>
+void bresenham(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Run run) {
+    int32_t dx = abs(x2 - x1);
+    int32_t dy = abs(y2 - y1);
+    bool swapxy = dy > dx;
+    if(swapxy) {
+        int32_t t = dx;
+        dx = dy;
+        dy = t;
+        t = x1;
+        x1 = y1;
+        y1 = t;
+        t = x2;
+        x2 = y2;
+        y2 = t;
+    }
+    if(x1 > x2) {
+        int32_t t = x1;
+        x1 = x2;
+        x2 = t;
+        t = y1;
+        y1 = y2;
+        y2 = t;
+    }
+    int32_t err = dx >> 1;
+    int32_t ystep = y2 > y1 ? 1 : -1;
+    int32_t y = y1;
+    int32_t start = x1;
+    for(int32_t x = x1; x <= x2; x++) {
+        if(swapxy) {
+            run(y, y, x);
+        }
+        err -= dy;
+        if(err < 0) {
+            if(!swapxy) {
+                run(start, x, y);
+                start = x + 1;
+            }
+            y += ystep;
+            err += dx;
+        }
+    }
+    if(!swapxy && start <= x2) {
+        run(start, x2, y);
+    }
+}
+}
+
+Raster* raster_get(Canvas* canvas) {
+#ifdef RASTER_DISABLED
+    return nullptr;
+#endif
+    uint8_t* buffer = canvas_get_buffer(canvas);
+    for(RasterBinding& b : bindings) {
+        if(b.canvas == canvas && b.buffer == buffer) {
+            return b.bound ? &b.raster : nullptr;
+        }
+    }
+    RasterBinding& b = bindings[next_binding];
+    next_binding = (next_binding + 1) % RASTER_BINDINGS;
+    b.canvas = canvas;
+    b.buffer = buffer;
+    b.bound = bind(canvas, b.raster);
+    return b.bound ? &b.raster : nullptr;
+}
+
+void raster_dot(Raster* r, int32_t x, int32_t y) {
+    if(x < 0 || x >= LCD_WIDTH || y < 0 || y >= LCD_HEIGHT) {
+        return;
+    }
+    r->buffer[byte_index(r, x, y)] |= bit_of(r, x);
+}
+
+void raster_hline(Raster* r, int32_t x0, int32_t x1, int32_t y) {
+    if(x0 > x1) {
+        int32_t t = x0;
+        x0 = x1;
+        x1 = t;
+    }
+    if(y < 0 || y >= LCD_HEIGHT || x1 < 0 || x0 >= LCD_WIDTH) {
+        return;
+    }
+    x0 = x0 < 0 ? 0 : x0;
+    x1 = x1 >= LCD_WIDTH ? LCD_WIDTH - 1 : x1;
+    uint8_t* p = r->buffer + byte_index(r, x0, y);
+    int32_t last = x1 >> 3;
+    for(int32_t c = x0 >> 3; c <= last; c++) {
+        *p |= byte_mask(r, c == x0 >> 3 ? x0 & 7 : 0, c == last ? x1 & 7 : 7);
+        p += r->col_stride;
+    }
+}
+
+void raster_line(Raster* r, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    bresenham(x1, y1, x2, y2, [r](int32_t xa, int32_t xb, int32_t y) {
+        if(xa == xb) {
+            raster_dot(r, xa, y);
+        } else {
+            raster_hline(r, xa, xb, y);
+        }
+    });
+}
+
+// canvas_draw_disc() fills vertical lines out from each midpoint-circle step;
+// the disc is symmetric about its diagonal, so the same steps give the rows.
+void raster_disc(Raster* r, int32_t x0, int32_t y0, int32_t radius) {
+    if(x0 + radius < 0 || x0 - radius >= LCD_WIDTH || y0 + radius < 0 ||
+       y0 - radius >= LCD_HEIGHT) {
+        return;
+    }
+    int32_t f = 1 - radius;
+    int32_t ddf_x = 1;
+    int32_t ddf_y = -2 * radius;
+    int32_t x = 0;
+    int32_t y = radius;
+    for(;;) {
+        // rows +-x are new every step, rows +-y only when y is about to move
+        raster_hline(r, x0 - y, x0 + y, y0 + x);
+        raster_hline(r, x0 - y, x0 + y, y0 - x);
+        bool more = x < y;
+        if(!more || f >= 0) {
+            raster_hline(r, x0 - x, x0 + x, y0 + y);
+            raster_hline(r, x0 - x, x0 + x, y0 - y);
+        }
+        if(!more) {
+            break;
+        }
+        if(f >= 0) {
+            y--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+        x++;
+        ddf_x += 2;
+        f += ddf_x;
+    }
+}
+
+void raster_circle(Raster* r, int32_t x0, int32_t y0, int32_t radius) {
+    if(x0 + radius < 0 || x0 - radius >= LCD_WIDTH || y0 + radius < 0 ||
+       y0 - radius >= LCD_HEIGHT) {
+        return;
+    }
+    int32_t f = 1 - radius;
+    int32_t ddf_x = 1;
+    int32_t ddf_y = -2 * radius;
+    int32_t x = 0;
+    int32_t y = radius;
+    for(;;) {
+        raster_dot(r, x0 + x, y0 - y);
+        raster_dot(r, x0 + y, y0 - x);
+        raster_dot(r, x0 - x, y0 - y);
+        raster_dot(r, x0 - y, y0 - x);
+        raster_dot(r, x0 - x, y0 + y);
+        raster_dot(r, x0 - y, y0 + x);
+        raster_dot(r, x0 + x, y0 + y);
+        raster_dot(r, x0 + y, y0 + x);
+        if(x >= y) {
+            break;
+        }
+        if(f >= 0) {
+            y--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+        x++;
+        ddf_x += 2;
+        f += ddf_x;
+    }
+}
+
+void raster_rows_clear(RasterRows* rows) {
+    memset(rows->rows, 0, sizeof(rows->rows));
+    rows->y_min = LCD_HEIGHT;
+    rows->y_max = -1;
+}
+
+void raster_rows_dot(RasterRows* rows, int32_t x, int32_t y) {
+    if(x < 0 || x >= LCD_WIDTH || y < 0 || y >= LCD_HEIGHT) {
+        return;
+    }
+    rows->rows[y] |= (uint64_t)1 << x;
+    rows->y_min = y < rows->y_min ? y : rows->y_min;
+    rows->y_max = y > rows->y_max ? y : rows->y_max;
+}
+
+void raster_rows_box(RasterRows* rows, int32_t x, int32_t y, size_t width, size_t height) {
+    int64_t x1 = (int64_t)x + (width < INT32_MAX ? width : INT32_MAX);
+    int64_t y1 = (int64_t)y + (height < INT32_MAX ? height : INT32_MAX);
+    x1 = x1 < LCD_WIDTH ? x1 : LCD_WIDTH;
+    y1 = y1 < LCD_HEIGHT ? y1 : LCD_HEIGHT;
+    for(int64_t j = y < 0 ? 0 : y; j < y1; j++) {
+        for(int64_t i = x < 0 ? 0 : x; i < x1; i++) {
+            raster_rows_dot(rows, i, j);
+        }
+    }
+}
+
+void raster_rows_line(RasterRows* rows, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    bresenham(x1, y1, x2, y2, [rows](int32_t xa, int32_t xb, int32_t y) {
+        for(int32_t x = xa; x <= xb; x++) {
+            raster_rows_dot(rows, x, y);
+        }
+    });
+}
+
+void raster_rows_flush(RasterRows* rows, Canvas* canvas) {
+    Raster* r = raster_get(canvas);
+    for(int32_t y = rows->y_min; y <= rows->y_max; y++) {
+        uint64_t bits = rows->rows[y];
+        if(r) {
+            uint8_t* p = r->buffer + byte_index(r, 0, y);
+            for(int32_t c = 0; bits; c++, bits >>= 8) {
+                uint8_t byte = bits & 0xFF;
+                if(byte) {
+                    p[c * r->col_stride] |= r->msb_left ? reverse_bits(byte) : byte;
+                }
+            }
+            continue;
+        }
+        // one canvas call per run of pixels
+        for(int32_t x = 0; bits; x++, bits >>= 1) {
+            if(bits & 1) {
+                int32_t start = x;
+                while(bits & 2) {
+                    bits >>= 1;
+                    x++;
+                }
+                canvas_draw_line(canvas, start, y, x, y);
+            }
+        }
+    }
+}
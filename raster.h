@@ -0,0 +1,55 @@
+#pragma once
+#include <gui/gui.h>
+#include <stdint.h>
+
+#include "pinball0.h"
+
+// Drawing straight into the canvas framebuffer, a byte (8 pixels) at a time,
+// instead of a canvas_draw_dot() call per pixel. Pixels are always set (black).
+//
+// The framebuffer layout isn't part of the Canvas API, so raster_get() works it
+// out by toggling a few probe pixels and seeing which bits change. Any layout
+// that stores 8 horizontally adjacent pixels per byte is recognized; this
+// includes the Flipper's portrait screen (each byte holds 8 pixels of a row,
+// rows 1 byte apart, byte columns 128 bytes apart) and the host canvas. If the
+// layout isn't recognized, raster_get() returns nullptr and callers should
+// fall back to the canvas_* functions.
+//
+// Define RASTER_DISABLED to always fall back.
+// #define RASTER_DISABLED
+
+typedef struct {
+    uint8_t* buffer;
+    int32_t origin; // byte holding pixels 0-7 of row 0
+    int32_t row_stride; // bytes from one row to the next
+    int32_t col_stride; // bytes from one 8-pixel column to the next
+    bool msb_left; // bit 7 is the leftmost pixel of each byte
+} Raster;
+
+// The raster for 'canvas', probing it the first time. The canvas color must
+// be black, as it is when the draw callback starts.
+Raster* raster_get(Canvas* canvas);
+
+void raster_dot(Raster* r, int32_t x, int32_t y);
+// x0 to x1 inclusive, in either order
+void raster_hline(Raster* r, int32_t x0, int32_t x1, int32_t y);
+// Same pixels as canvas_draw_line(), canvas_draw_disc() and canvas_draw_circle()
+void raster_line(Raster* r, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+void raster_disc(Raster* r, int32_t x0, int32_t y0, int32_t radius);
+void raster_circle(Raster* r, int32_t x0, int32_t y0, int32_t radius);
+
+// A one-word-per-row pixel mask for shapes drawn as many overlapping strokes,
+// like thick lines: every pixel is ORed in once, however often it's plotted,
+// and the rows are written out together by raster_rows_flush().
+typedef struct {
+    uint64_t rows[LCD_HEIGHT];
+    int32_t y_min, y_max; // rows touched, y_min > y_max when empty
+} RasterRows;
+
+void raster_rows_clear(RasterRows* rows);
+void raster_rows_dot(RasterRows* rows, int32_t x, int32_t y);
+// Same pixels as canvas_draw_box() and canvas_draw_line()
+void raster_rows_box(RasterRows* rows, int32_t x, int32_t y, size_t width, size_t height);
+void raster_rows_line(RasterRows* rows, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+// Draws the collected pixels, through the raster if there is one
+void raster_rows_flush(RasterRows* rows, Canvas* canvas);
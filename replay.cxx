@@ -0,0 +1,286 @@
+#include <furi.h>
+#include <storage/storage.h>
+
+#include "pinball0.h"
+#include "table.h"
+#include "replay.h"
+
+namespace {
+const uint32_t fnv_basis = 2166136261u;
+
+void fnv(uint32_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for(size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+}
+
+// Table units in 1/256ths, the same in float and fixed-point builds
+void fnv_scalar(uint32_t& hash, Scalar s) {
+    int32_t v = (int32_t)((float)s * 256);
+    fnv(hash, &v, sizeof(v));
+}
+
+void close_file(Replay* r) {
+    if(r->file) {
+        storage_file_close(r->file);
+        storage_file_free(r->file);
+        r->file = nullptr;
+    }
+}
+
+// Writes all but the last run, which later frames may still extend
+bool flush_runs(Replay* r, bool all) {
+    uint16_t n = all ? r->count : r->count - 1;
+    size_t bytes = n * sizeof(ReplayRun);
+    if(n && storage_file_write(r->file, r->runs, bytes) != bytes) {
+        return false;
+    }
+    if(!all) {
+        r->runs[0] = r->runs[r->count - 1];
+    }
+    r->count -= n;
+    return true;
+}
+
+void record_frame(Replay* r, uint8_t input, uint8_t steps) {
+    if(r->count) {
+        ReplayRun& last = r->runs[r->count - 1];
+        if(last.input == input && last.steps == steps && last.frames < UINT16_MAX) {
+            last.frames++;
+            return;
+        }
+    }
+    if(r->count == REPLAY_BUFFER_RUNS && !flush_runs(r, false)) {
+        FURI_LOG_E(TAG, "Replay: write failed, recording stopped");
+        r->recording = false;
+        close_file(r);
+        return;
+    }
+    r->runs[r->count++] = {input, steps, 1};
+}
+
+// Keeps what the frame left behind, to see what the input changes next frame
+void note_state(Replay* r, const PinballApp* pb) {
+    r->released = pb->table->balls_released;
+    r->tilted = pb->game_mode == GM_Tilted;
+    if(!pb->table->balls.empty()) {
+        r->ball_p = pb->table->balls[0].p;
+    }
+}
+
+// What the frame's input did, as a ReplayInput mask
+uint8_t read_input(PinballApp* pb) {
+    Replay* r = &pb->replay;
+    uint8_t input = 0;
+    for(int k = 0; k < 4; k++) {
+        input |= pb->keys[k] ? 1 << k : 0;
+    }
+    if(pb->table->balls_released && !r->released) {
+        input |= ReplayInputRelease;
+    }
+    if(pb->game_mode == GM_Tilted && !r->tilted) {
+        input |= ReplayInputTilt;
+    }
+    return input;
+}
+
+// Reads the next run with frames left into r->runs[r->next]
+bool next_run(Replay* r) {
+    while(r->next == r->count || r->runs[r->next].frames == 0) {
+        if(r->next < r->count) {
+            r->next++;
+            continue;
+        }
+        size_t bytes = storage_file_read(r->file, r->runs, sizeof(r->runs));
+        r->count = bytes / sizeof(ReplayRun);
+        r->next = 0;
+        if(r->count == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+ReplayPhysics replay_physics() {
+#ifdef PINBALL_FIXED_POINT
+    return ReplayPhysicsFixed;
+#else
+    return ReplayPhysicsFloat;
+#endif
+}
+
+uint32_t replay_start_hash(const Table* table) {
+    uint32_t hash = fnv_basis;
+    for(const auto& b : table->balls_initial) {
+        fnv_scalar(hash, b.p.x);
+        fnv_scalar(hash, b.p.y);
+        fnv_scalar(hash, b.r);
+    }
+    uint32_t counts[2] = {(uint32_t)table->objects.size(), (uint32_t)table->flippers.size()};
+    fnv(hash, counts, sizeof(counts));
+    return hash;
+}
+
+void replay_hash_balls(const Table* table, uint32_t& hash) {
+    for(const auto& b : table->balls) {
+        fnv(hash, &b.p, sizeof(b.p));
+    }
+}
+
+void replay_apply_input(PinballApp* pb, uint8_t input) {
+    Table* table = pb->table;
+    for(int k = 0; k < 4; k++) {
+        pb->keys[k] = input & (1 << k);
+    }
+    for(auto& f : table->flippers) {
+        f.powered = pb->keys[f.side == Flipper::LEFT ? InputKeyLeft : InputKeyRight];
+    }
+    if(input & ReplayInputRelease) {
+        table->balls_released = true;
+    }
+    if(input & ReplayInputTilt) {
+        pb->game_mode = GM_Tilted;
+        table->tilt();
+    }
+}
+
+bool replay_record(PinballApp* pb, const char* path, const char* table_name) {
+    Replay* r = &pb->replay;
+    replay_end(pb);
+
+    memset(&r->header, 0, sizeof(r->header));
+    memcpy(r->header.magic, REPLAY_MAGIC, sizeof(r->header.magic));
+    r->header.version = REPLAY_VERSION;
+    strncpy(r->header.table, table_name, REPLAY_TABLE_NAME_MAX - 1);
+    r->header.start_hash = replay_start_hash(pb->table);
+
+    r->file = storage_file_alloc(pb->storage);
+    // the header is written again, complete, by replay_end()
+    if(!storage_file_open(r->file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS) ||
+       storage_file_write(r->file, &r->header, sizeof(r->header)) != sizeof(r->header)) {
+        FURI_LOG_E(TAG, "Replay: cannot write %s", path);
+        close_file(r);
+        return false;
+    }
+    r->recording = true;
+    r->count = 0;
+    r->frames = 0;
+    r->hash = fnv_basis;
+    note_state(r, pb);
+    FURI_LOG_I(TAG, "Recording %s to %s", table_name, path);
+    return true;
+}
+
+bool replay_play(PinballApp* pb, const char* path) {
+    Replay* r = &pb->replay;
+    replay_end(pb);
+
+    r->file = storage_file_alloc(pb->storage);
+    bool ok = storage_file_open(r->file, path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_read(r->file, &r->header, sizeof(r->header)) == sizeof(r->header) &&
+              !memcmp(r->header.magic, REPLAY_MAGIC, sizeof(r->header.magic)) &&
+              r->header.version == REPLAY_VERSION;
+    if(!ok) {
+        FURI_LOG_E(TAG, "Replay: cannot read %s", path);
+        snprintf(pb->text, 256, "No replay\nto play!");
+        close_file(r);
+        return false;
+    }
+    r->header.table[REPLAY_TABLE_NAME_MAX - 1] = '\0';
+
+    size_t index = 0;
+    auto& items = pb->table_list.menu_items;
+    while(index < items.size() && strcmp(furi_string_get_cstr(items[index].name), r->header.table)) {
+        index++;
+    }
+    if(index == items.size()) {
+        FURI_LOG_E(TAG, "Replay: no table named %s", r->header.table);
+        snprintf(pb->text, 256, "Replay\ntable not\nfound!");
+        close_file(r);
+        return false;
+    }
+    if(!table_load_table(pb, index + TABLE_INDEX_OFFSET)) {
+        close_file(r);
+        return false;
+    }
+    if(replay_start_hash(pb->table) != r->header.start_hash) {
+        FURI_LOG_E(TAG, "Replay: table %s has changed", r->header.table);
+        snprintf(pb->text, 256, "Replay\ntable has\nchanged!");
+        close_file(r);
+        return false;
+    }
+    pb->game_mode = GM_Playing;
+    r->playing = true;
+    r->count = 0;
+    r->next = 0;
+    r->frames = 0;
+    r->hash = fnv_basis;
+    FURI_LOG_I(TAG, "Replaying %s, %lu frames", r->header.table, r->header.frames);
+    return true;
+}
+
+void replay_frame(PinballApp* pb, uint32_t* steps) {
+    Replay* r = &pb->replay;
+    if(r->recording) {
+        // a ball moved by hand in debug mode can't be replayed
+        if(!pb->table->balls.empty() && !(pb->table->balls[0].p == r->ball_p)) {
+            FURI_LOG_W(TAG, "Replay: ball moved by hand, recording stopped");
+            replay_end(pb);
+            return;
+        }
+        r->input = read_input(pb);
+    } else if(r->playing) {
+        if(!next_run(r)) {
+            replay_end(pb);
+            return;
+        }
+        ReplayRun& run = r->runs[r->next];
+        run.frames--;
+        r->input = run.input;
+        *steps = run.steps;
+        replay_apply_input(pb, run.input);
+    }
+}
+
+void replay_frame_done(PinballApp* pb, uint32_t steps) {
+    Replay* r = &pb->replay;
+    if(!r->recording && !r->playing) {
+        return;
+    }
+    replay_hash_balls(pb->table, r->hash);
+    r->frames++;
+    if(r->recording) {
+        record_frame(r, r->input, steps);
+        note_state(r, pb);
+    }
+}
+
+void replay_end(PinballApp* pb) {
+    Replay* r = &pb->replay;
+    if(r->recording) {
+        r->header.frames = r->frames;
+        r->header.hash[replay_physics()] = r->hash;
+        if(flush_runs(r, true) && storage_file_seek(r->file, 0, true) &&
+           storage_file_write(r->file, &r->header, sizeof(r->header)) == sizeof(r->header)) {
+            FURI_LOG_I(TAG, "Recorded %lu frames, hash %08lx", r->frames, r->hash);
+        } else {
+            FURI_LOG_E(TAG, "Replay: write failed, recording lost");
+        }
+    } else if(r->playing) {
+        uint32_t expected = r->header.hash[replay_physics()];
+        if(r->frames != r->header.frames) {
+            FURI_LOG_I(TAG, "Replay stopped at frame %lu of %lu", r->frames, r->header.frames);
+        } else if(!expected) {
+            FURI_LOG_I(TAG, "Replay done, hash %08lx (none recorded)", r->hash);
+        } else if(r->hash == expected) {
+            FURI_LOG_I(TAG, "Replay done, hash %08lx matches", r->hash);
+        } else {
+            FURI_LOG_E(TAG, "Replay differs: hash %08lx, recorded %08lx", r->hash, expected);
+        }
+    }
+    r->recording = false;
+    r->playing = false;
+    close_file(r);
+}
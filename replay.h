@@ -0,0 +1,102 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <storage/storage.h>
+#include "vec2.h"
+
+// Game recordings (.pbr)
+//
+// A ReplayHeader, then ReplayRuns to the end of the file. Every frame is the
+// input the physics saw, as a ReplayInput mask, and the number of steps solve()
+// took; a run is a number of identical frames in a row. Nothing in the physics
+// is random, so the table, its starting balls and the frames are the whole game.
+//
+// Like .pb0 files, all values are little-endian.
+
+#define REPLAY_MAGIC          "PB0R"
+#define REPLAY_VERSION        1
+#define REPLAY_TABLE_NAME_MAX 32
+#define REPLAY_BUFFER_RUNS    32 // runs written or read at a time
+
+// Debug mode records every game here, and replays it from the table list
+#define REPLAY_PATH          APP_DATA_PATH("last.pbr")
+#define REPLAY_MENU_FILENAME "98_Replay"
+
+struct PinballApp;
+class Table;
+
+typedef enum {
+    // bits 0-3 are keys[InputKeyUp .. InputKeyLeft]
+    ReplayInputKeys = 0x0f,
+    ReplayInputRelease = 1 << 4, // the ball was released
+    ReplayInputTilt = 1 << 5, // the table tilted
+} ReplayInput;
+
+// The physics builds don't produce the same trajectories, so each gets a hash
+typedef enum {
+    ReplayPhysicsFloat,
+    ReplayPhysicsFixed,
+    ReplayPhysicsCount,
+} ReplayPhysics;
+
+typedef struct {
+    char magic[4]; // REPLAY_MAGIC, not NUL terminated
+    uint16_t version;
+    uint16_t reserved;
+    char table[REPLAY_TABLE_NAME_MAX]; // as named in the table list
+    uint32_t start_hash; // of the table's starting balls, to catch a changed table
+    uint32_t frames;
+    // FNV-1a of every ball position on every frame, as the benchmark hashes
+    // them; 0 for a build that hasn't played the recording
+    uint32_t hash[ReplayPhysicsCount];
+} ReplayHeader;
+
+typedef struct {
+    uint8_t input; // ReplayInput
+    uint8_t steps;
+    uint16_t frames;
+} ReplayRun;
+
+typedef struct {
+    bool recording;
+    bool playing;
+    File* file;
+    ReplayHeader header;
+    ReplayRun runs[REPLAY_BUFFER_RUNS]; // waiting to be written, or read ahead
+    uint16_t count; // runs in the buffer
+    uint16_t next; // playing: the run being played
+    uint32_t frames; // frames recorded or played so far
+    uint32_t hash;
+    uint8_t input; // this frame's input
+
+    // recording: what the last frame left behind, to tell what changed since
+    bool released;
+    bool tilted;
+    Vec2 ball_p;
+} Replay;
+
+// This build's entry in ReplayHeader::hash
+ReplayPhysics replay_physics();
+// Hash of the table's starting balls
+uint32_t replay_start_hash(const Table* table);
+// Adds every ball position to an FNV-1a hash
+void replay_hash_balls(const Table* table, uint32_t& hash);
+// Does what the input handler did to produce 'input', a ReplayInput mask
+void replay_apply_input(PinballApp* pb, uint8_t input);
+
+// Starts recording the current table, which is listed as 'table_name', to
+// 'path'. Frames are recorded until replay_end().
+bool replay_record(PinballApp* pb, const char* path, const char* table_name);
+// Loads the recording's table and starts playing it. On failure pb->text says why.
+bool replay_play(PinballApp* pb, const char* path);
+
+// Call once per frame before solve(). While playing, this sets the keys,
+// flippers and game state of the next recorded frame and replaces 'steps' with
+// its steps; at the end of the recording it stops playing and leaves them be.
+void replay_frame(PinballApp* pb, uint32_t* steps);
+// Call once per frame after solve(), with the steps it took
+void replay_frame_done(PinballApp* pb, uint32_t steps);
+
+// Stops recording or playing. A recording is finished and closed; the end of
+// a playback is checked against the recorded hash. Safe to call when idle.
+void replay_end(PinballApp* pb);
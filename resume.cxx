@@ -0,0 +1,239 @@
+#include <furi.h>
+#include <storage/storage.h>
+#include <vector>
+
+#include "pinball0.h"
+#include "table.h"
+#include "table_format.h"
+#include "load_profile.h"
+#include "replay.h"
+#include "resume.h"
+
+namespace {
+const uint32_t fnv_basis = 2166136261u;
+
+void fnv(uint32_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for(size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+}
+
+// Size and FNV-1a hash of the file at 'path'
+bool hash_file(Storage* storage, const char* path, uint32_t* size, uint32_t* hash) {
+    File* file = storage_file_alloc(storage);
+    bool ok = storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING);
+    *size = 0;
+    *hash = fnv_basis;
+    uint8_t buf[128];
+    size_t n;
+    while(ok && (n = storage_file_read(file, buf, sizeof(buf))) > 0) {
+        fnv(*hash, buf, n);
+        *size += n;
+    }
+    storage_file_free(file);
+    return ok;
+}
+
+size_t file_read(void* ctx, char* buf, size_t size) {
+    return storage_file_read((File*)ctx, buf, size);
+}
+
+// Writes the records of a JSON table to a file as it's parsed, .pb0 style
+typedef struct {
+    File* file;
+    uint16_t count;
+    uint32_t size; // bytes written
+    bool ok;
+} RecordWriter;
+
+bool write_record(void* ctx, uint8_t type, const Pb0Record& record) {
+    RecordWriter* w = (RecordWriter*)ctx;
+    Pb0RecordHeader rh = {type, (uint8_t)pb0_record_size(type)};
+    w->ok = w->ok && w->count < UINT16_MAX &&
+            storage_file_write(w->file, &rh, sizeof(rh)) == sizeof(rh) &&
+            storage_file_write(w->file, &record, rh.size) == rh.size;
+    w->count++;
+    w->size += sizeof(rh) + rh.size;
+    return w->ok;
+}
+
+// Writes the table file at 'path' to 'out', compiled, and its size to 'size'
+bool write_table(Storage* storage, const char* path, File* out, uint32_t* size) {
+    File* in = storage_file_alloc(storage);
+    bool ok = storage_file_open(in, path, FSAM_READ, FSOM_OPEN_EXISTING);
+    const char* ext = strrchr(path, '.');
+    if(ext && !strcmp(ext, ".pb0")) {
+        // already compiled
+        *size = 0;
+        uint8_t buf[128];
+        size_t n;
+        while(ok && (n = storage_file_read(in, buf, sizeof(buf))) > 0) {
+            ok = storage_file_write(out, buf, n) == n;
+            *size += n;
+        }
+    } else {
+        // the header goes in once the records are counted
+        uint32_t start = storage_file_tell(out);
+        Pb0Header header;
+        pb0_header_init(&header);
+        RecordWriter w = {out, 0, sizeof(header), true};
+        ok = ok && storage_file_write(out, &header, sizeof(header)) == sizeof(header) &&
+             table_json_read(file_read, in, &header, write_record, &w) && w.ok;
+        header.record_count = w.count;
+        ok = ok && storage_file_seek(out, start, true) &&
+             storage_file_write(out, &header, sizeof(header)) == sizeof(header) &&
+             storage_file_seek(out, start + w.size, true);
+        *size = w.size;
+    }
+    storage_file_free(in);
+    return ok;
+}
+}
+
+void resume_begin(PinballApp* pb, const char* path, const char* name) {
+    Resume* r = &pb->resume;
+    r->active = true;
+    strncpy(r->table, path, RESUME_PATH_MAX - 1);
+    r->table[RESUME_PATH_MAX - 1] = '\0';
+    strncpy(r->name, name, RESUME_NAME_MAX - 1);
+    r->name[RESUME_NAME_MAX - 1] = '\0';
+}
+
+void resume_stop(PinballApp* pb) {
+    // a save, if any, is another game's: this one's was used up continuing it
+    pb->resume.active = false;
+}
+
+bool resume_save(PinballApp* pb) {
+    Resume* r = &pb->resume;
+    const Table* table = pb->table;
+    // a game that hasn't got going yet isn't worth coming back to
+    bool in_progress = r->active &&
+                       (pb->game_mode == GM_Playing || pb->game_mode == GM_Tilted) &&
+                       !table->game_over && (table->balls_released || table->score.value);
+    r->active = false;
+    if(!in_progress) {
+        return false;
+    }
+
+    ResumeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RESUME_MAGIC, sizeof(header.magic));
+    header.version = RESUME_VERSION;
+    header.physics = replay_physics();
+    header.tilted = pb->game_mode == GM_Tilted;
+    memcpy(header.table, r->table, sizeof(header.table));
+    memcpy(header.name, r->name, sizeof(header.name));
+
+    std::vector<uint8_t> snapshot(table->snapshot_size());
+    table->save_snapshot(snapshot.data());
+    header.snapshot_size = snapshot.size();
+
+    // the header is written again, complete, once the table's size is known
+    File* file = storage_file_alloc(pb->storage);
+    bool ok = hash_file(pb->storage, r->table, &header.table_size, &header.table_hash) &&
+              storage_file_open(file, RESUME_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+              storage_file_write(file, &header, sizeof(header)) == sizeof(header) &&
+              write_table(pb->storage, r->table, file, &header.records_size) &&
+              storage_file_write(file, snapshot.data(), snapshot.size()) == snapshot.size() &&
+              storage_file_seek(file, 0, true) &&
+              storage_file_write(file, &header, sizeof(header)) == sizeof(header);
+    storage_file_free(file);
+    if(ok) {
+        FURI_LOG_I(
+            TAG,
+            "Saved %s game: %lu bytes of table, %lu of state",
+            r->name,
+            header.records_size,
+            header.snapshot_size);
+    } else {
+        FURI_LOG_E(TAG, "Resume: cannot save %s game", r->name);
+        storage_common_remove(pb->storage, RESUME_PATH);
+    }
+    resume_list_update(pb);
+    return ok;
+}
+
+bool resume_continue(PinballApp* pb) {
+    ResumeHeader header;
+    File* file = storage_file_alloc(pb->storage);
+    bool ok = false;
+    do {
+        if(!storage_file_open(file, RESUME_PATH, FSAM_READ, FSOM_OPEN_EXISTING) ||
+           storage_file_read(file, &header, sizeof(header)) != sizeof(header) ||
+           memcmp(header.magic, RESUME_MAGIC, sizeof(header.magic)) != 0 ||
+           header.version != RESUME_VERSION) {
+            FURI_LOG_E(TAG, "Resume: cannot read %s", RESUME_PATH);
+            snprintf(pb->text, 256, "Saved game\nis damaged!");
+            break;
+        }
+        header.table[RESUME_PATH_MAX - 1] = '\0';
+        header.name[RESUME_NAME_MAX - 1] = '\0';
+        if(header.physics != replay_physics()) {
+            FURI_LOG_E(TAG, "Resume: saved by the other physics build");
+            snprintf(pb->text, 256, "Saved game\nis from\nanother build!");
+            break;
+        }
+        // only read, not parsed, to see that it's the table the game was saved on
+        uint32_t size, hash;
+        if(!hash_file(pb->storage, header.table, &size, &hash) || size != header.table_size ||
+           hash != header.table_hash) {
+            FURI_LOG_E(TAG, "Resume: table %s has changed", header.table);
+            snprintf(pb->text, 256, "Saved game's\ntable has\nchanged!");
+            break;
+        }
+
+        delete pb->table;
+        load_profile_begin(&pb->load_profile);
+        pb->table = table_read_pb0(pb, file);
+        load_profile_end();
+        if(!pb->table) {
+            break;
+        }
+        load_profile_log(&pb->load_profile, header.name);
+
+        std::vector<uint8_t> snapshot(header.snapshot_size);
+        if(!storage_file_seek(file, sizeof(header) + header.records_size, true) ||
+           storage_file_read(file, snapshot.data(), snapshot.size()) != snapshot.size() ||
+           !pb->table->restore_snapshot(snapshot.data(), snapshot.size())) {
+            FURI_LOG_E(TAG, "Resume: state doesn't fit table %s", header.table);
+            snprintf(pb->text, 256, "Saved game\nis damaged!");
+            break;
+        }
+        ok = true;
+    } while(false);
+    storage_file_free(file);
+
+    // whether it worked or never will, the save is used up
+    storage_common_remove(pb->storage, RESUME_PATH);
+    resume_list_update(pb);
+    if(!ok) {
+        return false;
+    }
+    pb->game_mode = header.tilted ? GM_Tilted : GM_Playing;
+    resume_begin(pb, header.table, header.name);
+    FURI_LOG_I(TAG, "Continuing %s game", header.name);
+    return true;
+}
+
+void resume_list_update(PinballApp* pb) {
+    auto& items = pb->table_list.menu_items;
+    bool listed = !items.empty() &&
+                  !strcmp(furi_string_get_cstr(items[0].filename), RESUME_MENU_FILENAME);
+    bool saved = storage_common_stat(pb->storage, RESUME_PATH, NULL) == FSE_OK;
+    if(saved && !listed) {
+        TableList::TableMenuItem item;
+        item.filename = furi_string_alloc_set_str(RESUME_MENU_FILENAME);
+        item.name = furi_string_alloc_set_str("CONTINUE");
+        items.insert(items.begin(), item);
+        pb->table_list.selected = 0;
+    } else if(!saved && listed) {
+        furi_string_free(items[0].filename);
+        furi_string_free(items[0].name);
+        items.erase(items.begin());
+        if(pb->table_list.selected > 0) {
+            pb->table_list.selected--;
+        }
+    }
+}
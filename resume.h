@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <storage/storage.h>
+
+// Saved games (.pbs)
+//
+// A ResumeHeader, the table compiled to .pb0 (a Pb0Header and its records),
+// then the table's snapshot (Table::save_snapshot()). The table comes along
+// so that continuing needn't parse it again; the table file it came from is
+// only read to check, by its hash, that it hasn't changed since.
+//
+// Like .pb0 files, all values are little-endian.
+
+#define RESUME_MAGIC    "PB0S"
+#define RESUME_VERSION  1
+#define RESUME_PATH_MAX 128
+#define RESUME_NAME_MAX 32
+
+// A game left through Back is saved here, and CONTINUE at the top of the table
+// list picks it up again
+#define RESUME_PATH          APP_DATA_PATH("resume.pbs")
+#define RESUME_MENU_FILENAME "00_Continue"
+
+struct PinballApp;
+
+typedef struct {
+    char magic[4]; // RESUME_MAGIC, not NUL terminated
+    uint16_t version;
+    uint8_t physics; // ReplayPhysics: the snapshot's scalars are the build's
+    uint8_t tilted; // the game was left in GM_Tilted rather than GM_Playing
+    char table[RESUME_PATH_MAX]; // path of the table file
+    char name[RESUME_NAME_MAX]; // as named in the table list
+    uint32_t table_size; // of the table file
+    uint32_t table_hash; // FNV-1a of the table file
+    uint32_t records_size; // bytes of compiled table that follow
+    uint32_t snapshot_size; // bytes of snapshot after them
+} ResumeHeader;
+
+// The game in progress, and where its table came from
+typedef struct {
+    bool active; // a table game that resume_save() can save
+    char table[RESUME_PATH_MAX];
+    char name[RESUME_NAME_MAX];
+} Resume;
+
+// Call when a table from the list starts a game
+void resume_begin(PinballApp* pb, const char* path, const char* name);
+// Call when the game is over, so leaving it doesn't save it
+void resume_stop(PinballApp* pb);
+
+// Saves the game in progress to RESUME_PATH, if there is one and a ball has
+// been launched, and lists CONTINUE. Returns true if it saved.
+bool resume_save(PinballApp* pb);
+// Loads the saved game and its table, and removes the save. On failure
+// pb->text says why, and a save that can't ever be continued is removed.
+bool resume_continue(PinballApp* pb);
+
+// Lists CONTINUE at the top of the table list if there's a saved game, and
+// not otherwise
+void resume_list_update(PinballApp* pb);
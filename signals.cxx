@@ -1,118 +1,113 @@
 #include <furi.h>
+#include <algorithm>
 #include "objects.h"
 #include "signals.h"
 
 void SignalManager::register_signal(int id, void* ctx) {
     // FURI_LOG_I("SIGNAL", "Registered signal, id = %d", id);
-    signals.push_back({id, ctx, false});
+    signals.push_back({id, ctx});
 }
 
 void SignalManager::register_slot(int id, void* ctx) {
     // FURI_LOG_I("SIGNAL", "Registered slot, id = %d", id);
-    slots.push_back({id, ctx, false});
+    slots.push_back({id, ctx});
 }
 
 // Send signal 'id' and account for type ALL and ANY
 void SignalManager::send(void* ctx) {
     FixedObject* obj = (FixedObject*)ctx;
-    int id = obj->tx_id;
-
-    if(id == INVALID_ID) {
+    if(obj->tx_id == INVALID_ID) {
         return;
     }
-    // FURI_LOG_I("SIGNAL", "Attempting to send signal %d", id);
-    bool signal = true;
-    for(auto& s : signals) {
-        if(s.id == id) {
-            if(s.ctx == ctx) {
-                s.triggered = true;
-                if(((FixedObject*)(ctx))->tx_type == SignalType::ANY) {
-                    signal = true;
-                    break;
-                }
-            }
-            signal = signal & s.triggered;
-        }
+    SignalGroup& g = groups[obj->tx_group];
+    g.triggered |= obj->tx_bit;
+    if(g.type == SignalType::ALL && g.triggered != g.all) {
+        return;
     }
-    if(signal) {
-        // Send the signal to all objects who want it
-        // FURI_LOG_I(
-        //     "SIGNAL",
-        //     "Signals for id=%d, and type=%s",
-        //     id,
-        //     ((FixedObject*)(ctx))->tx_type == SignalType::ALL ? "ALL" : "ANY");
-        for(auto& s : slots) {
-            if(s.id == id) {
-                ((FixedObject*)(s.ctx))->signal_receive();
-            }
-        }
-        // Clear our internal state of what triggered (used for type ALL)
-        reset(id);
-        // Let the signal initiating objects know that we have sent the signal
-        for(auto& s : signals) {
-            if(s.id == id) {
-                ((FixedObject*)(s.ctx))->signal_send();
-            }
-        }
+    // Send the signal to all objects who want it
+    for(uint16_t i = 0; i < g.num_slots; i++) {
+        ((FixedObject*)(slots[g.first_slot + i].ctx))->signal_receive();
     }
-}
-
-void SignalManager::reset(int id) {
-    for(auto& s : signals) {
-        if(s.id == id) {
-            s.triggered = false;
-        }
+    // Clear our internal state of what triggered (used for type ALL)
+    g.triggered = 0;
+    // Let the signal initiating objects know that we have sent the signal
+    for(uint16_t i = 0; i < g.num_signals; i++) {
+        ((FixedObject*)(signals[g.first_signal + i].ctx))->signal_send();
     }
 }
 
-// better data structures would make this function more efficient
 bool SignalManager::validate(char* err, std::size_t err_size) {
-    // Verify that there is at least one slot for every signal
-    for(const auto& signal : signals) {
-        bool found = false;
-        for(const auto& slot : slots) {
-            if(signal.id == slot.id) {
-                found = true;
-                break;
+    auto by_id = [](const SignalData& a, const SignalData& b) { return a.id < b.id; };
+    std::stable_sort(signals.begin(), signals.end(), by_id);
+    std::stable_sort(slots.begin(), slots.end(), by_id);
+
+    // Walk both lists side by side, one group per id, noting the first
+    // problem of each kind
+    int no_slots = INVALID_ID, no_signals = INVALID_ID, differing = INVALID_ID,
+        crowded = INVALID_ID;
+    groups.clear();
+    size_t i = 0, j = 0;
+    while(i < signals.size() || j < slots.size()) {
+        bool from_signals = j == slots.size() ||
+                            (i < signals.size() && signals[i].id < slots[j].id);
+        SignalGroup g;
+        g.id = from_signals ? signals[i].id : slots[j].id;
+        g.type = SignalType::ALL;
+        g.triggered = 0;
+        g.all = 0;
+        g.first_signal = i;
+        g.first_slot = j;
+        for(; i < signals.size() && signals[i].id == g.id; i++) {
+            FixedObject* obj = (FixedObject*)signals[i].ctx;
+            uint16_t n = i - g.first_signal;
+            if(n == 0) {
+                g.type = obj->tx_type;
+            } else if(obj->tx_type != g.type && differing == INVALID_ID) {
+                differing = g.id;
             }
+            if(n == SIGNAL_MAX_SENDERS && crowded == INVALID_ID) {
+                crowded = g.id;
+            }
+            obj->tx_group = groups.size();
+            obj->tx_bit = n < SIGNAL_MAX_SENDERS ? 1u << n : 0;
+            g.all |= obj->tx_bit;
         }
-        if(!found) {
-            FURI_LOG_E("PB0 SIGNAL", "Signal %d has no slots!", signal.id);
-            snprintf(err, err_size, "Signal %d\nhas no\nslots!", signal.id);
-            return false;
+        while(j < slots.size() && slots[j].id == g.id) {
+            j++;
         }
-    }
-    // Verify that there is at least one signal for every slot
-    for(const auto& slot : slots) {
-        bool found = false;
-        for(const auto& signal : signals) {
-            if(slot.id == signal.id) {
-                found = true;
-                break;
-            }
+        g.num_signals = i - g.first_signal;
+        g.num_slots = j - g.first_slot;
+        if(g.num_slots == 0 && no_slots == INVALID_ID) {
+            no_slots = g.id;
         }
-        if(!found) {
-            FURI_LOG_E("PB0 SIGNAL", "Slot %d has no signals!", slot.id);
-            snprintf(err, err_size, "Slot %d\nhas no\nsignals!", slot.id);
-            return false;
+        if(g.num_signals == 0 && no_signals == INVALID_ID) {
+            no_signals = g.id;
         }
+        groups.push_back(g);
+    }
+
+    // Verify that there is at least one slot for every signal
+    if(no_slots != INVALID_ID) {
+        FURI_LOG_E("PB0 SIGNAL", "Signal %d has no slots!", no_slots);
+        snprintf(err, err_size, "Signal %d\nhas no\nslots!", no_slots);
+        return false;
+    }
+    // Verify that there is at least one signal for every slot
+    if(no_signals != INVALID_ID) {
+        FURI_LOG_E("PB0 SIGNAL", "Slot %d has no signals!", no_signals);
+        snprintf(err, err_size, "Slot %d\nhas no\nsignals!", no_signals);
+        return false;
     }
     // Verify that all objects with the same signal id have the same trigger type
-    bool valid_types = true;
-    for(const auto& signal : signals) {
-        const SignalType signal_type = ((FixedObject*)signal.ctx)->tx_type;
-        for(const auto& s : signals) {
-            FixedObject* s_obj = (FixedObject*)signal.ctx;
-            if(signal.id == s.id && signal_type != s_obj->tx_type) {
-                valid_types = false;
-                FURI_LOG_E("PB0 SIGNAL", "Signal %d has differing type!", s.id);
-                snprintf(err, err_size, "Signal %d\nhas diff\ntype!", s.id);
-                break;
-            }
-        }
-        if(!valid_types) {
-            break;
-        }
+    if(differing != INVALID_ID) {
+        FURI_LOG_E("PB0 SIGNAL", "Signal %d has differing type!", differing);
+        snprintf(err, err_size, "Signal %d\nhas diff\ntype!", differing);
+        return false;
+    }
+    if(crowded != INVALID_ID) {
+        FURI_LOG_E("PB0 SIGNAL", "Signal %d has too many senders!", crowded);
+        snprintf(err, err_size, "Signal %d\nhas too\nmany senders!", crowded);
+        return false;
     }
-    return valid_types;
+    return true;
 }
@@ -1,8 +1,12 @@
 #pragma once
+#include <stdint.h>
 #include <vector>
 
 #define INVALID_ID -1
 
+// Most objects that can send one signal id
+#define SIGNAL_MAX_SENDERS 32
+
 typedef enum {
     ALL,
     ANY
@@ -11,9 +15,20 @@ typedef enum {
 typedef struct SignalData {
     int id;
     void* ctx;
-    bool triggered;
 } SignalData;
 
+// Every sender and slot of one signal id, compiled by validate()
+typedef struct {
+    int id;
+    SignalType type;
+    uint32_t triggered; // a bit per sender that fired since the signal was last sent
+    uint32_t all; // every sender's bit
+    uint16_t first_signal; // this group's runs in signals and slots
+    uint16_t num_signals;
+    uint16_t first_slot;
+    uint16_t num_slots;
+} SignalGroup;
+
 class SignalManager {
 public:
     SignalManager() = default;
@@ -22,11 +37,13 @@ public:
     void register_slot(int id, void* ctx);
 
     void send(void* ctx);
-    void reset(int id);
 
+    // Checks every signal has slots and the other way round, and compiles the
+    // groups send() uses. Call once every object is registered.
     bool validate(char* err, std::size_t err_size);
 
-    // all id + ctx pairs must have triggered before we send
+    // grouped by id once validated, each group in the order registered
     std::vector<SignalData> signals;
     std::vector<SignalData> slots;
+    std::vector<SignalGroup> groups;
 };
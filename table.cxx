@@ -7,6 +7,7 @@
 #include "pinball0.h"
 #include "graphics.h"
 #include "table.h"
+#include "frame_profile.h"
 // #include "notifications.h"
 
 // Table defaults
@@ -17,8 +18,8 @@ void Lives::draw(Canvas* canvas) {
     // we don't draw the last one, as it's in play!
     constexpr float r = 20;
     if(display && value > 0) {
-        float x = p.x;
-        float y = p.y;
+        float x = (float)p.x;
+        float y = (float)p.y;
         float x_off = alignment == Align::Horizontal ? (2 * r) + r : 0;
         float y_off = alignment == Align::Vertical ? (2 * r) + r : 0;
         for(auto l = 0; l < value - 1; x += x_off, y += y_off, l++) {
@@ -31,7 +32,7 @@ void Score::draw(Canvas* canvas) {
     if(display) {
         char buf[32];
         snprintf(buf, 32, "%d", value);
-        gfx_draw_str(canvas, p.x, p.y, AlignRight, AlignTop, buf);
+        gfx_draw_str(canvas, (int)p.x, (int)p.y, AlignRight, AlignTop, buf);
     }
 }
 
@@ -41,34 +42,77 @@ Table::Table()
     , plunger(nullptr)
     , tilt_detect_enabled(true)
     , last_bump(furi_get_tick())
-    , bump_count(0) {
+    , bump_count(0)
+    , stats({0, 0, 0, 0, 0})
+    , alpha(1.0f)
+    , static_layer_ready(false)
+#ifdef TABLE_NO_STATIC_LAYER
+    , static_layer_enabled(false) {
+#else
+    , static_layer_enabled(true) {
+#endif
 }
 
 Table::~Table() {
     for(size_t i = 0; i < objects.size(); i++) {
         delete objects[i];
     }
+    for(size_t i = 0; i < decorations.size(); i++) {
+        delete decorations[i];
+    }
     if(plunger != nullptr) {
         delete plunger;
     }
 }
 
+void Table::draw_static(Canvas* canvas) {
+    if(!static_layer_enabled || static_layer.size() != canvas_get_buffer_size(canvas)) {
+        return;
+    }
+    uint8_t* buffer = canvas_get_buffer(canvas);
+    if(static_layer_ready) {
+        memcpy(buffer, static_layer.data(), static_layer.size());
+        return;
+    }
+    for(auto& o : objects) {
+        if(o->is_static()) {
+            o->draw(canvas);
+        }
+    }
+    for(auto& o : decorations) {
+        if(o->is_static()) {
+            o->draw(canvas);
+        }
+    }
+    memcpy(static_layer.data(), buffer, static_layer.size());
+    static_layer_ready = true;
+}
+
 void Table::draw(Canvas* canvas) {
     lives.draw(canvas);
 
     // da balls
     for(auto& b : balls) {
-        b.draw(canvas);
+        b.draw(canvas, alpha);
     }
 
-    // loop through objects on the table and draw them
+    // loop through objects on the table and draw them, less those already in
+    // the static layer
+    bool skip_static = static_layer_enabled && static_layer_ready;
     for(auto& o : objects) {
-        o->draw(canvas);
+        if(!skip_static || !o->is_static()) {
+            o->draw(canvas);
+        }
+    }
+    for(auto& o : decorations) {
+        if(!skip_static || !o->is_static()) {
+            o->draw(canvas);
+        }
     }
 
     // now draw flippers
     for(auto& f : flippers) {
-        f.draw(canvas);
+        f.draw(canvas, alpha);
     }
 
     // is there a plunger in the house?
@@ -79,9 +123,151 @@ void Table::draw(Canvas* canvas) {
     score.draw(canvas);
 }
 
+void Table::bake() {
+    colliders.build(objects);
+    grid.build(colliders);
+    size_t most_balls = balls.size() > balls_initial.size() ? balls.size() : balls_initial.size();
+    balls.reserve(most_balls);
+    ball_grid.reserve(most_balls);
+    static_layer.assign(TABLE_STATIC_LAYER_SIZE, 0);
+    static_layer_ready = false;
+}
+
+void Table::wake_balls() {
+    for(auto& b : balls) {
+        b.wake();
+    }
+}
+
+void Table::tilt() {
+    bump_count = 0;
+    for(auto& o : objects) {
+        o->reset_state();
+    }
+    colliders.sync(objects);
+    wake_balls();
+}
+
+size_t Table::snapshot_size() const {
+    return sizeof(TableSnapshot) + balls.size() * sizeof(BallSnapshot) +
+           flippers.size() * sizeof(FlipperSnapshot) + objects.size() +
+           sm.groups.size() * sizeof(uint32_t);
+}
+
+void Table::save_snapshot(uint8_t* data) const {
+    TableSnapshot header;
+    memset(&header, 0, sizeof(header));
+    header.balls = balls.size();
+    header.flippers = flippers.size();
+    header.objects = objects.size();
+    header.signal_groups = sm.groups.size();
+    header.score = score.value;
+    header.lives = lives.value;
+    header.bump_count = bump_count;
+    header.last_bump = last_bump;
+    header.balls_released = balls_released;
+    header.game_over = game_over;
+    memcpy(data, &header, sizeof(header));
+    data += sizeof(header);
+
+    // copied through locals: the snapshot itself needn't be aligned
+    for(const auto& b : balls) {
+        BallSnapshot bs = {b.p, b.prev_p, b.a, b.rest_p, b.r, b.still_steps, b.asleep, b.swept};
+        memcpy(data, &bs, sizeof(bs));
+        data += sizeof(bs);
+    }
+    for(const auto& f : flippers) {
+        FlipperSnapshot fs = {f.rotation, f.prev_rotation, f.current_omega, f.powered, {0, 0, 0}};
+        memcpy(data, &fs, sizeof(fs));
+        data += sizeof(fs);
+    }
+    for(const auto& o : objects) {
+        *data++ = o->snapshot();
+    }
+    for(const auto& g : sm.groups) {
+        memcpy(data, &g.triggered, sizeof(g.triggered));
+        data += sizeof(g.triggered);
+    }
+}
+
+bool Table::restore_snapshot(const uint8_t* data, size_t size) {
+    TableSnapshot header;
+    if(size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    data += sizeof(header);
+    if(header.flippers != flippers.size() || header.objects != objects.size() ||
+       header.signal_groups != sm.groups.size()) {
+        return false;
+    }
+    size_t expected = sizeof(header) + header.balls * sizeof(BallSnapshot) +
+                      header.flippers * sizeof(FlipperSnapshot) + header.objects +
+                      header.signal_groups * sizeof(uint32_t);
+    if(size != expected) {
+        return false;
+    }
+
+    score.value = header.score;
+    lives.value = header.lives;
+    bump_count = header.bump_count;
+    last_bump = header.last_bump;
+    balls_released = header.balls_released;
+    game_over = header.game_over;
+
+    {
+        // the ball count can differ, and the balls live in the arena
+        ArenaScope scope(arena);
+        balls.resize(header.balls);
+    }
+    for(auto& b : balls) {
+        BallSnapshot bs;
+        memcpy(&bs, data, sizeof(bs));
+        data += sizeof(bs);
+        b.p = bs.p;
+        b.prev_p = bs.prev_p;
+        b.a = bs.a;
+        b.rest_p = bs.rest_p;
+        b.r = bs.r;
+        b.still_steps = bs.still_steps;
+        b.asleep = bs.asleep;
+        b.swept = bs.swept;
+    }
+    for(auto& f : flippers) {
+        FlipperSnapshot fs;
+        memcpy(&fs, data, sizeof(fs));
+        data += sizeof(fs);
+        f.rotation = fs.rotation;
+        f.prev_rotation = fs.prev_rotation;
+        f.current_omega = fs.current_omega;
+        f.powered = fs.powered;
+    }
+    for(auto& o : objects) {
+        o->restore(*data++);
+    }
+    for(auto& g : sm.groups) {
+        memcpy(&g.triggered, data, sizeof(g.triggered));
+        data += sizeof(g.triggered);
+    }
+    colliders.sync(objects);
+    events.clear();
+    return true;
+}
+
+void Table::step_animation() {
+    FrameSectionScope scope(FrameSectionAnimation);
+    for(auto& o : objects) {
+        o->step_animation();
+    }
+    for(auto& o : decorations) {
+        o->step_animation();
+    }
+}
+
 Table* table_init_table_select(void* ctx) {
     UNUSED(ctx);
-    Table* table = new Table();
+    Table* table = table_alloc(TABLE_ARENA_MENU);
+    ArenaScope arena(table->arena);
 
     table->balls.push_back(Ball(Vec2(20, 880), 35));
     table->balls.back().add_velocity(Vec2(7, 0), .10f);
@@ -117,22 +303,24 @@ Table* table_init_table_select(void* ctx) {
     int speed = 3;
     float top = 20;
     // right side
-    table->objects.push_back(new Chaser(Vec2(32, top), Vec2(62, top), gap, speed));
-    table->objects.push_back(new Chaser(Vec2(62, top), Vec2(62, 84), gap, speed));
-    table->objects.push_back(new Chaser(Vec2(62, 84), Vec2(32, 84), gap, speed));
+    table->decorations.push_back(new Chaser(Vec2(32, top), Vec2(62, top), gap, speed));
+    table->decorations.push_back(new Chaser(Vec2(62, top), Vec2(62, 84), gap, speed));
+    table->decorations.push_back(new Chaser(Vec2(62, 84), Vec2(32, 84), gap, speed));
 
     // left side
-    table->objects.push_back(new Chaser(Vec2(32, top), Vec2(1, top), gap, speed));
-    table->objects.push_back(new Chaser(Vec2(1, top), Vec2(1, 84), gap, speed));
-    table->objects.push_back(new Chaser(Vec2(1, 84), Vec2(32, 84), gap, speed));
+    table->decorations.push_back(new Chaser(Vec2(32, top), Vec2(1, top), gap, speed));
+    table->decorations.push_back(new Chaser(Vec2(1, top), Vec2(1, 84), gap, speed));
+    table->decorations.push_back(new Chaser(Vec2(1, 84), Vec2(32, 84), gap, speed));
 
+    table->bake();
     return table;
 }
 
 Table* table_init_table_error(void* ctx) {
     UNUSED(ctx);
     // PinballApp* pb = (PinballApp*)ctx;
-    Table* table = new Table();
+    Table* table = table_alloc(TABLE_ARENA_MENU);
+    ArenaScope arena(table->arena);
 
     table->balls.push_back(Ball(Vec2(20, 880), 30));
     table->balls.back().add_velocity(Vec2(7, 0), .10f);
@@ -168,17 +356,19 @@ Table* table_init_table_error(void* ctx) {
     int speed = 3;
     float top = 20;
 
-    table->objects.push_back(new Chaser(Vec2(2, top), Vec2(61, top), gap, speed, Chaser::SLASH));
-    table->objects.push_back(new Chaser(Vec2(2, top), Vec2(2, 84), gap, speed, Chaser::SLASH));
-    table->objects.push_back(new Chaser(Vec2(2, 84), Vec2(61, 84), gap, speed, Chaser::SLASH));
-    table->objects.push_back(new Chaser(Vec2(61, top), Vec2(61, 84), gap, speed, Chaser::SLASH));
+    table->decorations.push_back(new Chaser(Vec2(2, top), Vec2(61, top), gap, speed, Chaser::SLASH));
+    table->decorations.push_back(new Chaser(Vec2(2, top), Vec2(2, 84), gap, speed, Chaser::SLASH));
+    table->decorations.push_back(new Chaser(Vec2(2, 84), Vec2(61, 84), gap, speed, Chaser::SLASH));
+    table->decorations.push_back(new Chaser(Vec2(61, top), Vec2(61, 84), gap, speed, Chaser::SLASH));
 
+    table->bake();
     return table;
 }
 
 Table* table_init_table_settings(void* ctx) {
     UNUSED(ctx);
-    Table* table = new Table();
+    Table* table = table_alloc(TABLE_ARENA_MENU);
+    ArenaScope arena(table->arena);
 
     // table->balls.push_back(Ball(Vec2(20, 880), 10));
     // table->balls.back().add_velocity(Vec2(7, 0), .10f);
@@ -210,6 +400,7 @@ Table* table_init_table_settings(void* ctx) {
     new_rail->hidden = true;
     table->objects.push_back(new_rail);
 
+    table->bake();
     return table;
 }
 
@@ -239,5 +430,13 @@ bool table_load_table(void* ctx, size_t index) {
         pb->table = table_load_table_from_file(pb, index - TABLE_INDEX_OFFSET);
         break;
     }
+    if(pb->table) {
+        FURI_LOG_I(
+            TAG,
+            "Table arena: %u of %u bytes used, %u block(s)",
+            (unsigned)pb->table->arena.used(),
+            (unsigned)pb->table->arena.capacity(),
+            (unsigned)pb->table->arena.blocks());
+    }
     return pb->table != NULL;
 }
@@ -5,12 +5,32 @@
 #include "pinball0.h"
 #include "objects.h"
 #include "signals.h"
+#include "colliders.h"
+#include "grid.h"
+#include "collision_events.h"
+#include "arena.h"
+#include "table_format.h"
+#include "json_stream.h"
 
 #define TABLE_SELECT       0
 #define TABLE_ERROR        1
 #define TABLE_SETTINGS     2
 #define TABLE_INDEX_OFFSET 3
 
+// Objects that never change (FixedObject::is_static()) are drawn once into a
+// copy of the canvas buffer, which is copied back at the start of each frame.
+// Uncomment to draw every object every frame instead.
+// #define TABLE_NO_STATIC_LAYER
+#define TABLE_STATIC_LAYER_SIZE (LCD_WIDTH * LCD_HEIGHT / 8)
+
+// Arena bytes every table needs besides its records: the broadphase grids, the
+// static layer and the first allocations of each collider vector. Per record, the grid is
+// assumed to hold TABLE_ARENA_GRID_CELLS entries.
+#define TABLE_ARENA_BASE       (1024 + TABLE_STATIC_LAYER_SIZE + 4 * GRID_CELLS + 16 * ARENA_HEADER)
+#define TABLE_ARENA_GRID_CELLS 6
+// Arena bytes for the built-in menu, error and settings screens
+#define TABLE_ARENA_MENU 2048
+
 // Table display elements, rendered on the physical display coordinates,
 // not the table's scaled coords
 class DataDisplay {
@@ -47,6 +67,51 @@ public:
     void draw(Canvas* canvas);
 };
 
+// Running counters of physics work, for benchmarking
+typedef struct {
+    uint32_t substeps;
+    uint32_t collision_tests; // narrow-phase tests, objects and flippers
+    uint32_t collisions; // narrow-phase tests that hit
+    uint32_t ball_tests; // ball pairs tested against each other
+    uint32_t ball_steps_asleep; // ball steps skipped because the ball slept
+} PhysicsStats;
+
+// A table's runtime state, everything that changes during a game apart from
+// animations, as a TableSnapshot followed by its balls, flippers, objects and
+// signal groups. Only good for the table, and the physics build, that saved it.
+typedef struct {
+    uint16_t balls; // BallSnapshots that follow
+    uint16_t flippers; // FlipperSnapshots
+    uint16_t objects; // one FixedObject::snapshot() byte each
+    uint16_t signal_groups; // one SignalGroup::triggered each
+    int32_t score;
+    int32_t lives;
+    uint32_t bump_count;
+    uint32_t last_bump;
+    uint8_t balls_released;
+    uint8_t game_over;
+    uint8_t reserved[2];
+} TableSnapshot;
+
+typedef struct {
+    Vec2 p;
+    Vec2 prev_p;
+    Vec2 a;
+    Vec2 rest_p;
+    Scalar r;
+    uint16_t still_steps;
+    uint8_t asleep;
+    uint8_t swept;
+} BallSnapshot;
+
+typedef struct {
+    Scalar rotation;
+    Scalar prev_rotation;
+    Scalar current_omega;
+    uint8_t powered;
+    uint8_t reserved[3];
+} FlipperSnapshot;
+
 // Defines all of the elements on a pinball table:
 // edges, bumpers, flipper locations, scoreboard
 //
@@ -59,7 +124,12 @@ public:
 
     ~Table();
 
+    // Holds all of the table's objects and vectors, so it's declared first:
+    // it must outlive everything allocated from it
+    Arena arena;
+
     std::vector<FixedObject*> objects;
+    std::vector<FixedObject*> decorations; // draw-only, never collide
     std::vector<Ball> balls; // current state of balls
     std::vector<Ball> balls_initial; // original positions, before release
     std::vector<Flipper> flippers;
@@ -78,14 +148,77 @@ public:
 
     SignalManager sm;
 
+    // collision shapes baked from objects, and the broadphase over them
+    Colliders colliders;
+    CollisionGrid grid;
+    BallGrid ball_grid;
+    PhysicsStats stats;
+    // hits waiting for dispatch_collision_events()
+    CollisionEvents events;
+
+    // how far [0..1] rendering is between the last two physics steps
+    float alpha;
+
+    // The canvas as it looks with only the static objects drawn, captured on
+    // the first frame. Stays unused if the canvas isn't the size we expect.
+    std::vector<uint8_t> static_layer;
+    bool static_layer_ready;
+    bool static_layer_enabled;
+
+    // Builds colliders and grid from objects; call once the table is complete
+    void bake();
+    // Wakes every sleeping ball, for changes that could move any of them
+    void wake_balls();
+    // Puts every object back as it was loaded, for a tilt
+    void tilt();
+    // Snapshot of the runtime state, snapshot_size() bytes
+    size_t snapshot_size() const;
+    void save_snapshot(uint8_t* data) const;
+    // Puts the table back as save_snapshot() left it, in time proportional to
+    // the snapshot's size. Returns false, leaving the table alone, if the
+    // snapshot wasn't taken of this table.
+    bool restore_snapshot(const uint8_t* data, size_t size);
+    // Call on a blank canvas at the start of a frame, before anything else is
+    // drawn, and draw() later in the frame
+    void draw_static(Canvas* canvas);
     void draw(Canvas* canvas);
+    void step_animation();
 };
 
 // Read the list tables from the data folder and store in the state
 void table_table_list_init(void* ctx);
 
-// Reads the table file and creates the new table.
+// Reads the table file and creates the new table. Compiled .pb0 tables are
+// loaded with table_load_table_from_pb0(), anything else is parsed as JSON.
 Table* table_load_table_from_file(PinballApp* ctx, size_t index);
+Table* table_load_table_from_pb0(PinballApp* ctx, const char* path);
+// Reads a compiled table from where 'file' is, up to the end of its records
+Table* table_read_pb0(PinballApp* ctx, File* file);
+// Reads a table file, .pb0 or JSON, right through without building it, for
+// the table list: 'name' (PB0_NAME_MAX bytes) gets the name the table gives
+// itself, or "" if it has none. Returns false if it isn't a readable table.
+bool table_read_name(Storage* storage, const char* path, char* name);
+
+// Streams a JSON table from 'read', passing each object to 'cb' as a record
+// as soon as it has been read, in file order. Returns false on a syntax error.
+bool table_json_read(
+    JsonReadCallback read,
+    void* read_ctx,
+    Pb0Header* header,
+    Pb0RecordCallback cb,
+    void* ctx);
+
+// Building a table from records, shared by the JSON and .pb0 loaders. Loaders
+// make a first pass with table_size_record() to size the table's arena, then
+// allocate it with table_alloc() and add the records for real.
+size_t table_record_arena_size(uint8_t type, const Pb0Record& record);
+bool table_size_record(void* size, uint8_t type, const Pb0Record& record); // adds to a size_t
+Table* table_alloc(size_t arena_size); // plus TABLE_ARENA_BASE
+void table_apply_header(Table* table, const Pb0Header& header);
+bool table_add_record(void* table, uint8_t type, const Pb0Record& record); // a Pb0RecordCallback
+// Validates and bakes a table with all its records added. Frees it and
+// returns NULL, with the reason in ctx->text, if it isn't playable.
+Table* table_finish(PinballApp* ctx, Table* table);
 
 // Loads the index'th table from the list
 bool table_load_table(void* ctx, size_t index);
@@ -0,0 +1,385 @@
+#include <furi.h>
+#include <storage/storage.h>
+
+#include "pinball0.h"
+#include "table.h"
+#include "table_format.h"
+#include "load_profile.h"
+#include "arena.h"
+#include "notifications.h"
+
+namespace {
+Vec2 to_vec2(const Pb0Vec2& v) {
+    return Vec2(v.x, v.y);
+}
+
+void apply_signal(Table* table, FixedObject* obj, const Pb0Signal& sig) {
+    if(sig.tx != INVALID_ID) {
+        obj->tx_id = sig.tx;
+        table->sm.register_signal(sig.tx, obj);
+    }
+    if(sig.rx != INVALID_ID) {
+        obj->rx_id = sig.rx;
+        table->sm.register_slot(sig.rx, obj);
+    }
+    obj->tx_type = sig.any ? SignalType::ANY : SignalType::ALL;
+}
+
+Polygon* make_rail(const Pb0Vec2& s, const Pb0Vec2& e, float bounce) {
+    Polygon* rail = new Polygon();
+    rail->add_point(to_vec2(s));
+    rail->add_point(to_vec2(e));
+    rail->bounce = bounce;
+    rail->finalize();
+    rail->notification = &notify_rail_hit;
+    return rail;
+}
+
+// Reads exactly 'size' bytes
+bool pb0_read(File* file, void* buf, size_t size) {
+    LoadPhaseScope scope(LoadPhaseRead);
+    return storage_file_read(file, buf, size) == size;
+}
+
+// Reads 'count' records, passing each to 'cb'
+bool pb0_read_records(File* file, uint16_t count, Pb0RecordCallback cb, void* ctx) {
+    for(uint16_t i = 0; i < count; i++) {
+        Pb0RecordHeader rh;
+        Pb0Record rec;
+        memset(&rec, 0, sizeof(rec));
+        if(!pb0_read(file, &rh, sizeof(rh))) {
+            return false;
+        }
+        // read what we know of the record, and skip the rest
+        size_t known = pb0_record_size(rh.type);
+        size_t want = rh.size < known ? rh.size : known;
+        if(!pb0_read(file, &rec, want)) {
+            return false;
+        }
+        for(size_t skip = rh.size - want; skip > 0;) {
+            uint8_t scratch[16];
+            size_t n = skip < sizeof(scratch) ? skip : sizeof(scratch);
+            if(!pb0_read(file, scratch, n)) {
+                return false;
+            }
+            skip -= n;
+        }
+        if(known) {
+            cb(ctx, rh.type, rec);
+        }
+    }
+    return true;
+}
+
+// Arena bytes for 'n' elements of a vector that grew one push_back at a time:
+// the buffers it outgrew add up to about as much again as the last one, and
+// each buffer has its ARENA_HEADER
+constexpr size_t grown(size_t n, size_t size) {
+    return n * (size * 2 + ARENA_HEADER);
+}
+
+// Arena bytes for the FixedObject part of a record: its entry in the table,
+// its liveness flag and its share of the grid
+constexpr size_t object_size(size_t size) {
+    return size + grown(1, sizeof(FixedObject*)) + grown(1, sizeof(uint8_t)) +
+           TABLE_ARENA_GRID_CELLS * sizeof(uint16_t) + 2 * ARENA_ALIGN + ARENA_HEADER;
+}
+
+size_t signal_size(const Pb0Signal& sig) {
+    return ((sig.tx != INVALID_ID) + (sig.rx != INVALID_ID)) * grown(1, sizeof(SignalData));
+}
+
+size_t file_read(void* ctx, char* buf, size_t size) {
+    return storage_file_read((File*)ctx, buf, size);
+}
+
+bool copy_name(void* ctx, uint8_t type, const Pb0Record& rec) {
+    if(type == Pb0Name) {
+        memcpy(ctx, rec.name.name, PB0_NAME_MAX);
+        ((char*)ctx)[PB0_NAME_MAX - 1] = '\0';
+    }
+    return true;
+}
+}
+
+void pb0_header_init(Pb0Header* header) {
+    memset(header, 0, sizeof(Pb0Header));
+    memcpy(header->magic, PB0_MAGIC, sizeof(header->magic));
+    header->version = PB0_VERSION;
+    // as set up by Table(), Lives() and Score()
+    Lives lives;
+    Score score;
+    header->lives = lives.value;
+    header->lives_display = lives.display;
+    header->lives_pos = {(float)lives.p.x, (float)lives.p.y};
+    header->score_display = score.display;
+    header->score_pos = {(float)score.p.x, (float)score.p.y};
+    header->tilt_detect = 1;
+}
+
+size_t pb0_record_size(uint8_t type) {
+    switch(type) {
+    case Pb0Ball:
+        return sizeof(Pb0BallRecord);
+    case Pb0Plunger:
+        return sizeof(Pb0PlungerRecord);
+    case Pb0Flipper:
+        return sizeof(Pb0FlipperRecord);
+    case Pb0Bumper:
+        return sizeof(Pb0BumperRecord);
+    case Pb0Arc:
+        return sizeof(Pb0ArcRecord);
+    case Pb0Rail:
+        return sizeof(Pb0RailRecord);
+    case Pb0Portal:
+        return sizeof(Pb0PortalRecord);
+    case Pb0Rollover:
+        return sizeof(Pb0RolloverRecord);
+    case Pb0Turbo:
+        return sizeof(Pb0TurboRecord);
+    case Pb0Name:
+        return sizeof(Pb0NameRecord);
+    default:
+        return 0;
+    }
+}
+
+void table_apply_header(Table* table, const Pb0Header& header) {
+    table->lives.value = header.lives;
+    table->lives.display = header.lives_display;
+    table->lives.p = to_vec2(header.lives_pos);
+    table->lives.alignment = header.lives_vertical ? Lives::Vertical : Lives::Horizontal;
+    table->score.display = header.score_display;
+    table->score.p = to_vec2(header.score_pos);
+    table->tilt_detect_enabled = header.tilt_detect;
+}
+
+size_t table_record_arena_size(uint8_t type, const Pb0Record& rec) {
+    switch(type) {
+    case Pb0Ball:
+        // balls and balls_initial, and the ball's place in the ball grid
+        return 2 * grown(1, sizeof(Ball)) + 2 * sizeof(uint16_t) + sizeof(uint32_t);
+    case Pb0Plunger:
+        return sizeof(Plunger) + ARENA_ALIGN + ARENA_HEADER;
+    case Pb0Flipper:
+        return grown(1, sizeof(Flipper));
+    case Pb0Bumper:
+        return object_size(sizeof(Bumper)) + grown(1, sizeof(ArcCollider)) +
+               signal_size(rec.bumper.signal);
+    case Pb0Arc:
+        return object_size(sizeof(Arc)) + grown(1, sizeof(ArcCollider)) +
+               gfx_arc_outline_size(rec.arc.r) * sizeof(GfxPoint) + ARENA_ALIGN +
+               ARENA_HEADER;
+    case Pb0Rail:
+        return (rec.rail.double_sided ? 2 : 1) *
+               (object_size(sizeof(Polygon)) + grown(2, sizeof(Vec2)) + grown(1, sizeof(Vec2)) +
+                grown(1, sizeof(Segment)) + grown(1, sizeof(RailCollider)));
+    case Pb0Portal:
+        return object_size(sizeof(Portal)) + grown(1, sizeof(PortalCollider));
+    case Pb0Rollover:
+        return object_size(sizeof(Rollover)) + grown(1, sizeof(TriggerCollider)) +
+               signal_size(rec.rollover.signal);
+    case Pb0Turbo:
+        return object_size(sizeof(Turbo)) + grown(1, sizeof(TriggerCollider));
+    default:
+        return 0;
+    }
+}
+
+bool table_size_record(void* ctx, uint8_t type, const Pb0Record& rec) {
+    *(size_t*)ctx += table_record_arena_size(type, rec);
+    return true;
+}
+
+Table* table_alloc(size_t arena_size) {
+    Table* table = new Table();
+    table->arena.reserve(TABLE_ARENA_BASE + arena_size);
+    return table;
+}
+
+bool table_add_record(void* ctx, uint8_t type, const Pb0Record& rec) {
+    LoadPhaseScope scope(LoadPhaseBuild);
+    Table* table = (Table*)ctx;
+    ArenaScope arena(table->arena);
+    switch(type) {
+    case Pb0Ball: {
+        Ball ball(to_vec2(rec.ball.p), rec.ball.r);
+        ball.accelerate(to_vec2(rec.ball.v));
+        table->balls_initial.push_back(ball);
+        table->balls.push_back(ball);
+        break;
+    }
+    case Pb0Plunger:
+        if(table->plunger == nullptr) {
+            table->plunger = new Plunger(to_vec2(rec.plunger.p));
+        }
+        break;
+    case Pb0Flipper:
+        table->flippers.push_back(
+            Flipper(to_vec2(rec.flipper.p), (Flipper::Side)rec.flipper.side, rec.flipper.size));
+        break;
+    case Pb0Bumper: {
+        Bumper* bumper = new Bumper(to_vec2(rec.bumper.p), rec.bumper.r);
+        bumper->bounce = rec.bumper.bounce;
+        bumper->notification = notify_bumper_hit;
+        bumper->physical = rec.bumper.physical;
+        bumper->hidden = rec.bumper.hidden;
+        apply_signal(table, bumper, rec.bumper.signal);
+        table->objects.push_back(bumper);
+        break;
+    }
+    case Pb0Arc: {
+        Arc* arc = new Arc(
+            to_vec2(rec.arc.p),
+            rec.arc.r,
+            rec.arc.start,
+            rec.arc.end,
+            (Arc::Surface)rec.arc.surface);
+        arc->bounce = rec.arc.bounce;
+        table->objects.push_back(arc);
+        break;
+    }
+    case Pb0Rail:
+        table->objects.push_back(make_rail(rec.rail.start, rec.rail.end, rec.rail.bounce));
+        if(rec.rail.double_sided) {
+            table->objects.push_back(make_rail(rec.rail.end, rec.rail.start, rec.rail.bounce));
+        }
+        break;
+    case Pb0Portal: {
+        Portal* portal = new Portal(
+            to_vec2(rec.portal.a1),
+            to_vec2(rec.portal.a2),
+            to_vec2(rec.portal.b1),
+            to_vec2(rec.portal.b2));
+        portal->finalize();
+        portal->notification = &notify_portal;
+        table->objects.push_back(portal);
+        break;
+    }
+    case Pb0Rollover: {
+        Rollover* rollover = new Rollover(to_vec2(rec.rollover.p), rec.rollover.symbol);
+        apply_signal(table, rollover, rec.rollover.signal);
+        table->objects.push_back(rollover);
+        break;
+    }
+    case Pb0Turbo:
+        table->objects.push_back(
+            new Turbo(to_vec2(rec.turbo.p), rec.turbo.angle, rec.turbo.boost, rec.turbo.r));
+        break;
+    case Pb0Name: // only for the table list
+        break;
+    default:
+        FURI_LOG_W(TAG, "Skipping unknown table record type %d", type);
+        break;
+    }
+    return true;
+}
+
+Table* table_finish(PinballApp* pb, Table* table) {
+    if(table->balls.size() == 0) {
+        FURI_LOG_E(TAG, "Table has NO BALLS");
+        snprintf(pb->text, 256, "No balls\nfound in\ntable file!");
+        delete table;
+        return NULL;
+    }
+
+    {
+        LoadPhaseScope scope(LoadPhaseBuild);
+        for(auto& o : table->objects) {
+            o->save_state();
+        }
+    }
+
+    bool valid;
+    {
+        LoadPhaseScope scope(LoadPhaseValidate);
+        valid = table->sm.validate(pb->text, 256);
+    }
+    if(!valid) {
+        FURI_LOG_E(TAG, "Signal validation failed!");
+        delete table;
+        return NULL;
+    }
+
+    LoadPhaseScope scope(LoadPhaseBake);
+    ArenaScope arena(table->arena);
+    table->bake();
+    return table;
+}
+
+Table* table_load_table_from_pb0(PinballApp* pb, const char* path) {
+    FURI_LOG_I(TAG, "Reading compiled table: %s", path);
+
+    File* file = storage_file_alloc(pb->storage);
+    bool ok;
+    {
+        LoadPhaseScope scope(LoadPhaseRead);
+        ok = storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING);
+    }
+    if(!ok) {
+        FURI_LOG_E(TAG, "Failed to open table file: %s", path);
+        snprintf(pb->text, 256, "Failed\nto open\nfile!");
+        storage_file_free(file);
+        return NULL;
+    }
+    Table* table = table_read_pb0(pb, file);
+    storage_file_free(file);
+    return table;
+}
+
+Table* table_read_pb0(PinballApp* pb, File* file) {
+    Pb0Header header;
+    if(!pb0_read(file, &header, sizeof(header)) ||
+       memcmp(header.magic, PB0_MAGIC, sizeof(header.magic)) != 0) {
+        FURI_LOG_E(TAG, "Not a compiled table file");
+        snprintf(pb->text, 256, "Not a\ncompiled\ntable file!");
+        return NULL;
+    }
+    if(header.version != PB0_VERSION) {
+        FURI_LOG_E(TAG, "Table file version %d, expected %d", header.version, PB0_VERSION);
+        snprintf(pb->text, 256, "Table file\nversion %d\nunsupported!", header.version);
+        return NULL;
+    }
+
+    // a first pass over the records sizes the table's arena
+    uint32_t records = storage_file_tell(file);
+    size_t arena_size = 0;
+    bool ok = pb0_read_records(file, header.record_count, table_size_record, &arena_size) &&
+              storage_file_seek(file, records, true);
+
+    Table* table;
+    {
+        LoadPhaseScope scope(LoadPhaseBuild);
+        table = table_alloc(arena_size);
+    }
+    table_apply_header(table, header);
+
+    // records go straight from the file into the table, one at a time
+    ok = ok && pb0_read_records(file, header.record_count, table_add_record, table);
+
+    if(!ok) {
+        FURI_LOG_E(TAG, "Table file is truncated");
+        snprintf(pb->text, 256, "Table file\nis truncated!");
+        delete table;
+        return NULL;
+    }
+    return table_finish(pb, table);
+}
+
+bool table_read_name(Storage* storage, const char* path, char* name) {
+    name[0] = '\0';
+    File* file = storage_file_alloc(storage);
+    bool ok = storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING);
+    const char* ext = strrchr(path, '.');
+    Pb0Header header;
+    if(ext && !strcmp(ext, ".pb0")) {
+        ok = ok && pb0_read(file, &header, sizeof(header)) &&
+             !memcmp(header.magic, PB0_MAGIC, sizeof(header.magic)) &&
+             header.version == PB0_VERSION &&
+             pb0_read_records(file, header.record_count, copy_name, name);
+    } else {
+        ok = ok && table_json_read(file_read, file, &header, copy_name, name);
+    }
+    storage_file_free(file);
+    return ok;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Compiled table format (.pb0)
+//
+// A Pb0Header, then header.record_count records. Each record is a
+// Pb0RecordHeader followed by 'size' bytes of the fixed-layout struct for its
+// type. Loaders skip record types they don't know, and any trailing bytes of
+// records that are larger than they expect, so fields can be appended to a
+// record without bumping PB0_VERSION. Changing or removing a field needs a
+// version bump.
+//
+// All values are little-endian, floats are IEEE 754 singles and angles are in
+// radians. Records appear in the order their objects are added to the table,
+// which is also the order the JSON loader adds them.
+//
+// A table's "name" is a Pb0Name record, for the table list; it adds nothing
+// to the table itself.
+//
+// .pb0 files are made from .json tables by the host compiler, pinball0_pb0c.
+
+#define PB0_MAGIC   "PB0T"
+#define PB0_VERSION 1
+
+typedef struct {
+    float x;
+    float y;
+} Pb0Vec2;
+
+typedef struct {
+    char magic[4]; // PB0_MAGIC, not NUL terminated
+    uint16_t version;
+    uint16_t record_count;
+    Pb0Vec2 lives_pos;
+    Pb0Vec2 score_pos;
+    int16_t lives;
+    uint8_t lives_display;
+    uint8_t lives_vertical;
+    uint8_t score_display;
+    uint8_t tilt_detect;
+    uint8_t reserved[2];
+} Pb0Header;
+
+typedef enum {
+    Pb0Ball = 1,
+    Pb0Plunger,
+    Pb0Flipper,
+    Pb0Bumper,
+    Pb0Arc,
+    Pb0Rail,
+    Pb0Portal,
+    Pb0Rollover,
+    Pb0Turbo,
+    Pb0Name, // what the table list calls the table; adds nothing to the table
+} Pb0RecordType;
+
+typedef struct {
+    uint8_t type; // Pb0RecordType
+    uint8_t size; // bytes of record data that follow
+} Pb0RecordHeader;
+
+// Signal ids are INVALID_ID when unused
+typedef struct {
+    int16_t tx;
+    int16_t rx;
+    uint8_t any; // SignalType::ANY rather than ALL
+    uint8_t reserved[3];
+} Pb0Signal;
+
+typedef struct {
+    Pb0Vec2 p;
+    Pb0Vec2 v;
+    float r;
+} Pb0BallRecord;
+
+typedef struct {
+    Pb0Vec2 p;
+    int16_t size;
+    uint8_t reserved[2];
+} Pb0PlungerRecord;
+
+typedef struct {
+    Pb0Vec2 p;
+    uint16_t size;
+    uint8_t side; // Flipper::Side
+    uint8_t reserved;
+} Pb0FlipperRecord;
+
+typedef struct {
+    Pb0Vec2 p;
+    float r;
+    float bounce;
+    uint8_t physical;
+    uint8_t hidden;
+    uint8_t reserved[2];
+    Pb0Signal signal;
+} Pb0BumperRecord;
+
+typedef struct {
+    Pb0Vec2 p;
+    float r;
+    float bounce;
+    float start;
+    float end;
+    uint8_t surface; // Arc::Surface
+    uint8_t reserved[3];
+} Pb0ArcRecord;
+
+typedef struct {
+    Pb0Vec2 start;
+    Pb0Vec2 end;
+    float bounce;
+    uint8_t double_sided;
+    uint8_t reserved[3];
+} Pb0RailRecord;
+
+typedef struct {
+    Pb0Vec2 a1, a2;
+    Pb0Vec2 b1, b2;
+} Pb0PortalRecord;
+
+typedef struct {
+    Pb0Vec2 p;
+    char symbol;
+    uint8_t reserved[3];
+    Pb0Signal signal;
+} Pb0RolloverRecord;
+
+typedef struct {
+    Pb0Vec2 p;
+    float angle;
+    float boost;
+    float r;
+} Pb0TurboRecord;
+
+#define PB0_NAME_MAX 32 // with its NUL
+
+typedef struct {
+    char name[PB0_NAME_MAX]; // NUL terminated
+} Pb0NameRecord;
+
+// Big enough for any record this version knows
+typedef union {
+    Pb0BallRecord ball;
+    Pb0PlungerRecord plunger;
+    Pb0FlipperRecord flipper;
+    Pb0BumperRecord bumper;
+    Pb0ArcRecord arc;
+    Pb0RailRecord rail;
+    Pb0PortalRecord portal;
+    Pb0RolloverRecord rollover;
+    Pb0TurboRecord turbo;
+    Pb0NameRecord name;
+} Pb0Record;
+
+static_assert(sizeof(Pb0Header) == 32, "Pb0Header layout changed");
+static_assert(sizeof(Pb0Record) <= 255, "records must fit Pb0RecordHeader::size");
+
+// Sets a header to the defaults of a table file that doesn't say otherwise
+void pb0_header_init(Pb0Header* header);
+
+// Size of the record data for a type, or 0 if it's unknown
+size_t pb0_record_size(uint8_t type);
+
+// Called with each record of a table as it's read, JSON or .pb0 alike.
+// Returns false to stop reading.
+typedef bool (*Pb0RecordCallback)(void* ctx, uint8_t type, const Pb0Record& record);
@@ -0,0 +1,124 @@
+#include <furi.h>
+#include <storage/storage.h>
+#include <toolbox/dir_walk.h>
+
+#include "pinball0.h"
+#include "table_index.h"
+
+const char* const table_dirs[TABLE_DIR_COUNT] = {APP_ASSETS_PATH("tables"), APP_DATA_PATH("tables")};
+
+namespace {
+// Reads a string of 'len' bytes into a new FuriString
+FuriString* read_string(File* file, uint8_t len) {
+    char buf[TABLE_INDEX_STR_MAX];
+    if(len >= TABLE_INDEX_STR_MAX || storage_file_read(file, buf, len) != len) {
+        return NULL;
+    }
+    buf[len] = '\0';
+    return furi_string_alloc_set_str(buf);
+}
+}
+
+void table_index_key(Storage* storage, TableIndexKey* key) {
+    memset(key, 0, sizeof(TableIndexKey));
+    FuriString* path = furi_string_alloc();
+    for(size_t d = 0; d < TABLE_DIR_COUNT; d++) {
+        if(storage_common_timestamp(storage, table_dirs[d], &key->timestamp[d]) != FSE_OK) {
+            key->timestamp[d] = 0;
+            continue;
+        }
+        DirWalk* dir_walk = dir_walk_alloc(storage);
+        dir_walk_set_recursive(dir_walk, false);
+        if(dir_walk_open(dir_walk, table_dirs[d])) {
+            while(dir_walk_read(dir_walk, path, NULL) == DirWalkOK) {
+                key->files[d]++;
+            }
+        }
+        dir_walk_free(dir_walk);
+    }
+    furi_string_free(path);
+}
+
+bool table_index_load(PinballApp* pb, const TableIndexKey& key) {
+    auto& items = pb->table_list.menu_items;
+    File* file = storage_file_alloc(pb->storage);
+    TableIndexHeader header;
+    bool ok = storage_file_open(file, TABLE_INDEX_PATH, FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_read(file, &header, sizeof(header)) == sizeof(header) &&
+              !memcmp(header.magic, TABLE_INDEX_MAGIC, sizeof(header.magic)) &&
+              header.version == TABLE_INDEX_VERSION &&
+              !memcmp(&header.key, &key, sizeof(key));
+    for(uint16_t i = 0; ok && i < header.count; i++) {
+        TableIndexEntry entry;
+        ok = storage_file_read(file, &entry, sizeof(entry)) == sizeof(entry);
+        FuriString* filename = ok ? read_string(file, entry.path_len) : NULL;
+        FuriString* name = filename ? read_string(file, entry.name_len) : NULL;
+        // a table edited since may have been renamed inside
+        uint32_t timestamp;
+        if(name && (storage_common_timestamp(
+                        pb->storage, furi_string_get_cstr(filename), &timestamp) != FSE_OK ||
+                    timestamp != entry.timestamp)) {
+            FURI_LOG_I(TAG, "Table %s has changed", furi_string_get_cstr(filename));
+            furi_string_free(name);
+            name = NULL;
+        }
+        if(!name) {
+            if(filename) {
+                furi_string_free(filename);
+            }
+            ok = false;
+            break;
+        }
+        items.push_back({name, filename});
+    }
+    storage_file_free(file);
+
+    if(!ok) {
+        for(auto& mi : items) {
+            furi_string_free(mi.name);
+            furi_string_free(mi.filename);
+        }
+        items.clear();
+        return false;
+    }
+    FURI_LOG_I(TAG, "Table list from index: %u tables", header.count);
+    return true;
+}
+
+void table_index_save(PinballApp* pb, const TableIndexKey& key) {
+    const auto& items = pb->table_list.menu_items;
+    TableIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TABLE_INDEX_MAGIC, sizeof(header.magic));
+    header.version = TABLE_INDEX_VERSION;
+    header.count = items.size();
+    header.key = key;
+
+    File* file = storage_file_alloc(pb->storage);
+    bool ok = storage_file_open(file, TABLE_INDEX_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+              storage_file_write(file, &header, sizeof(header)) == sizeof(header);
+    for(const auto& mi : items) {
+        TableIndexEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.path_len = furi_string_size(mi.filename);
+        entry.name_len = furi_string_size(mi.name);
+        // too long to index, or gone already; the list is walked every time instead
+        if(furi_string_size(mi.filename) >= TABLE_INDEX_STR_MAX ||
+           furi_string_size(mi.name) >= TABLE_INDEX_STR_MAX ||
+           storage_common_timestamp(
+               pb->storage, furi_string_get_cstr(mi.filename), &entry.timestamp) != FSE_OK) {
+            ok = false;
+        }
+        ok = ok && storage_file_write(file, &entry, sizeof(entry)) == sizeof(entry) &&
+             storage_file_write(file, furi_string_get_cstr(mi.filename), entry.path_len) ==
+                 entry.path_len &&
+             storage_file_write(file, furi_string_get_cstr(mi.name), entry.name_len) ==
+                 entry.name_len;
+    }
+    storage_file_free(file);
+    if(!ok) {
+        // only a cache: the folders are walked again next time
+        FURI_LOG_I(TAG, "Cannot write the table index");
+        storage_common_remove(pb->storage, TABLE_INDEX_PATH);
+    }
+}
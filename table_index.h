@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <storage/storage.h>
+
+// Table list cache (.tables.idx)
+//
+// The tables found in the table folders last time, so the list can be built
+// without reading every file again. A TableIndexHeader, then 'count' entries,
+// each a TableIndexEntry followed by its path and display name (not NUL
+// terminated), in list order. Only files that read as tables get an entry,
+// and the name is the table's own "name" where it has one.
+//
+// The index is only good while the folders and their tables haven't changed.
+// Each folder's timestamp and number of files are kept in the header: FatFs
+// doesn't touch a folder's timestamp when a file in it is added or removed,
+// so the files are counted too, a bare directory read with nothing opened.
+// Each entry keeps its table file's timestamp, which is checked as the entry
+// is loaded, so a table edited in place is read again for its name.
+
+#define TABLE_INDEX_MAGIC   "PB0I"
+#define TABLE_INDEX_VERSION 4
+#define TABLE_INDEX_PATH    APP_DATA_PATH(".tables.idx")
+#define TABLE_INDEX_STR_MAX 128 // longest path or name, with its NUL
+#define TABLE_DIR_COUNT     2
+
+struct PinballApp;
+
+typedef struct {
+    uint32_t timestamp[TABLE_DIR_COUNT]; // 0 if the folder doesn't exist
+    uint16_t files[TABLE_DIR_COUNT];
+} TableIndexKey;
+
+typedef struct {
+    char magic[4]; // TABLE_INDEX_MAGIC, not NUL terminated
+    uint16_t version;
+    uint16_t count; // entries that follow
+    TableIndexKey key;
+} TableIndexHeader;
+
+// A table as listed: other files, and a .json with a .pb0 compiled from it,
+// never get this far
+typedef struct {
+    uint32_t timestamp; // of the table file
+    uint8_t path_len;
+    uint8_t name_len;
+    uint8_t reserved[2];
+} TableIndexEntry;
+
+// The folders tables are listed from, in TableIndexKey order
+extern const char* const table_dirs[TABLE_DIR_COUNT];
+
+// Reads what the index is keyed on from the table folders
+void table_index_key(Storage* storage, TableIndexKey* key);
+// Fills pb->table_list with the indexed tables, debug ones included, if the
+// index is there and matches 'key'. Returns false, leaving the list empty,
+// if it doesn't.
+bool table_index_load(PinballApp* pb, const TableIndexKey& key);
+// Saves pb->table_list, as found by walking the folders, keyed by 'key'
+void table_index_save(PinballApp* pb, const TableIndexKey& key);
@@ -3,31 +3,70 @@
 #include <toolbox/stream/stream.h>
 #include <toolbox/stream/file_stream.h>
 #include <toolbox/args.h>
+#include <algorithm>
 
-#include "nxjson/nxjson.h"
+#include "json_stream.h"
+#include "load_profile.h"
 #include "pinball0.h"
 #include "table.h"
 #include "notifications.h"
+#include "table_index.h"
 
 namespace {
 bool ON_TABLE(const Vec2& p) {
     return 0 <= p.x && p.x <= 630 && 0 <= p.y && p.y <= 1270;
 }
-};
 
-void table_table_list_init(void* ctx) {
-    PinballApp* pb = (PinballApp*)ctx;
-    // using the asset file path, read the table files, and for each one, extract their
-    // display name (oof). let's just use their filenames for now (stripping any XX_ prefix)
-    // sort tables by original filename
+// Does 'path' with its extension swapped for 'ext' exist? If so, returns that path
+FuriString* table_sibling_path(Storage* storage, const FuriString* path, const char* ext) {
+    size_t dot = furi_string_search_rchar(path, '.', 0);
+    if(dot == FURI_STRING_FAILURE) {
+        return NULL;
+    }
+    FuriString* sibling = furi_string_alloc_set_str(furi_string_get_cstr(path));
+    furi_string_left(sibling, dot);
+    furi_string_cat_str(sibling, ext);
+    if(storage_common_stat(storage, furi_string_get_cstr(sibling), NULL) != FSE_OK) {
+        furi_string_free(sibling);
+        return NULL;
+    }
+    return sibling;
+}
+
+// The filename of the table at 'path', without its extension or any XX_
+// prefix (for custom sorting)
+FuriString* table_file_title(const char* path) {
+    FuriString* title = furi_string_alloc();
+    path_extract_filename_no_ext(path, title);
+    char c = furi_string_get_char(title, 2);
+    if(c == '_') {
+        char a = furi_string_get_char(title, 0);
+        char b = furi_string_get_char(title, 1);
+        if(a >= '0' && a <= '9' && b >= '0' && b <= '9') {
+            furi_string_right(title, 3);
+        }
+    }
+    return title;
+}
+
+// Debug tables are the ones whose filename says so, whatever they're called
+bool table_is_debug(const FuriString* filename) {
+    FuriString* title = table_file_title(furi_string_get_cstr(filename));
+    bool debug = !strncmp("dbg", furi_string_get_cstr(title), 3);
+    furi_string_free(title);
+    return debug;
+}
 
-    const char* paths[] = {APP_ASSETS_PATH("tables"), APP_DATA_PATH("tables")};
+// Lists every table in the table folders, sorted by filename. Each file is
+// read through, so only tables that can be read are listed, under the name
+// they give themselves or else their filename.
+void table_list_walk(PinballApp* pb) {
     const size_t ext_len_max = 32;
     char ext[ext_len_max];
+    auto& items = pb->table_list.menu_items;
 
-    for(size_t p = 0; p < 2; p++) {
-        const char* path = paths[p];
-        // const char* asset_path = APP_ASSETS_PATH("tables");
+    for(size_t p = 0; p < TABLE_DIR_COUNT; p++) {
+        const char* path = table_dirs[p];
         FURI_LOG_I(TAG, "Loading table list from: %s", path);
 
         FuriString* table_path = furi_string_alloc();
@@ -37,70 +76,98 @@ void table_table_list_init(void* ctx) {
         if(dir_walk_open(dir_walk, path)) {
             while(dir_walk_read(dir_walk, table_path, NULL) == DirWalkOK) {
                 path_extract_extension(table_path, ext, ext_len_max);
-                if(strcmp(ext, ".json") != 0) {
+                bool compiled = !strcmp(ext, ".pb0");
+                if(!compiled && strcmp(ext, ".json") != 0) {
                     FURI_LOG_W(
-                        TAG, "Skipping non-json file: %s", furi_string_get_cstr(table_path));
+                        TAG, "Skipping non-table file: %s", furi_string_get_cstr(table_path));
                     continue;
                 }
-                const char* cpath = furi_string_get_cstr(table_path);
-
-                FuriString* filename_no_ext = furi_string_alloc();
-                path_extract_filename_no_ext(cpath, filename_no_ext);
-
-                // If filename starts with XX_ (for custom sorting) strip the prefix
-                char c = furi_string_get_char(filename_no_ext, 2);
-                if(c == '_') {
-                    char a = furi_string_get_char(filename_no_ext, 0);
-                    char b = furi_string_get_char(filename_no_ext, 1);
-                    if(a >= '0' && a <= '9' && b >= '0' && b <= '9') {
-                        furi_string_right(filename_no_ext, 3);
+                // A .pb0 compiled from a .json next to it is listed in the .json's
+                // place, so it's loaded instead but only listed once
+                FuriString* sibling =
+                    table_sibling_path(pb->storage, table_path, compiled ? ".json" : ".pb0");
+                if(sibling) {
+                    if(!compiled) {
+                        furi_string_set_str(table_path, furi_string_get_cstr(sibling));
+                    }
+                    furi_string_free(sibling);
+                    if(compiled) {
+                        continue;
                     }
                 }
+                const char* cpath = furi_string_get_cstr(table_path);
 
-                if(!pb->settings.debug_mode &&
-                   !strncmp("dbg", furi_string_get_cstr(filename_no_ext), 3)) {
-                    furi_string_free(filename_no_ext);
+                char table_name[PB0_NAME_MAX];
+                if(!table_read_name(pb->storage, cpath, table_name)) {
+                    FURI_LOG_W(TAG, "Skipping unreadable table: %s", cpath);
                     continue;
                 }
+                FuriString* name = table_name[0] ? furi_string_alloc_set_str(table_name) :
+                                                   table_file_title(cpath);
 
                 FURI_LOG_I(
-                    TAG,
-                    "Found table: name=%s | path=%s",
-                    furi_string_get_cstr(filename_no_ext),
-                    furi_string_get_cstr(table_path));
+                    TAG, "Found table: name=%s | path=%s", furi_string_get_cstr(name), cpath);
 
                 // set display 'name' and 'filename'
                 TableList::TableMenuItem tmi;
                 tmi.filename = furi_string_alloc_set_str(cpath);
-                tmi.name = filename_no_ext;
-
-                // Insert in sorted order
-                size_t i = 0;
-                auto it = pb->table_list.menu_items.begin();
-                for(; it != pb->table_list.menu_items.end(); it++, i++) {
-                    if(strcmp(
-                           furi_string_get_cstr(tmi.filename),
-                           furi_string_get_cstr(it->filename)) > 0) {
-                        continue;
-                    }
-                    pb->table_list.menu_items.insert(it, tmi);
-                    break;
-                }
-                if(pb->table_list.menu_items.size() == i) {
-                    pb->table_list.menu_items.push_back(tmi);
-                }
+                tmi.name = name;
+                items.push_back(tmi);
             }
         }
         furi_string_free(table_path);
         dir_walk_free(dir_walk);
     }
 
+    // sort tables by original filename
+    std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+        return strcmp(furi_string_get_cstr(a.filename), furi_string_get_cstr(b.filename)) < 0;
+    });
+}
+}
+
+void table_table_list_init(void* ctx) {
+    PinballApp* pb = (PinballApp*)ctx;
+    auto& items = pb->table_list.menu_items;
+
+    // the folders are only walked when they've changed since the index was saved
+    TableIndexKey key;
+    table_index_key(pb->storage, &key);
+    if(!table_index_load(pb, key)) {
+        table_list_walk(pb);
+        table_index_save(pb, key);
+    }
+
+    if(!pb->settings.debug_mode) {
+        auto it = items.begin();
+        while(it != items.end()) {
+            if(table_is_debug(it->filename)) {
+                furi_string_free(it->name);
+                furi_string_free(it->filename);
+                it = items.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // In debug mode, 'Replay' plays back the last game recorded
+    if(pb->settings.debug_mode) {
+        TableList::TableMenuItem replay;
+        replay.filename = furi_string_alloc_set_str(REPLAY_MENU_FILENAME);
+        replay.name = furi_string_alloc_set_str("REPLAY");
+        pb->table_list.menu_items.push_back(replay);
+    }
+
     // Add 'Settings' as last element
     TableList::TableMenuItem settings;
     settings.filename = furi_string_alloc_set_str("99_Settings");
     settings.name = furi_string_alloc_set_str("SETTINGS");
     pb->table_list.menu_items.push_back(settings);
 
+    // 'Continue' goes on top, when there's a saved game
+    resume_list_update(pb);
+
     FURI_LOG_I(TAG, "Found %d tables", pb->table_list.menu_items.size());
     for(auto& tmi : pb->table_list.menu_items) {
         FURI_LOG_I(TAG, "%s", furi_string_get_cstr(tmi.name));
@@ -109,519 +176,513 @@ void table_table_list_init(void* ctx) {
     pb->table_list.selected = 0;
 }
 
-// json parse helper function
-bool table_file_parse_vec2(const nx_json* json, const char* key, Vec2& v) {
-    const nx_json* item = nx_json_get(json, key);
-    if(!item || item->children.length != 2) {
-        return false;
-    }
-    v.x = nx_json_item(item, 0)->num.dbl_value;
-    v.y = nx_json_item(item, 1)->num.dbl_value;
-    return true;
-}
+namespace {
 
-bool table_file_parse_int(const nx_json* json, const char* key, int& v) {
-    const nx_json* item = nx_json_get(json, key);
-    if(!item) return false;
-    v = item->num.u_value;
-    return true;
-}
+// Which top-level member of the table the parser is in
+typedef enum {
+    SectionNone,
+    // single objects
+    SectionLives,
+    SectionScore,
+    SectionPlunger,
+    // lists of objects
+    SectionBalls,
+    SectionFlippers,
+    SectionBumpers,
+    SectionArcs,
+    SectionRails,
+    SectionPortals,
+    SectionRollovers,
+    SectionTurbos,
+} TableSection;
+
+typedef struct {
+    const char* key; // in the table file
+    const char* name; // for log messages
+    uint8_t type; // Pb0RecordType, 0 for none
+} TableSectionInfo;
+
+const TableSectionInfo table_sections[] = {
+    {"", "", 0},
+    {"lives", "Lives", 0},
+    {"score", "Score", 0},
+    {"plunger", "Plunger", Pb0Plunger},
+    {"balls", "Ball", Pb0Ball},
+    {"flippers", "Flipper", Pb0Flipper},
+    {"bumpers", "Bumper", Pb0Bumper},
+    {"arcs", "Arc", Pb0Arc},
+    {"rails", "Rail", Pb0Rail},
+    {"portals", "Portal", Pb0Portal},
+    {"rollovers", "Rollover", Pb0Rollover},
+    {"turbos", "Turbo", Pb0Turbo},
+};
 
-bool table_file_parse_bool(const nx_json* json, const char* key, bool& v) {
-    int value = v == true ? 1 : 0; // set default value
-    if(table_file_parse_int(json, key, value)) {
-        v = value > 0 ? true : false;
-        return true;
+// Every [x, y] member of any table object; a TableVecs bit per entry
+const char* const table_vec_keys[] = {
+    "position", "velocity", "start", "end", "a_start", "a_end", "b_start", "b_end"};
+typedef enum {
+    VecPosition = 1 << 0,
+    VecVelocity = 1 << 1,
+    VecStart = 1 << 2,
+    VecEnd = 1 << 3,
+    VecAStart = 1 << 4,
+    VecAEnd = 1 << 5,
+    VecBStart = 1 << 6,
+    VecBEnd = 1 << 7,
+} TableVecs;
+
+#define TABLE_KEY_MAX   16 // longest member name we care about, plus NUL
+#define TABLE_KEY_DEPTH 5 // deepest member we care about: balls[i].position[j]
+
+// Builds records from a table file's JSON as the parser streams through it.
+// Each object is passed on as soon as its closing brace is read.
+//
+// Values are read the way the nxjson loader did: integers where it used
+// table_file_parse_int() (so 40.5 is 40), and anything non-zero is true.
+class TableJsonListener : public JsonListener {
+public:
+    TableJsonListener(Pb0Header* header_, Pb0RecordCallback cb_, void* ctx_)
+        : header(header_)
+        , cb(cb_)
+        , ctx(ctx_)
+        , depth(0)
+        , section(SectionNone)
+        , in_item(false)
+        , vec(0)
+        , vec_count(0)
+        , in_signal(false)
+        , have(0) {
+        pb0_header_init(header);
     }
-    return false;
-}
 
-bool table_file_parse_float(const nx_json* json, const char* key, float& v) {
-    const nx_json* item = nx_json_get(json, key);
-    if(!item) return false;
-    v = item->num.dbl_value;
-    return true;
-}
-
-void table_file_parse_signal(const nx_json* json, Table* table, FixedObject* obj) {
-    const nx_json* signal = nx_json_get(json, "signal");
-    if(signal) {
-        int tx = INVALID_ID;
-        int rx = INVALID_ID;
-        if(table_file_parse_int(signal, "tx", tx) && tx != INVALID_ID) {
-            obj->tx_id = tx;
-            table->sm.register_signal(tx, obj);
+    bool begin(bool array) override {
+        depth++;
+        const char* k = key_at(depth - 1);
+        if(depth == 2) {
+            section = SectionNone;
+            for(size_t i = 1; i < COUNT_OF(table_sections); i++) {
+                if(!strcmp(k, table_sections[i].key)) {
+                    section = (TableSection)i;
+                }
+            }
+            // single objects are the item, lists hold them
+            if(!array && section > SectionNone && section < SectionBalls) {
+                begin_item();
+            }
+        } else if(depth == 3 && !array && section >= SectionBalls) {
+            begin_item();
+        } else if(in_item && depth == item_depth() + 1) {
+            vec = array ? vec_bit(k) : 0;
+            vec_count = 0;
+            in_signal = !array && !strcmp(k, "signal");
         }
-        if(table_file_parse_int(signal, "rx", rx) && rx != INVALID_ID) {
-            obj->rx_id = rx;
-            table->sm.register_slot(rx, obj);
+        return true;
+    }
+
+    bool end(bool array) override {
+        bool ok = true;
+        if(in_item && depth == item_depth() + 1) {
+            if(vec && vec_count == 2) {
+                *vec_field(vec) = vec_value;
+                have |= vec;
+            }
+            vec = 0;
+            in_signal = false;
+        } else if(in_item && depth == item_depth()) {
+            in_item = false;
+            ok = end_item();
         }
-        bool any = false;
-        table_file_parse_bool(signal, "any", any);
-        obj->tx_type = any ? SignalType::ANY : SignalType::ALL;
+        depth--;
+        return ok;
     }
-}
 
-Table* table_load_table_from_file(PinballApp* pb, size_t index) {
-    auto& tmi = pb->table_list.menu_items[index];
+    bool key(const char* k) override {
+        if(depth < TABLE_KEY_DEPTH) {
+            strncpy(keys[depth], k, TABLE_KEY_MAX - 1);
+            keys[depth][TABLE_KEY_MAX - 1] = 0;
+        }
+        return true;
+    }
 
-    FURI_LOG_I(TAG, "Reading file: %s", furi_string_get_cstr(tmi.filename));
+    bool value(const JsonValue& v) override {
+        if(depth == 1) {
+            return table_value(key_at(1), v);
+        } else if(in_item && depth == item_depth()) {
+            item_value(key_at(depth), v);
+        } else if(in_item && depth == item_depth() + 1) {
+            if(vec) {
+                if(vec_count < 2) {
+                    (vec_count == 0 ? vec_value.x : vec_value.y) = as_float(v);
+                }
+                vec_count++;
+            } else if(in_signal) {
+                signal_value(key_at(depth), v);
+            }
+        }
+        return true;
+    }
 
-    File* file = storage_file_alloc(pb->storage);
-    FileInfo fileinfo;
-    FS_Error error =
-        storage_common_stat(pb->storage, furi_string_get_cstr(tmi.filename), &fileinfo);
-    if(error != FSE_OK) {
-        FURI_LOG_E(TAG, "Could not find file");
-        storage_file_free(file);
-        return NULL;
+private:
+    Pb0Header* header;
+    Pb0RecordCallback cb;
+    void* ctx;
+
+    int depth; // containers open
+    char keys[TABLE_KEY_DEPTH][TABLE_KEY_MAX]; // member name at each depth
+    TableSection section;
+
+    // the object being read
+    bool in_item;
+    Pb0Record rec;
+    uint8_t vec; // TableVecs bit of the [x, y] being read
+    uint8_t vec_count;
+    Pb0Vec2 vec_value;
+    bool in_signal;
+    uint8_t have; // TableVecs read so far
+
+    const char* key_at(int d) const {
+        return d > 0 && d < TABLE_KEY_DEPTH ? keys[d] : "";
     }
-    // TODO: determine an appropriate max file size and make configurable
-    FURI_LOG_I(TAG, "Found file ok!");
-    if(fileinfo.size >= 8192) {
-        FURI_LOG_E(TAG, "Table file size too big");
-        snprintf(pb->text, 256, "Table file\nis too big!\n> 8192 bytes");
-        storage_file_free(file);
-        return NULL;
+    // depth of an item's members
+    int item_depth() const {
+        return section >= SectionBalls ? 3 : 2;
     }
-    bool ok =
-        storage_file_open(file, furi_string_get_cstr(tmi.filename), FSAM_READ, FSOM_OPEN_EXISTING);
-    if(!ok) {
-        FURI_LOG_E(TAG, "Failed to open table file: %s", furi_string_get_cstr(tmi.filename));
-        snprintf(pb->text, 256, "Failed\nto open\nfile!");
-        storage_file_free(file);
-        return NULL;
+    static int32_t as_int(const JsonValue& v) {
+        return v.type == JsonString ? 0 : v.i;
     }
-
-    // read the file as a string
-    uint8_t* buffer;
-    uint64_t file_size = storage_file_size(file);
-    if(file_size > 8192) { // TODO - what's the right size?
-        FURI_LOG_E(TAG, "Table file is too large! (> 8192 bytes)");
-        snprintf(pb->text, 256, "Table file\nis too big!\n> 8192 bytes");
-        storage_file_free(file);
-        return NULL;
+    static float as_float(const JsonValue& v) {
+        return v.type == JsonNumber ? v.f : 0;
     }
-    buffer = (uint8_t*)malloc(file_size);
-    size_t read_count = storage_file_read(file, buffer, file_size);
-    // if(storage_file_get_error(file) != FSE_OK) {
-    //     FURI_LOG_E(TAG, "Um, couldn't read file");
-    //     storage_file_free(file);
-    //     return NULL;
-    // }
-    storage_file_free(file);
-
-    if(read_count != file_size) {
-        FURI_LOG_E(TAG, "Error reading file. expected %lld, got %d", file_size, read_count);
-        free(buffer);
-        return NULL;
+    static uint8_t vec_bit(const char* k) {
+        for(size_t i = 0; i < COUNT_OF(table_vec_keys); i++) {
+            if(!strcmp(k, table_vec_keys[i])) {
+                return 1 << i;
+            }
+        }
+        return 0;
     }
-    FURI_LOG_I(TAG, "Read file into buffer! %d bytes", read_count);
-
-    // let's parse this shit
-    char* json_buffer = (char*)malloc(read_count * sizeof(char) + 1);
-    for(uint16_t i = 0; i < read_count; i++) {
-        json_buffer[i] = buffer[i];
+    static void init_signal(Pb0Signal& sig) {
+        sig.tx = INVALID_ID;
+        sig.rx = INVALID_ID;
+        sig.any = 0;
     }
-    json_buffer[read_count] = 0;
-    free(buffer);
 
-    const nx_json* json = nx_json_parse(json_buffer, 0);
-
-    if(!json) {
-        FURI_LOG_E(TAG, "Failed to parse table json!");
-        snprintf(pb->text, 256, "Failed to\nparse table\njson!!");
-        free(json_buffer);
-        return NULL;
+    // Where the [x, y] goes in the current item, or 'scratch' if it's not ours
+    Pb0Vec2* vec_field(uint8_t bit) {
+        static Pb0Vec2 scratch;
+        switch(section) {
+        case SectionLives:
+            return bit == VecPosition ? &header->lives_pos : &scratch;
+        case SectionScore:
+            return bit == VecPosition ? &header->score_pos : &scratch;
+        case SectionPlunger:
+            return bit == VecPosition ? &rec.plunger.p : &scratch;
+        case SectionBalls:
+            return bit == VecPosition ? &rec.ball.p : bit == VecVelocity ? &rec.ball.v : &scratch;
+        case SectionFlippers:
+            return bit == VecPosition ? &rec.flipper.p : &scratch;
+        case SectionBumpers:
+            return bit == VecPosition ? &rec.bumper.p : &scratch;
+        case SectionArcs:
+            return bit == VecPosition ? &rec.arc.p : &scratch;
+        case SectionRails:
+            return bit == VecStart ? &rec.rail.start : bit == VecEnd ? &rec.rail.end : &scratch;
+        case SectionPortals:
+            return bit == VecAStart ? &rec.portal.a1 :
+                   bit == VecAEnd   ? &rec.portal.a2 :
+                   bit == VecBStart ? &rec.portal.b1 :
+                   bit == VecBEnd   ? &rec.portal.b2 :
+                                      &scratch;
+        case SectionRollovers:
+            return bit == VecPosition ? &rec.rollover.p : &scratch;
+        case SectionTurbos:
+            return bit == VecPosition ? &rec.turbo.p : &scratch;
+        default:
+            return &scratch;
+        }
     }
 
-    Table* table = new Table();
-
-    do {
-        const nx_json* lives = nx_json_get(json, "lives");
-        if(lives) {
-            table_file_parse_int(lives, "value", table->lives.value);
-            table_file_parse_bool(lives, "display", table->lives.display);
-            table_file_parse_vec2(lives, "position", table->lives.p);
-            const nx_json* align = nx_json_get(lives, "align");
-            if(align && !strcmp(align->text_value, "VERTICAL")) {
-                table->lives.alignment = Lives::Vertical;
-            }
+    // [x, y] members an item can't do without
+    uint8_t required() const {
+        switch(section) {
+        case SectionLives:
+        case SectionScore:
+        case SectionPlunger:
+            return 0;
+        case SectionRails:
+            return VecStart | VecEnd;
+        case SectionPortals:
+            return VecAStart | VecAEnd | VecBStart | VecBEnd;
+        default:
+            return VecPosition;
         }
-        const nx_json* tilt = nx_json_get(json, "tilt_detect");
-        if(tilt) {
-            table->tilt_detect_enabled = tilt->num.u_value > 0 ? true : false;
-        }
-        const nx_json* score = nx_json_get(json, "score");
-        if(score) {
-            table_file_parse_bool(score, "display", table->score.display);
-            table_file_parse_vec2(score, "position", table->score.p);
-        }
-
-        const nx_json* balls = nx_json_get(json, "balls");
-        if(balls) {
-            for(int i = 0; i < balls->children.length; i++) {
-                const nx_json* ball = nx_json_item(balls, i);
-                if(!ball) continue;
-
-                Vec2 p;
-                if(!table_file_parse_vec2(ball, "position", p)) {
-                    FURI_LOG_E(TAG, "Ball missing \"position\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(p)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Ball with position %.1f,%.1f is not on table!",
-                        (double)p.x,
-                        (double)p.y);
-                }
-
-                Ball new_ball(p);
-                table_file_parse_float(ball, "radius", new_ball.r);
-
-                Vec2 v = (Vec2){0, 0};
-                table_file_parse_vec2(ball, "velocity", v);
-                new_ball.accelerate(v);
+    }
 
-                table->balls_initial.push_back(new_ball);
-                table->balls.push_back(new_ball);
-            }
-        }
-        if(table->balls.size() == 0) {
-            FURI_LOG_E(TAG, "Table has NO BALLS");
-            snprintf(pb->text, 256, "No balls\nfound in\ntable file!");
-            delete table;
-            table = NULL;
-            break;
+    bool table_value(const char* k, const JsonValue& v) {
+        if(!strcmp(k, "lives") && v.type == JsonNumber && v.integer) {
+            header->lives = v.i; // shorthand: "lives": N
+        } else if(!strcmp(k, "tilt_detect") && v.type != JsonString) {
+            header->tilt_detect = v.i != 0;
+        } else if(!strcmp(k, "name") && v.type == JsonString) {
+            Pb0Record name;
+            memset(&name, 0, sizeof(name));
+            strncpy(name.name.name, v.str, PB0_NAME_MAX - 1);
+            return cb(ctx, Pb0Name, name);
         }
+        return true;
+    }
 
-        // TODO: plungers need work
-        const nx_json* plunger = nx_json_get(json, "plunger");
-        if(plunger) {
-            Vec2 p;
-            table_file_parse_vec2(plunger, "position", p);
-            int s = 100;
-            table_file_parse_int(plunger, "size", s);
-            table->plunger = new Plunger(p);
-        } else {
-            FURI_LOG_W(
-                TAG, "Table has NO PLUNGER - s'ok, we don't really support one anyway (yet)");
+    void begin_item() {
+        in_item = true;
+        have = 0;
+        vec = 0;
+        in_signal = false;
+        memset(&rec, 0, sizeof(rec));
+        switch(section) {
+        case SectionPlunger:
+            rec.plunger.size = 100;
+            break;
+        case SectionBalls:
+            rec.ball.r = DEF_BALL_RADIUS;
+            break;
+        case SectionFlippers:
+            rec.flipper.side = Flipper::LEFT;
+            rec.flipper.size = DEF_FLIPPER_SIZE;
+            break;
+        case SectionBumpers:
+            rec.bumper.r = DEF_BUMPER_RADIUS;
+            rec.bumper.bounce = DEF_BUMPER_BOUNCE;
+            rec.bumper.physical = 1;
+            init_signal(rec.bumper.signal);
+            break;
+        case SectionArcs:
+            rec.arc.r = DEF_BUMPER_RADIUS;
+            rec.arc.bounce = 0.95f; // DEF_BUMPER_BOUNCE?
+            rec.arc.surface = Arc::OUTSIDE;
+            break;
+        case SectionRails:
+            rec.rail.bounce = DEF_RAIL_BOUNCE;
+            break;
+        case SectionRollovers:
+            rec.rollover.symbol = '*';
+            init_signal(rec.rollover.signal);
+            break;
+        case SectionTurbos:
+            rec.turbo.boost = DEF_TURBO_BOOST;
+            rec.turbo.r = DEF_TURBO_RADIUS;
+            break;
+        default:
+            break;
         }
+    }
 
-        const nx_json* flippers = nx_json_get(json, "flippers");
-        if(flippers) {
-            for(int i = 0; i < flippers->children.length; i++) {
-                const nx_json* flipper = nx_json_item(flippers, i);
-
-                Vec2 p;
-                if(!table_file_parse_vec2(flipper, "position", p)) {
-                    FURI_LOG_E(TAG, "Flipper missing \"position\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(p)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Flipper with position %.1f,%.1f is not on table!",
-                        (double)p.x,
-                        (double)p.y);
-                }
-
-                const nx_json* side = nx_json_get(flipper, "side");
-                Flipper::Side sd = Flipper::LEFT;
-                if(side && !strcmp(side->text_value, "RIGHT")) {
-                    sd = Flipper::RIGHT;
-                }
-
-                int sz = DEF_FLIPPER_SIZE;
-                table_file_parse_int(flipper, "size", sz);
-                Flipper flip(p, sd, sz);
-                // flip.notification = &notify_flipper;
-                table->flippers.push_back(flip);
+    void item_value(const char* k, const JsonValue& v) {
+        bool str = v.type == JsonString;
+        switch(section) {
+        case SectionLives:
+            if(!strcmp(k, "value")) {
+                header->lives = as_int(v);
+            } else if(!strcmp(k, "display")) {
+                header->lives_display = as_int(v) > 0;
+            } else if(!strcmp(k, "align")) {
+                header->lives_vertical = str && !strcmp(v.str, "VERTICAL");
             }
-        }
-
-        const nx_json* bumpers = nx_json_get(json, "bumpers");
-        if(bumpers) {
-            for(int i = 0; i < bumpers->children.length; i++) {
-                const nx_json* bumper = nx_json_item(bumpers, i);
-
-                Vec2 p;
-                if(!table_file_parse_vec2(bumper, "position", p)) {
-                    FURI_LOG_E(TAG, "Bumper missing \"position\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(p)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Bumper with position %.1f,%.1f is not on table!",
-                        (double)p.x,
-                        (double)p.y);
-                }
-
-                int r = DEF_BUMPER_RADIUS;
-                table_file_parse_int(bumper, "radius", r);
-
-                float bnc = DEF_BUMPER_BOUNCE;
-                table_file_parse_float(bumper, "bounce", bnc);
-
-                bool physical = true;
-                table_file_parse_bool(bumper, "physical", physical);
-
-                bool hidden = false;
-                table_file_parse_bool(bumper, "hidden", hidden);
-
-                Bumper* new_bumper = new Bumper(p, r);
-                new_bumper->bounce = bnc;
-                new_bumper->notification = notify_bumper_hit;
-                new_bumper->physical = physical;
-                new_bumper->hidden = hidden;
-
-                table_file_parse_signal(bumper, table, new_bumper);
-
-                table->objects.push_back(new_bumper);
+            break;
+        case SectionScore:
+            if(!strcmp(k, "display")) {
+                header->score_display = as_int(v) > 0;
             }
-        }
-
-        constexpr float pi_180 = M_PI / 180;
-        const nx_json* arcs = nx_json_get(json, "arcs");
-        if(arcs) {
-            for(int i = 0; i < arcs->children.length; i++) {
-                const nx_json* arc = nx_json_item(arcs, i);
-
-                Vec2 p;
-                if(!table_file_parse_vec2(arc, "position", p)) {
-                    FURI_LOG_E(TAG, "Arc missing \"position\"");
-                    continue;
-                }
-                if(!ON_TABLE(p)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Arc with position %.1f,%.1f is not on table!",
-                        (double)p.x,
-                        (double)p.y);
-                }
-
-                int r = DEF_BUMPER_RADIUS;
-                table_file_parse_int(arc, "radius", r);
-
-                float bnc = 0.95f; // DEF_BUMPER_BOUNCE?
-                table_file_parse_float(arc, "bounce", bnc);
-
-                float start_angle = 0.0;
-                table_file_parse_float(arc, "start_angle", start_angle);
-                start_angle *= pi_180;
-                float end_angle = 0.0;
-                table_file_parse_float(arc, "end_angle", end_angle);
-                end_angle *= pi_180;
-
-                Arc::Surface surface = Arc::OUTSIDE;
-                const nx_json* stype = nx_json_get(arc, "surface");
-                if(stype && !strcmp(stype->text_value, "INSIDE")) {
-                    surface = Arc::INSIDE;
-                }
-
-                Arc* new_bumper = new Arc(p, r, start_angle, end_angle, surface);
-                new_bumper->bounce = bnc;
-                table->objects.push_back(new_bumper);
+            break;
+        case SectionPlunger:
+            if(!strcmp(k, "size")) {
+                rec.plunger.size = as_int(v);
             }
-        }
-
-        const nx_json* rails = nx_json_get(json, "rails");
-        if(rails) {
-            for(int i = 0; i < rails->children.length; i++) {
-                const nx_json* rail = nx_json_item(rails, i);
-
-                Vec2 s;
-                if(!table_file_parse_vec2(rail, "start", s)) {
-                    FURI_LOG_E(TAG, "Rail missing \"start\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(s)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Rail with starting position %.1f,%.1f is not on table!",
-                        (double)s.x,
-                        (double)s.y);
-                }
-                Vec2 e;
-                if(!table_file_parse_vec2(rail, "end", e)) {
-                    FURI_LOG_E(TAG, "Rail missing \"end\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(e)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Rail with ending position %.1f,%.1f is not on table!",
-                        (double)e.x,
-                        (double)e.y);
-                }
-
-                Polygon* new_rail = new Polygon();
-                new_rail->add_point(s);
-                new_rail->add_point(e);
-
-                float bnc = DEF_RAIL_BOUNCE;
-                table_file_parse_float(rail, "bounce", bnc);
-                new_rail->bounce = bnc;
-
-                int double_sided = 0;
-                table_file_parse_int(rail, "double_sided", double_sided);
-
-                new_rail->finalize();
-                new_rail->notification = &notify_rail_hit;
-                table->objects.push_back(new_rail);
-
-                if(double_sided) {
-                    new_rail = new Polygon();
-                    new_rail->add_point(e);
-                    new_rail->add_point(s);
-                    new_rail->bounce = bnc;
-                    new_rail->finalize();
-                    new_rail->notification = &notify_rail_hit;
-                    table->objects.push_back(new_rail);
-                }
+            break;
+        case SectionBalls:
+            if(!strcmp(k, "radius")) {
+                rec.ball.r = as_float(v);
+            }
+            break;
+        case SectionFlippers:
+            if(!strcmp(k, "side")) {
+                rec.flipper.side = str && !strcmp(v.str, "RIGHT") ? Flipper::RIGHT : Flipper::LEFT;
+            } else if(!strcmp(k, "size")) {
+                rec.flipper.size = as_int(v);
+            }
+            break;
+        case SectionBumpers:
+            if(!strcmp(k, "radius")) {
+                rec.bumper.r = as_int(v);
+            } else if(!strcmp(k, "bounce")) {
+                rec.bumper.bounce = as_float(v);
+            } else if(!strcmp(k, "physical")) {
+                rec.bumper.physical = as_int(v) > 0;
+            } else if(!strcmp(k, "hidden")) {
+                rec.bumper.hidden = as_int(v) > 0;
             }
+            break;
+        case SectionArcs:
+            if(!strcmp(k, "radius")) {
+                rec.arc.r = as_int(v);
+            } else if(!strcmp(k, "bounce")) {
+                rec.arc.bounce = as_float(v);
+            } else if(!strcmp(k, "start_angle")) {
+                rec.arc.start = as_float(v);
+            } else if(!strcmp(k, "end_angle")) {
+                rec.arc.end = as_float(v);
+            } else if(!strcmp(k, "surface")) {
+                rec.arc.surface = str && !strcmp(v.str, "INSIDE") ? Arc::INSIDE : Arc::OUTSIDE;
+            }
+            break;
+        case SectionRails:
+            if(!strcmp(k, "bounce")) {
+                rec.rail.bounce = as_float(v);
+            } else if(!strcmp(k, "double_sided")) {
+                rec.rail.double_sided = as_int(v) != 0;
+            }
+            break;
+        case SectionRollovers:
+            if(!strcmp(k, "symbol") && str) {
+                rec.rollover.symbol = v.str[0];
+            }
+            break;
+        case SectionTurbos:
+            if(!strcmp(k, "angle")) {
+                rec.turbo.angle = as_float(v);
+            } else if(!strcmp(k, "boost")) {
+                rec.turbo.boost = as_float(v);
+            } else if(!strcmp(k, "radius")) {
+                rec.turbo.r = as_float(v);
+            }
+            break;
+        default:
+            break;
         }
+    }
 
-        const nx_json* portals = nx_json_get(json, "portals");
-        if(portals) {
-            for(int i = 0; i < portals->children.length; i++) {
-                const nx_json* portal = nx_json_item(portals, i);
-
-                Vec2 a1;
-                if(!table_file_parse_vec2(portal, "a_start", a1)) {
-                    FURI_LOG_E(TAG, "Portal missing \"a_start\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(a1)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Portal A with starting position %.1f,%.1f is not on table!",
-                        (double)a1.x,
-                        (double)a1.y);
-                }
-                Vec2 a2;
-                if(!table_file_parse_vec2(portal, "a_end", a2)) {
-                    FURI_LOG_E(TAG, "Portal missing \"a_end\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(a2)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Portal A with ending position %.1f,%.1f is not on table!",
-                        (double)a2.x,
-                        (double)a2.y);
-                }
-                Vec2 b1;
-                if(!table_file_parse_vec2(portal, "b_start", b1)) {
-                    FURI_LOG_E(TAG, "Portal missing \"b_start\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(b1)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Portal B with starting position %.1f,%.1f is not on table!",
-                        (double)b1.x,
-                        (double)b1.y);
-                }
-                Vec2 b2;
-                if(!table_file_parse_vec2(portal, "b_end", b2)) {
-                    FURI_LOG_E(TAG, "Portal missing \"b_end\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(b2)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Portal B with ending position %.1f,%.1f is not on table!",
-                        (double)b2.x,
-                        (double)b2.y);
-                }
+    void signal_value(const char* k, const JsonValue& v) {
+        Pb0Signal* sig = section == SectionBumpers   ? &rec.bumper.signal :
+                         section == SectionRollovers ? &rec.rollover.signal :
+                                                       nullptr;
+        if(!sig) {
+            return;
+        }
+        if(!strcmp(k, "tx")) {
+            sig->tx = as_int(v);
+        } else if(!strcmp(k, "rx")) {
+            sig->rx = as_int(v);
+        } else if(!strcmp(k, "any")) {
+            sig->any = as_int(v) > 0;
+        }
+    }
 
-                Portal* new_portal = new Portal(a1, a2, b1, b2);
-                new_portal->finalize();
-                new_portal->notification = &notify_portal;
-                table->objects.push_back(new_portal);
+    bool end_item() {
+        const TableSectionInfo& info = table_sections[section];
+        uint8_t need = required();
+        for(size_t i = 0; i < COUNT_OF(table_vec_keys); i++) {
+            uint8_t bit = 1 << i;
+            if(!(need & bit)) {
+                continue;
+            }
+            if(!(have & bit)) {
+                FURI_LOG_E(TAG, "%s missing \"%s\", skipping", info.name, table_vec_keys[i]);
+                return true;
+            }
+            const Pb0Vec2& p = *vec_field(bit);
+            if(!ON_TABLE(Vec2(p.x, p.y))) {
+                FURI_LOG_W(
+                    TAG,
+                    "%s with %s %.1f,%.1f is not on table!",
+                    info.name,
+                    table_vec_keys[i],
+                    (double)p.x,
+                    (double)p.y);
             }
         }
 
-        const nx_json* rollovers = nx_json_get(json, "rollovers");
-        if(rollovers) {
-            for(int i = 0; i < rollovers->children.length; i++) {
-                const nx_json* rollover = nx_json_item(rollovers, i);
-
-                Vec2 p;
-                if(!table_file_parse_vec2(rollover, "position", p)) {
-                    FURI_LOG_E(TAG, "Rollover missing \"position\", skipping");
-                    continue;
-                }
-                if(!ON_TABLE(p)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Rollover with position %.1f,%.1f is not on table!",
-                        (double)p.x,
-                        (double)p.y);
-                }
-                char sym = '*';
-                const nx_json* symbol = nx_json_get(rollover, "symbol");
-                if(symbol) {
-                    sym = symbol->text_value[0];
-                }
-                Rollover* new_rollover = new Rollover(p, sym);
-
-                table_file_parse_signal(rollover, table, new_rollover);
-
-                table->objects.push_back(new_rollover);
-            }
+        constexpr float pi_180 = M_PI / 180;
+        if(section == SectionArcs) {
+            rec.arc.start *= pi_180;
+            rec.arc.end *= pi_180;
+        } else if(section == SectionTurbos) {
+            rec.turbo.angle *= pi_180;
         }
+        return info.type ? cb(ctx, info.type, rec) : true;
+    }
+};
 
-        const nx_json* turbos = nx_json_get(json, "turbos");
-        if(turbos) {
-            for(int i = 0; i < turbos->children.length; i++) {
-                const nx_json* turbo = nx_json_item(turbos, i);
+size_t table_file_read(void* ctx, char* buf, size_t size) {
+    LoadPhaseScope scope(LoadPhaseRead);
+    return storage_file_read((File*)ctx, buf, size);
+}
 
-                Vec2 p;
-                if(!table_file_parse_vec2(turbo, "position", p)) {
-                    FURI_LOG_E(TAG, "Turbo missing \"position\"");
-                    continue;
-                }
-                if(!ON_TABLE(p)) {
-                    FURI_LOG_W(
-                        TAG,
-                        "Turbo with position %.1f,%.1f is not on table!",
-                        (double)p.x,
-                        (double)p.y);
-                }
-                float angle = 0;
-                table_file_parse_float(turbo, "angle", angle);
-                angle *= pi_180;
+Table* table_load_table_from_json(PinballApp* pb, const char* path) {
+    FURI_LOG_I(TAG, "Reading file: %s", path);
 
-                float boost = DEF_TURBO_BOOST;
-                table_file_parse_float(turbo, "boost", boost);
+    File* file = storage_file_alloc(pb->storage);
+    bool ok;
+    {
+        LoadPhaseScope scope(LoadPhaseRead);
+        ok = storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING);
+    }
+    if(!ok) {
+        FURI_LOG_E(TAG, "Failed to open table file: %s", path);
+        snprintf(pb->text, 256, "Failed\nto open\nfile!");
+        storage_file_free(file);
+        return NULL;
+    }
 
-                float radius = DEF_TURBO_RADIUS;
-                table_file_parse_float(turbo, "radius", radius);
+    // a first pass counts the records, to size the table's arena
+    Pb0Header header;
+    size_t arena_size = 0;
+    ok = table_json_read(table_file_read, file, &header, table_size_record, &arena_size);
+    {
+        LoadPhaseScope scope(LoadPhaseRead);
+        ok = ok && storage_file_seek(file, 0, true);
+    }
 
-                Turbo* new_turbo = new Turbo(p, angle, boost, radius);
+    // objects are added to the table as the parser reaches the end of each one
+    Table* table;
+    {
+        LoadPhaseScope scope(LoadPhaseBuild);
+        table = table_alloc(arena_size);
+    }
+    ok = ok && table_json_read(table_file_read, file, &header, table_add_record, table);
+    storage_file_free(file);
 
-                table->objects.push_back(new_turbo);
-            }
-        }
+    if(!ok) {
+        FURI_LOG_E(TAG, "Failed to parse table json!");
+        snprintf(pb->text, 256, "Failed to\nparse table\njson!!");
+        delete table;
+        return NULL;
+    }
+    table_apply_header(table, header);
 
-        for(auto& o : table->objects) {
-            o->save_state();
-        }
+    return table_finish(pb, table);
+}
+}
 
-    } while(false);
+bool table_json_read(
+    JsonReadCallback read,
+    void* read_ctx,
+    Pb0Header* header,
+    Pb0RecordCallback cb,
+    void* ctx) {
+    TableJsonListener listener(header, cb, ctx);
+    return json_stream_parse(read, read_ctx, listener);
+}
 
-    if(!table->sm.validate(pb->text, 256)) {
-        FURI_LOG_E(TAG, "Signal validation failed!");
-        delete table;
-        table = NULL;
-    }
+Table* table_load_table_from_file(PinballApp* pb, size_t index) {
+    auto& tmi = pb->table_list.menu_items[index];
+    const char* path = furi_string_get_cstr(tmi.filename);
 
-    nx_json_free(json);
-    free(json_buffer);
+    char ext[8];
+    path_extract_extension(tmi.filename, ext, sizeof(ext));
 
+    load_profile_begin(&pb->load_profile);
+    Table* table = !strcmp(ext, ".pb0") ? table_load_table_from_pb0(pb, path) :
+                                          table_load_table_from_json(pb, path);
+    load_profile_end();
+    load_profile_log(&pb->load_profile, furi_string_get_cstr(tmi.name));
     return table;
 }
@@ -7,10 +7,98 @@
 Vec2 Vec2_closest(const Vec2& a, const Vec2& b, const Vec2& p) {
     // vector along line ab
     Vec2 ab = b - a;
+#ifdef PINBALL_FIXED_POINT
+    // ab.dot(ab) overflows Q16.16 for segments longer than ~180 units, so
+    // project onto the unit direction instead
+    Scalar len = ab.mag();
+    if(len == 0) {
+        return a;
+    }
+    Vec2 u = ab / len;
+    Scalar t = fmax(Scalar(0), fmin(len, (p - a).dot(u)));
+    return a + u * t;
+#else
     float t = ab.dot(ab);
     if(t == 0.0f) {
         return a;
     }
     t = fmax(0.0f, fmin(1.0f, (p.dot(ab) - a.dot(ab)) / t));
     return a + ab * t;
+#endif
+}
+
+// The sweep works in distances along the unit direction u of travel rather than
+// in squared lengths, so that every intermediate stays within a few hundred
+// units and the same code is safe in fixed point.
+
+// Distance s <= len along u at which p0 comes within r of c, for p0 outside that circle
+static bool sweep_circle(
+    const Vec2& c,
+    Scalar r,
+    const Vec2& p0,
+    const Vec2& u,
+    Scalar len,
+    Scalar& s) {
+    Vec2 m = p0 - c;
+    Scalar b = m.dot(u);
+    if(b >= 0) {
+        return false; // moving away
+    }
+    Scalar h = m.cross(u); // distance from c to the line of travel
+    if(fabsf(h) >= r) {
+        return false;
+    }
+    s = -b - sqrtf(r * r - h * h);
+    return s <= len;
+}
+
+bool Vec2_sweep_capsule(
+    const Vec2& a,
+    const Vec2& b,
+    Scalar r,
+    const Vec2& p0,
+    const Vec2& p1,
+    Scalar& t) {
+    if(Vec2_closest(a, b, p0).dist2(p0) <= r * r) {
+        return false;
+    }
+    Vec2 d = p1 - p0;
+    Scalar len = d.mag();
+    if(len <= VEC2_EPSILON) {
+        return false;
+    }
+    Vec2 u = d / len;
+    Scalar best = len + 1;
+    Scalar s;
+
+    // flat sides: the lines parallel to ab, r away
+    Vec2 ab = b - a;
+    Scalar ab_len = ab.mag();
+    if(ab_len > VEC2_EPSILON) {
+        Vec2 abu = ab / ab_len;
+        Vec2 n(-abu.y, abu.x);
+        Scalar s0 = (p0 - a).dot(n);
+        Scalar ds = u.dot(n);
+        if(s0 * ds < 0) {
+            s = ((s0 > 0 ? r : -r) - s0) / ds;
+            if(s >= 0 && s <= len) {
+                Scalar along = (p0 + u * s - a).dot(abu);
+                if(along >= 0 && along <= ab_len) {
+                    best = s;
+                }
+            }
+        }
+    }
+    // rounded ends
+    if(sweep_circle(a, r, p0, u, len, s) && s < best) {
+        best = s;
+    }
+    if(sweep_circle(b, r, p0, u, len, s) && s < best) {
+        best = s;
+    }
+    if(best > len) {
+        return false;
+    }
+    t = best / len;
+    return true;
 }
@@ -1,102 +1,139 @@
 #pragma once
 #include <stdbool.h>
 #include <cmath>
+#include "fixed.h"
 
 #define VEC2_EPSILON (float)0.001
 
-class Vec2 {
+// The scalar type of all physics state. Build with PINBALL_FIXED_POINT for a
+// deterministic, FPU-free Q16.16 solver.
+// #define PINBALL_FIXED_POINT
+#ifdef PINBALL_FIXED_POINT
+typedef Fixed Scalar;
+#else
+typedef float Scalar;
+#endif
+
+inline float vec2_hypot(float x, float y) {
+    return sqrtf(x * x + y * y);
+}
+// x /= len, y /= len. Float multiplies by the reciprocal instead, while Fixed
+// can't: 1 / len loses most of its bits once len is more than a few units.
+inline void vec2_div(float& x, float& y, float len) {
+    float inverse_len = 1.0f / len;
+    x *= inverse_len;
+    y *= inverse_len;
+}
+inline void vec2_div(Fixed& x, Fixed& y, Fixed len) {
+    x /= len;
+    y /= len;
+}
+
+template <typename T>
+class Vec2T {
 public:
-    float x;
-    float y;
+    T x;
+    T y;
 
-    Vec2()
+    Vec2T()
         : x(0)
         , y(0) {
     }
-    Vec2(float x_, float y_)
+    Vec2T(T x_, T y_)
         : x(x_)
         , y(y_) {
     }
 
-    Vec2 operator+(const Vec2& rhs) const {
-        return Vec2(x + rhs.x, y + rhs.y);
+    Vec2T operator+(const Vec2T& rhs) const {
+        return Vec2T(x + rhs.x, y + rhs.y);
     }
-    Vec2 operator+(float s) const {
-        return Vec2(x + s, y + s);
+    Vec2T operator+(T s) const {
+        return Vec2T(x + s, y + s);
     }
-    void operator+=(const Vec2& rhs) {
+    void operator+=(const Vec2T& rhs) {
         x += rhs.x;
         y += rhs.y;
     }
-    Vec2 operator-(const Vec2& rhs) const {
-        return Vec2(x - rhs.x, y - rhs.y);
+    Vec2T operator-(const Vec2T& rhs) const {
+        return Vec2T(x - rhs.x, y - rhs.y);
     }
-    Vec2 operator-(float s) const {
-        return Vec2(x - s, y - s);
+    Vec2T operator-(T s) const {
+        return Vec2T(x - s, y - s);
     }
-    void operator-=(const Vec2& rhs) {
+    void operator-=(const Vec2T& rhs) {
         x -= rhs.x;
         y -= rhs.y;
     }
-    Vec2 operator*(float s) const {
-        return Vec2(x * s, y * s);
+    Vec2T operator*(T s) const {
+        return Vec2T(x * s, y * s);
     }
-    void operator*=(float s) {
+    void operator*=(T s) {
         x *= s;
         y *= s;
     }
 
-    Vec2 operator/(float s) const {
-        return Vec2(x / s, y / s);
+    Vec2T operator/(T s) const {
+        return Vec2T(x / s, y / s);
     }
 
-    bool operator==(const Vec2& rhs) const {
+    bool operator==(const Vec2T& rhs) const {
         return x == rhs.x && y == rhs.y;
     }
 
     // Magnitude / length of vector
-    float mag() const {
-        return sqrtf(x * x + y * y);
+    T mag() const {
+        return vec2_hypot(x, y);
     }
     // Magnitude squared
-    float mag2() const {
+    T mag2() const {
         return x * x + y * y;
     }
 
     // Dot product: this.x * v.x + this.y * v.y
-    float dot(const Vec2& v) const {
+    T dot(const Vec2T& v) const {
         return x * v.x + y * v.y;
     }
 
     // Cross product
-    float cross(const Vec2& v) const {
+    T cross(const Vec2T& v) const {
         return x * v.y - y * v.x;
     }
 
     void normalize(void) {
-        float len = mag();
+        T len = mag();
         if(len > VEC2_EPSILON) {
-            float inverse_len = 1.0f / len;
-            x *= inverse_len;
-            y *= inverse_len;
+            vec2_div(x, y, len);
         }
     }
 
     // Distance squared between this and next
-    float dist2(const Vec2& v) const {
-        float dx = x - v.x;
-        float dy = y - v.y;
+    T dist2(const Vec2T& v) const {
+        T dx = x - v.x;
+        T dy = y - v.y;
         return dx * dx + dy * dy;
     }
     // Distance between tihs and next
-    float dist(const Vec2& v) const {
-        return sqrtf(dist2(v));
+    T dist(const Vec2T& v) const {
+        return vec2_hypot(x - v.x, y - v.y);
+    }
+
+    friend Vec2T operator*(T s, const Vec2T& v) {
+        return Vec2T(s * v.x, s * v.y);
     }
 };
 
-inline Vec2 operator*(float s, const Vec2& v) {
-    return Vec2(s * v.x, s * v.y);
-}
+typedef Vec2T<Scalar> Vec2;
 
 // // Returns the closest point to the line segment ab and p
 Vec2 Vec2_closest(const Vec2& a, const Vec2& b, const Vec2& p);
+
+// Sweeps a point from p0 to p1 against the capsule of radius r around segment ab.
+// Returns true if the point enters the capsule, with t in [0,1] being the time of
+// impact along p0 -> p1. A point that starts inside the capsule is not a hit.
+bool Vec2_sweep_capsule(
+    const Vec2& a,
+    const Vec2& b,
+    Scalar r,
+    const Vec2& p0,
+    const Vec2& p1,
+    Scalar& t);